@@ -0,0 +1,417 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <core/core.h>
+#include <core/jit.h>
+#include <sled/error.h>
+#include <sled/riscv/csr.h>
+
+#include "test.h"
+
+// Block tests: decoded blocks, fused pairs and compiled code.
+
+#define NOMAP_ADDR  0x40000000u     // nothing is mapped here
+
+typedef void (*load_fn_t)(prog_t *p, u1 rd, u1 rs1, i4 imm);
+
+// Split the offset from the next instruction to addr for an auipc pair.
+static void pc_rel(prog_t *p, u4 addr, u4 *hi, i4 *lo) {
+    const u4 off = addr - (PLAT_MEM_BASE + (prog_here(p) * 4));
+    *lo = off & 0xfff;
+    if (*lo >= 0x800) *lo -= 0x1000;
+    *hi = ((off - (u4)*lo) >> 12) & 0xfffff;
+}
+
+// Load from addr into rd with a pc relative auipc and load pair.
+static void load_pc_rel(prog_t *p, load_fn_t ld, u1 rd, u4 addr) {
+    u4 hi;
+    i4 lo;
+    pc_rel(p, addr, &hi, &lo);
+    auipc(p, rd, hi);
+    ld(p, rd, rd, lo);
+}
+
+// Every way of a 4 way dcache set, and two pages more that map to the same set
+// of the 2 set cache the program runs with.
+static u4 alias_page(u4 i) {
+    return DATA_BASE + (i * 0x2000);
+}
+
+// A loop of alu ops, loads, stores and branches over more registers than the
+// jit keeps in host registers. Its data pages alias in the dcache, so hits are
+// found in every way and the pseudo-LRU picks the victims. Each pass ends with
+// a pc relative load that faults, which leaves compiled code to finish the
+// block interpreted.
+static void test_jit_program(prog_t *p) {
+    set_trap_handler(p);
+    li(p, S1, 0);                       // faults taken
+    li(p, S2, 300);                     // passes
+    li(p, A0, 0x12345678);
+    li(p, A1, 0x9abcdef0);
+    li(p, A2, 7);
+    li(p, A3, 0);
+    li(p, A4, 0);
+    li(p, A5, 0);
+    li(p, A6, 0);
+    li(p, A7, 0);
+    li(p, S3, 0);
+    li(p, S4, 0);
+
+    const u4 top = prog_here(p);
+    add(p, A0, A0, S2);
+    xor(p, A1, A1, A0);
+    slli(p, A3, A0, 3);
+    srli(p, A4, A1, 5);
+    srai(p, A5, A1, 7);
+    sub(p, A6, A3, A4);
+    or(p, A7, A6, A5);
+    and(p, S3, A7, A0);
+    sll(p, S4, A0, A2);
+    srl(p, T3, A1, A2);
+    sra(p, T4, A1, A2);
+    slt(p, T0, A5, A6);
+    sltu(p, T1, A5, A6);
+    add(p, S4, S4, T0);
+    add(p, T3, T3, T1);
+    li(p, T0, 0xfff00);
+    add(p, A0, A0, T0);
+
+    for (u4 i = 0; i < 6; i++) {
+        li(p, S0, alias_page(i) + (i * 8));
+        sw(p, A0, S0, 0);
+        sh(p, A1, S0, 4);
+        sb(p, A6, S0, 6);
+        lw(p, T0, S0, 0);
+        lh(p, T1, S0, 4);
+        lhu(p, T2, S0, 4);
+        lb(p, A3, S0, 6);
+        lbu(p, A4, S0, 7);
+        add(p, A5, A5, T0);
+        xor(p, A5, A5, T1);
+        add(p, A6, A6, T2);
+        sub(p, A7, A7, A3);
+        add(p, S3, S3, A4);
+    }
+
+    const u4 skip1 = prog_here(p) + 2;
+    blt(p, A5, A6, skip1);
+    addi(p, S3, S3, 1);
+    const u4 skip2 = prog_here(p) + 2;
+    bgeu(p, A5, A6, skip2);
+    addi(p, S4, S4, 3);
+    const u4 skip3 = prog_here(p) + 2;
+    bge(p, A7, ZERO, skip3);
+    addi(p, T3, T3, 5);
+    const u4 skip4 = prog_here(p) + 2;
+    bltu(p, A0, A1, skip4);
+    addi(p, T4, T4, 9);
+
+    load_pc_rel(p, lw, T0, NOMAP_ADDR);     // faults, skipped by the handler
+    addi(p, S2, S2, -1);
+    bne(p, S2, ZERO, top);
+    prog_exit(p, 0);
+
+    prog_org(p, HANDLER_INDEX);
+    addi(p, S1, S1, 1);
+    skip_trap(p);
+}
+
+static void setup_jit(sl_core_params_t *params) {
+    params->dcache.sets = 2;
+    params->dcache.ways = 4;
+}
+
+typedef struct {
+    u8 r[32];
+    u8 pc;
+    u4 data[6][4];
+    u8 dcache_base[8];
+    u1 dcache_plru[2];
+    sl_jit_stats_t stats;
+} jit_result_t;
+
+#define JIT_OFF     0
+#define JIT_ON      1
+#define JIT_SMALL   2   // an arena that fills after a few blocks
+
+#if WITH_JIT && __linux__
+// The arena must never be writable and executable at once.
+static int check_no_wx(const test_t *t) {
+    FILE *f = fopen("/proc/self/maps", "r");
+    if (f == NULL) return 0;
+    char line[512];
+    int err = 0;
+    while (!err && (fgets(line, sizeof(line), f) != NULL)) {
+        char perms[8];
+        if ((sscanf(line, "%*s %7s", perms) == 1) && (perms[1] == 'w') && (perms[2] == 'x'))
+            err = test_fail(t, "writable executable mapping %s", line);
+    }
+    fclose(f);
+    return err;
+}
+#endif
+
+static int jit_run(const test_t *t, const prog_t *p, u4 mode, jit_result_t *res) {
+    sl_machine_t *m;
+    int err;
+
+    memset(res, 0, sizeof(*res));
+    if ((err = test_machine_create(t, p, &m))) return err;
+    sl_core_t *c = sl_machine_get_core(m, 0);
+#if WITH_JIT
+    if (c->jit != NULL) {
+        sl_jit_destroy(c->jit);
+        c->jit = NULL;
+    }
+    if ((mode != JIT_OFF) && (err = sl_jit_create(&c->jit, (mode == JIT_SMALL) ? JIT_BLOCK_RESERVE + 4096 : JIT_ARENA_SIZE)))
+        goto out;
+#endif
+    if ((err = test_machine_run(t, m))) goto out;
+#if WITH_JIT && __linux__
+    if ((mode != JIT_OFF) && (err = check_no_wx(t))) goto out;
+#endif
+
+    for (u4 i = 0; i < 32; i++) res->r[i] = sl_core_get_reg(c, i);
+    res->pc = sl_core_get_reg(c, SL_CORE_REG_PC);
+    for (u4 i = 0; i < 8; i++) res->dcache_base[i] = c->dcache.page[i].base;
+    res->dcache_plru[0] = c->dcache.page[0].plru;
+    res->dcache_plru[1] = c->dcache.page[4].plru;
+#if WITH_JIT
+    if (c->jit != NULL) sl_jit_get_stats(c->jit, &res->stats);
+#endif
+    for (u4 i = 0; (i < 6) && !err; i++)
+        err = sl_core_mem_read(c, alias_page(i), 4, 4, res->data[i]);
+
+out:
+    sl_machine_destroy(m);
+    return err;
+}
+
+static int jit_compare(const test_t *t, const jit_result_t *a, const jit_result_t *b, const char *what) {
+    for (u4 i = 0; i < 32; i++) {
+        if (a->r[i] != b->r[i])
+            return test_fail(t, "%s: x%u is %#" PRIx64 ", expected %#" PRIx64, what, i, b->r[i], a->r[i]);
+    }
+    if (a->pc != b->pc) return test_fail(t, "%s: pc differs", what);
+    if (memcmp(a->data, b->data, sizeof(a->data))) return test_fail(t, "%s: memory differs", what);
+    if (memcmp(a->dcache_base, b->dcache_base, sizeof(a->dcache_base)) ||
+        memcmp(a->dcache_plru, b->dcache_plru, sizeof(a->dcache_plru)))
+        return test_fail(t, "%s: dcache ways or pseudo-LRU state differ", what);
+    return 0;
+}
+
+
+// The same program gives the same registers, memory and dcache state run
+// interpreted and compiled, including when the arena fills up.
+static int run_jit_compare(const test_t *t) {
+    static prog_t p;
+    static jit_result_t res[3];
+    int err;
+
+    prog_init(&p);
+    test_jit_program(&p);
+    for (u4 mode = JIT_OFF; mode <= JIT_SMALL; mode++) {
+        if ((err = jit_run(t, &p, mode, &res[mode]))) return err;
+    }
+    if (res[JIT_OFF].r[S1] != 300)
+        return test_fail(t, "%" PRIu64 " faults taken, expected 300", res[JIT_OFF].r[S1]);
+    if ((err = jit_compare(t, &res[JIT_OFF], &res[JIT_ON], "jit"))) return err;
+    if ((err = jit_compare(t, &res[JIT_OFF], &res[JIT_SMALL], "small arena"))) return err;
+
+#if WITH_JIT
+    if ((res[JIT_ON].stats.compiled == 0) || (res[JIT_ON].stats.flushes != 0))
+        return test_fail(t, "%" PRIu64 " blocks compiled, %" PRIu64 " flushes",
+            res[JIT_ON].stats.compiled, res[JIT_ON].stats.flushes);
+    if ((res[JIT_SMALL].stats.flushes == 0) || (res[JIT_SMALL].stats.compiled <= res[JIT_ON].stats.compiled))
+        return test_fail(t, "small arena: %" PRIu64 " blocks compiled, %" PRIu64 " flushes",
+            res[JIT_SMALL].stats.compiled, res[JIT_SMALL].stats.flushes);
+#endif
+    return 0;
+}
+
+#define FUSE_FUNC       0x200   // instruction index of the called function
+#define FUSE_PAGE_END   0x3ff   // last instruction of the first page
+#define FUSE_MAX_PAIRS  16
+
+// Instruction indices of the pairs that must and must not be fused.
+static u4 fused_at[FUSE_MAX_PAIRS], fused_num;
+static u4 unfused_at[FUSE_MAX_PAIRS], unfused_num;
+
+static void mark_pair(prog_t *p, bool fused) {
+    if (fused) fused_at[fused_num++] = prog_here(p);
+    else unfused_at[unfused_num++] = prog_here(p);
+}
+
+// Every kind of fused pair gives the same results as its two instructions, and
+// pairs that don't qualify are left alone: registers that differ, a second
+// instruction that is a branch target, and pairs across the end of a page or
+// of the longest block.
+static void test_fusion(prog_t *p) {
+    u4 hi;
+    i4 lo;
+
+    fused_num = unfused_num = 0;
+    li(p, A2, DATA_BASE);
+    reg_write(p, 0, 0x12345680);
+
+    mark_pair(p, true);
+    li(p, A0, 0x89abcdef);                          // lui + addi
+    prog_check(p, A0, 0x89abcdef);
+
+    mark_pair(p, true);
+    const u4 adr = prog_here(p);
+    auipc(p, A1, 1);                                // auipc + addi
+    addi(p, A1, A1, -4);
+    prog_check(p, A1, PLAT_MEM_BASE + (adr * 4) + 0xffc);
+
+    mark_pair(p, true);
+    const u4 call = prog_here(p);
+    pc_rel(p, PLAT_MEM_BASE + (FUSE_FUNC * 4), &hi, &lo);
+    auipc(p, RA, hi);                               // auipc + jalr
+    jalr(p, RA, RA, lo);
+    prog_check(p, RA, PLAT_MEM_BASE + ((call + 2) * 4));
+    prog_check(p, A3, 77);
+
+    mark_pair(p, true);
+    load_pc_rel(p, lw, A3, DATA_BASE);              // auipc + loads
+    prog_check(p, A3, 0x12345680);
+    mark_pair(p, true);
+    load_pc_rel(p, lb, A3, DATA_BASE);
+    prog_check(p, A3, 0xffffff80);
+    mark_pair(p, true);
+    load_pc_rel(p, lhu, A3, DATA_BASE + 2);
+    prog_check(p, A3, 0x1234);
+
+    li(p, A4, 0xdeadbeef);
+    mark_pair(p, true);
+    slli(p, A4, A4, 16);                            // slli + srli
+    srli(p, A4, A4, 16);
+    prog_check(p, A4, 0xbeef);
+    li(p, A4, 0xdeadbeef);
+    mark_pair(p, false);
+    slli(p, A4, A4, 8);                             // shifts differ
+    srli(p, A4, A4, 16);
+    prog_check(p, A4, 0xadbe);
+
+    mark_pair(p, false);
+    lui(p, A5, 1);                                  // rd isn't rs1 of the second
+    addi(p, A6, A5, 1);
+    prog_check(p, A5, 0x1000);
+    prog_check(p, A6, 0x1001);
+    mark_pair(p, false);
+    lui(p, A5, 2);                                  // rs1 isn't rd of the first
+    addi(p, A5, A6, 3);
+    prog_check(p, A5, 0x1004);
+
+    // Enter the pair at its second instruction first, then run it whole.
+    li(p, S1, 0);
+    li(p, S6, 0);
+    li(p, A7, 100);
+    const u4 mid = prog_here(p);
+    jal(p, ZERO, mid + 2);
+    mark_pair(p, true);
+    lui(p, A7, 3);
+    addi(p, A7, A7, 5);
+    add(p, S6, S6, A7);
+    addi(p, S1, S1, 1);
+    addi(p, T0, ZERO, 2);
+    bne(p, S1, T0, mid + 1);
+    prog_check(p, S6, 105 + 0x3005);
+
+    // A block of the most instructions ends before a pair that doesn't fit.
+    li(p, S3, 0);
+    for (u4 i = 0; i < 63; i++) addi(p, S3, S3, 1);
+    mark_pair(p, true);
+    li(p, S4, 0x7654321);
+    prog_check(p, S3, 63);
+    prog_check(p, S4, 0x7654321);
+    jal(p, ZERO, FUSE_PAGE_END);
+
+    prog_org(p, FUSE_FUNC);
+    addi(p, A3, ZERO, 77);
+    jalr(p, ZERO, RA, 0);
+
+    prog_org(p, FUSE_PAGE_END);
+    mark_pair(p, false);
+    lui(p, S5, 4);                                  // across the end of the page
+    addi(p, S5, S5, 6);
+    prog_check(p, S5, 0x4006);
+    prog_exit(p, 0);
+}
+
+#if !SLAC_TRACE
+static bool slot_fused(sl_core_t *c, u4 index) {
+    const u8 addr = PLAT_MEM_BASE + (index * 4);
+    const u1 shift = c->icache.page_shift;
+    sl_cache_page_t *pg = sl_cache_find_page(&c->icache, addr >> shift);
+    if (pg == NULL) return false;
+    return pg->decoded[(addr & ((1u << shift) - 1)) / 2].fused != 0;
+}
+#endif
+
+static int check_fusion(const test_t *t, sl_machine_t *m) {
+#if !SLAC_TRACE
+    sl_core_t *c = sl_machine_get_core(m, 0);
+    for (u4 i = 0; i < fused_num; i++) {
+        if (!slot_fused(c, fused_at[i]))
+            return test_fail(t, "pair at %#x not fused", fused_at[i]);
+    }
+    for (u4 i = 0; i < unfused_num; i++) {
+        if (slot_fused(c, unfused_at[i]))
+            return test_fail(t, "pair at %#x fused", unfused_at[i]);
+    }
+#endif
+    return 0;
+}
+
+#define CHAIN_SHIFT     8       // smallest icache page, 64 instructions
+#define CHAIN_FUNC_B    64      // instruction index of a function in page 1
+#define CHAIN_FUNC_C    128     // and of one in page 2
+
+// A loop calling into two other pages, run with an icache of one page and a
+// decoded page store of two. Every call and return replaces the cached page
+// and reuses a store entry, so a chained target is only good if its page is
+// checked when the chain is followed.
+static void test_chain_evict(prog_t *p) {
+    li(p, S1, 0);
+    li(p, S2, 1000);
+    const u4 top = prog_here(p);
+    jal(p, RA, CHAIN_FUNC_B);
+    jal(p, RA, CHAIN_FUNC_C);
+    addi(p, S2, S2, -1);
+    bne(p, S2, ZERO, top);
+    prog_check(p, S1, 1000 * 8);
+    prog_exit(p, 0);
+
+    prog_org(p, CHAIN_FUNC_B);
+    addi(p, S1, S1, 3);
+    jalr(p, ZERO, RA, 0);
+
+    prog_org(p, CHAIN_FUNC_C);
+    addi(p, S1, S1, 5);
+    jalr(p, ZERO, RA, 0);
+}
+
+static void setup_chain_evict(sl_core_params_t *params) {
+    const u8 slots = 1u << (CHAIN_SHIFT - 1);
+    u8 page_bytes = slots * sizeof(sl_slac_inst_t);
+#if SLAC_TRACE
+    page_bytes += slots * sizeof(sl_slac_desc_t);
+#endif
+    params->icache.sets = 1;
+    params->icache.ways = 1;
+    params->icache.page_shift = CHAIN_SHIFT;
+    params->decode_budget = 2 * page_bytes;
+}
+
+const test_t block_tests[] = {
+    { .name = "chain_evict", .build = test_chain_evict, .setup = setup_chain_evict },
+    { .name = "fusion", .build = test_fusion, .check = check_fusion },
+    { .name = "jit_compare", .setup = setup_jit, .run = run_jit_compare },
+    {},
+};
@@ -0,0 +1,20 @@
+APPPATH := app/$(APP)
+
+$(APP)_PLATFORM := simple
+
+$(APP)_INCLUDES += -I$(APPPATH)/inc -I$(BUILDDIR)/app/$(APP)
+# unit tests of core internals
+$(APP)_INCLUDES += -Icore/inc
+
+$(APP)_CSOURCES := \
+	$(APPPATH)/block.c \
+	$(APPPATH)/cache.c \
+	$(APPPATH)/dev.c \
+	$(APPPATH)/fp.c \
+	$(APPPATH)/machine.c \
+	$(APPPATH)/main.c \
+	$(APPPATH)/mapper.c \
+	$(APPPATH)/mem.c \
+	$(APPPATH)/prog.c \
+
+$(APP)_CXXSOURCES := \
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include <core/cache.h>
+#include <sled/error.h>
+
+#include "test.h"
+
+// Cache tests, run on caches of their own outside a core.
+
+#define PAGE_SHIFT  12
+#define PAGE_SLOTS  (1u << (PAGE_SHIFT - 1))
+
+// Fill a page buffer with halfwords that tell apart the page and the slot.
+static u2 *code_page(u4 page) {
+    u2 *buf = malloc((PAGE_SLOTS + 2) * sizeof(u2));
+    if (buf == NULL) return NULL;
+    for (u4 i = 0; i < PAGE_SLOTS + 2; i++)
+        buf[i] = (page << 12) | (i & 0xfff);
+    return buf;
+}
+
+// Decoded instructions take 16 bytes each, with nothing else in the page
+// outside trace builds, and the machine op is read from the page.
+static int run_slot_layout(const test_t *t) {
+    const sl_cache_geometry_t g = { .page_shift = PAGE_SHIFT };
+    u2 *buf[2] = { code_page(1), code_page(2) };
+    sl_cache_t ic;
+    int err;
+
+    if ((buf[0] == NULL) || (buf[1] == NULL)) {
+        err = SL_ERR_MEM;
+        goto out_free;
+    }
+    if ((err = sl_cache_init(&ic, SL_CACHE_TYPE_INSTRUCTION, &g, 0))) goto out_free;
+
+    u8 page_bytes = PAGE_SLOTS * 16;
+#if SLAC_TRACE
+    page_bytes += PAGE_SLOTS * sizeof(sl_slac_desc_t);
+#endif
+    if ((sizeof(sl_slac_inst_t) != 16) || (ic.dpage_bytes != page_bytes)) {
+        err = test_fail(t, "%zu byte slots, %zu per page", sizeof(sl_slac_inst_t), (usize)ic.dpage_bytes);
+        goto out;
+    }
+
+    for (u4 p = 0; p < 2; p++) {
+        // only the second page can read past its end
+        if ((err = sl_cache_set_instruction_page(&ic, (u8)(p + 1) << PAGE_SHIFT, buf[p], p == 1))) goto out;
+        sl_cache_page_t *pg = sl_cache_find_page(&ic, p + 1);
+        if (pg == NULL) {
+            err = test_fail(t, "page %u not cached", p + 1);
+            goto out;
+        }
+#if SLAC_TRACE
+        if ((uptr)pg->decoded & ic.dalign_mask) {
+            err = test_fail(t, "page %u misaligned", p + 1);
+            goto out;
+        }
+#endif
+        for (u4 i = 0; i < PAGE_SLOTS; i++) {
+            sl_slac_inst_t *si = sl_cache_get_slot(&ic, pg, i);
+            if ((si != &pg->decoded[i]) || (si->fill != pg->fill) || (si->raw != SLAC_IN_INVALID)) {
+                err = test_fail(t, "page %u slot %u not reset in place", p + 1, i);
+                goto out;
+            }
+#if SLAC_TRACE
+            if ((uptr)sl_cache_desc(&ic, si) != (uptr)pg->decoded + ic.desc_ext + (i * sizeof(sl_slac_desc_t))) {
+                err = test_fail(t, "page %u slot %u description misplaced", p + 1, i);
+                goto out;
+            }
+#endif
+            u4 op = buf[p][i] | ((u4)buf[p][i + 1] << 16);
+            if ((i == PAGE_SLOTS - 1) && (p == 0)) op &= 0xffff;
+            if (sl_cache_machine_op(&ic, pg, i) != op) {
+                err = test_fail(t, "page %u slot %u machine op %#x, expected %#x",
+                    p + 1, i, sl_cache_machine_op(&ic, pg, i), op);
+                goto out;
+            }
+        }
+    }
+
+out:
+    sl_cache_shutdown(&ic);
+out_free:
+    free(buf[0]);
+    free(buf[1]);
+    return err;
+}
+
+static int expect_store(const test_t *t, const sl_cache_geometry_t *g, u8 budget, u4 entries) {
+    sl_cache_t ic;
+    int err = sl_cache_init(&ic, SL_CACHE_TYPE_INSTRUCTION, g, budget);
+    if (err) return test_fail(t, "budget %#" PRIx64 ": %s", budget, st_err(err));
+    if (ic.dpage_num != entries)
+        err = test_fail(t, "budget %#" PRIx64 ": %u store entries, expected %u", budget, ic.dpage_num, entries);
+    sl_cache_shutdown(&ic);
+    return err;
+}
+
+// The decoded page store holds as many pages as fit in the budget, and no
+// fewer than one more than the cache. Filling more pages than that reuses
+// entries rather than allocating.
+static int run_decode_budget(const test_t *t) {
+    const sl_cache_geometry_t small = { .sets = 4, .page_shift = PAGE_SHIFT };
+    const sl_cache_geometry_t large = { .sets = 256, .ways = 4, .page_shift = PAGE_SHIFT };
+    const sl_cache_geometry_t dflt = { .page_shift = PAGE_SHIFT };
+    const u4 fills = 24;
+    sl_cache_t ic;
+    int err;
+
+    if ((err = sl_cache_init(&ic, SL_CACHE_TYPE_INSTRUCTION, &dflt, 0))) return err;
+    const u8 page_bytes = ic.dpage_bytes;
+    sl_cache_shutdown(&ic);
+
+    u4 dflt_entries = SL_CACHE_DEFAULT_DECODE_BUDGET / page_bytes;
+    if (dflt_entries < 65) dflt_entries = 65;
+    if ((err = expect_store(t, &dflt, 0, dflt_entries))) return err;
+    if ((err = expect_store(t, &dflt, (100 * page_bytes) + 10, 100))) return err;
+    if ((err = expect_store(t, &dflt, 65 * page_bytes, 65))) return err;
+    if ((err = expect_store(t, &large, 0, 1025))) return err;
+    if (sl_cache_init(&ic, SL_CACHE_TYPE_INSTRUCTION, &dflt, 64 * page_bytes) != SL_ERR_ARG)
+        return test_fail(t, "budget below the cache size accepted");
+
+    u1 *buf = malloc((fills + 1) << PAGE_SHIFT);
+    if (buf == NULL) return SL_ERR_MEM;
+    if ((err = sl_cache_init(&ic, SL_CACHE_TYPE_INSTRUCTION, &small, 8 * page_bytes))) goto out_free;
+    for (u4 i = 0; i < fills; i++) {
+        if ((err = sl_cache_set_instruction_page(&ic, (u8)i << PAGE_SHIFT, buf + ((usize)i << PAGE_SHIFT), true)))
+            goto out;
+    }
+    u4 allocated = 0;
+    for (u4 i = 0; i < ic.dpage_num; i++)
+        if (ic.dpage[i].decoded != NULL) allocated++;
+    if ((ic.dpage_num != 8) || (allocated != 8) || (ic.decode_miss != fills))
+        err = test_fail(t, "%u of %u entries allocated for %" PRIu64 " misses", allocated, ic.dpage_num, ic.decode_miss);
+    for (u4 i = fills - 4; !err && (i < fills); i++) {
+        if (sl_cache_find_page(&ic, i) == NULL)
+            err = test_fail(t, "page %u not cached", i);
+    }
+
+out:
+    sl_cache_shutdown(&ic);
+out_free:
+    free(buf);
+    return err;
+}
+
+const test_t cache_tests[] = {
+    { .name = "cache_slot_layout", .run = run_slot_layout },
+    { .name = "cache_decode_budget", .run = run_decode_budget },
+    {},
+};
@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#include <inttypes.h>
+
+#include <core/core.h>
+#include <device/sled/dma.h>
+#include <device/sled/intc.h>
+#include <device/sled/mpu.h>
+#include <device/sled/timer.h>
+#include <sled/riscv.h>
+#include <sled/riscv/csr.h>
+
+#include "test.h"
+
+// Device tests: the MPU, interrupt routing and DMA.
+
+static void mpu_map(prog_t *p, u4 i, u4 base, u4 len, u4 deny) {
+    reg_write(p, MPU_REG_MAP_VA_BASE_LO(i), base);
+    reg_write(p, MPU_REG_MAP_PA_BASE_LO(i), base);
+    reg_write(p, MPU_REG_MAP_LEN(i), len);
+    reg_write(p, MPU_REG_MAP_DENY(i), deny);
+}
+
+// Stores to a page the core already holds as writable must fault once the
+// MPU has made the page read-only.
+static void test_mpu_deny_write(prog_t *p) {
+    set_trap_handler(p);
+    li(p, S1, 0);                       // faults taken
+    li(p, S0, DATA_BASE);
+    li(p, T1, 0x11);
+    sw(p, T1, S0, 0);
+    lw(p, T1, S0, 0);
+    prog_check(p, T1, 0x11);
+
+    li(p, A2, PLAT_MPU_BASE);
+    mpu_map(p, 0, PLAT_MEM_BASE, DATA_BASE - PLAT_MEM_BASE, 0);
+    mpu_map(p, 1, DATA_BASE, 0x1000, MPU_DENY_WRITE);
+    reg_write(p, MPU_REG_CONFIG, MPU_CONFIG_ENABLE | MPU_CONFIG_APPLY);
+
+    li(p, T1, 0x22);
+    sw(p, T1, S0, 0);                   // skipped by the handler
+    prog_check(p, S1, 1);
+    lw(p, T1, S0, 0);
+    prog_check(p, T1, 0x11);
+    prog_exit(p, 0);
+
+    prog_org(p, HANDLER_INDEX);
+    csrrs(p, T1, RV_CSR_MCAUSE, ZERO);
+    prog_check(p, T1, RV_EX_STORE_FAULT);
+    addi(p, S1, S1, 1);
+    skip_trap(p);
+}
+
+#define REMAPS  32
+
+// Each write to the MPU config replaces its table. The core drops its cached
+// pages, but refills them from the decoded page store instead of decoding the
+// code again.
+static void test_mpu_keep_decode(prog_t *p) {
+    li(p, A2, PLAT_MPU_BASE);
+    li(p, S1, REMAPS);
+    const u4 top = prog_here(p);
+    sw(p, ZERO, A2, MPU_REG_CONFIG);
+    addi(p, S1, S1, -1);
+    bne(p, S1, ZERO, top);
+    prog_exit(p, 0);
+}
+
+static int check_mpu_keep_decode(const test_t *t, sl_machine_t *m) {
+    const sl_cache_t *ic = &sl_machine_get_core(m, 0)->icache;
+    if ((ic->decode_hit < REMAPS) || (ic->decode_miss > 4))
+        return test_fail(t, "%" PRIu64 " decode hits, %" PRIu64 " misses", ic->decode_hit, ic->decode_miss);
+    return 0;
+}
+
+// Send every hart but 'hart' to a loop of its own.
+static void only_hart(prog_t *p, u4 hart) {
+    csrrs(p, S0, RV_CSR_MHARTID, ZERO);
+    li(p, T0, hart);
+    beq(p, S0, T0, prog_here(p) + 2);
+    jal(p, ZERO, prog_here(p));
+}
+
+// An external interrupt routed by the intc to a hart other than 0 is taken
+// by that hart, through its trap vector.
+static void test_irq_hart1(prog_t *p) {
+    only_hart(p, 1);
+    set_trap_handler(p);
+    li(p, S1, 0);                       // interrupts taken
+    enable_ext_irq(p, 1, PLAT_INTC_TIMER_IRQ_BIT);
+
+    li(p, A2, PLAT_TIMER_BASE);
+    reg_write(p, TIMER_IRQ_MASK, ~1u);
+    reg_write(p, TIMER_REG_UNIT_RESET_VAL_LO(0), 100);
+    reg_write(p, TIMER_REG_UNIT_CONFIG(0), TIMER_UNIT_CONFIG_RUN);
+    wait_for_irq(p);
+    prog_exit(p, 0);
+
+    prog_org(p, HANDLER_INDEX);
+    csrrs(p, T1, RV_CSR_MCAUSE, ZERO);
+    prog_check(p, T1, RV_CAUSE32_INT | RV_INT_EXTERNAL_M);
+    addi(p, S1, S1, 1);
+    li(p, A2, PLAT_TIMER_BASE);
+    reg_write(p, TIMER_IRQ_STATUS, 1);
+    li(p, A2, PLAT_INTC_BASE);
+    reg_write(p, INTC_REG_ASSERTED, 1u << PLAT_INTC_TIMER_IRQ_BIT);
+    mret(p);
+}
+
+// With four harts all taking external interrupts, one routed to hart 2 is
+// taken by hart 2 alone. Each hart's handler counts into a word of its own.
+static void test_irq_hart2_of_4(prog_t *p) {
+    set_trap_handler(p);
+    li(p, S1, 0);                       // interrupts taken
+    enable_ext_irq(p, 2, PLAT_INTC_TIMER_IRQ_BIT);
+    only_hart(p, 2);
+
+    li(p, A2, PLAT_TIMER_BASE);
+    reg_write(p, TIMER_IRQ_MASK, ~1u);
+    reg_write(p, TIMER_REG_UNIT_RESET_VAL_LO(0), 100);
+    reg_write(p, TIMER_REG_UNIT_CONFIG(0), TIMER_UNIT_CONFIG_RUN);
+    wait_for_irq(p);
+    li(p, A2, PLAT_TIMER_BASE);
+    reg_write(p, TIMER_REG_UNIT_CONFIG(0), 0);
+
+    // give the other harts time to take anything sent their way
+    li(p, S2, 1000000);
+    const u4 delay = prog_here(p);
+    addi(p, S2, S2, -1);
+    bne(p, S2, ZERO, delay);
+    for (u4 h = 0; h < 4; h++) {
+        li(p, A3, DATA_BASE + (h * 4));
+        lw(p, T1, A3, 0);
+        prog_check(p, T1, (h == 2) ? 1 : 0);
+    }
+    prog_exit(p, 0);
+
+    prog_org(p, HANDLER_INDEX);
+    addi(p, S1, S1, 1);
+    slli(p, T1, S0, 2);
+    li(p, A3, DATA_BASE);
+    add(p, A3, A3, T1);
+    sw(p, S1, A3, 0);
+    li(p, A2, PLAT_TIMER_BASE);
+    reg_write(p, TIMER_IRQ_STATUS, 1);
+    li(p, A2, PLAT_INTC_BASE);
+    reg_write(p, INTC_REG_ASSERTED, 1u << PLAT_INTC_TIMER_IRQ_BIT);
+    mret(p);
+}
+
+// A DMA chain signals completion through the intc and the handler runs.
+static void test_dma_irq(prog_t *p) {
+    const u4 src = DATA_BASE;
+    const u4 dst = DATA_BASE + 0x100;
+    const u4 desc = DATA_BASE + 0x200;
+
+    set_trap_handler(p);
+    li(p, S1, 0);                       // interrupts taken
+    li(p, A2, src);
+    for (u4 i = 0; i < 4; i++) reg_write(p, i * 4, 0x1000 + i);
+    li(p, A2, desc);
+    reg_write(p, DMA_DESC_SRC, src);
+    reg_write(p, DMA_DESC_DST, dst);
+    reg_write(p, DMA_DESC_LEN, 16);
+    enable_ext_irq(p, 0, PLAT_INTC_DMA_IRQ_BIT);
+
+    li(p, A2, PLAT_DMA_BASE);
+    reg_write(p, DMA_IRQ_MASK, ~1u);
+    reg_write(p, DMA_REG_CHAN_DESC_LO(0), desc);
+    reg_write(p, DMA_REG_CHAN_CONFIG(0), DMA_CHAN_CONFIG_RUN);
+    wait_for_irq(p);
+    prog_check(p, S3, DMA_CHAN_CONFIG_DONE);
+    li(p, A2, dst);
+    for (u4 i = 0; i < 4; i++) {
+        lw(p, T1, A2, i * 4);
+        prog_check(p, T1, 0x1000 + i);
+    }
+    prog_exit(p, 0);
+
+    prog_org(p, HANDLER_INDEX);
+    csrrs(p, T1, RV_CSR_MCAUSE, ZERO);
+    prog_check(p, T1, RV_CAUSE32_INT | RV_INT_EXTERNAL_M);
+    addi(p, S1, S1, 1);
+    li(p, A2, PLAT_DMA_BASE);
+    lw(p, S3, A2, DMA_REG_CHAN_CONFIG(0));
+    reg_write(p, DMA_IRQ_STATUS, 1);
+    li(p, A2, PLAT_INTC_BASE);
+    reg_write(p, INTC_REG_ASSERTED, 1u << PLAT_INTC_DMA_IRQ_BIT);
+    mret(p);
+}
+
+#define DMA_FUNC    0x200   // instruction index of the function DMA rewrites
+
+// A DMA copy over code that already ran, and was compiled in jit builds, is
+// seen by the core without an instruction barrier once the copy is done.
+static void test_dma_code_write(prog_t *p) {
+    static prog_t q;
+    const u4 src = DATA_BASE;
+    const u4 desc = DATA_BASE + 0x100;
+
+    li(p, S1, 64);
+    const u4 warm = prog_here(p);
+    jal(p, RA, DMA_FUNC);
+    addi(p, S1, S1, -1);
+    bne(p, S1, ZERO, warm);
+    prog_check(p, A0, 1);
+
+    prog_init(&q);
+    addi(&q, A0, ZERO, 2);
+    li(p, A2, src);
+    reg_write(p, 0, q.inst[0]);
+    li(p, A2, desc);
+    reg_write(p, DMA_DESC_SRC, src);
+    reg_write(p, DMA_DESC_DST, PLAT_MEM_BASE + (DMA_FUNC * 4));
+    reg_write(p, DMA_DESC_LEN, 4);
+    li(p, A2, PLAT_DMA_BASE);
+    reg_write(p, DMA_REG_CHAN_DESC_LO(0), desc);
+    reg_write(p, DMA_REG_CHAN_CONFIG(0), DMA_CHAN_CONFIG_RUN);
+    const u4 poll = prog_here(p);
+    lw(p, T1, A2, DMA_REG_CHAN_CONFIG(0));
+    slli(p, T1, T1, 31);                // DMA_CHAN_CONFIG_RUN
+    bne(p, T1, ZERO, poll);
+
+    jal(p, RA, DMA_FUNC);
+    prog_check(p, A0, 2);
+    prog_exit(p, 0);
+
+    prog_org(p, DMA_FUNC);
+    addi(p, A0, ZERO, 1);
+    jalr(p, ZERO, RA, 0);
+}
+
+const test_t dev_tests[] = {
+    { .name = "mpu_deny_write", .build = test_mpu_deny_write },
+    { .name = "mpu_keep_decode", .build = test_mpu_keep_decode, .check = check_mpu_keep_decode },
+    { .name = "irq_hart1",      .build = test_irq_hart1, .num_cores = 2 },
+    { .name = "irq_hart2_of_4", .build = test_irq_hart2_of_4, .num_cores = 4 },
+    { .name = "dma_irq",        .build = test_dma_irq },
+    { .name = "dma_code_write", .build = test_dma_code_write },
+    {},
+};
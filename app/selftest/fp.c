@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#include <sled/arch.h>
+#include <sled/riscv.h>
+#include <sled/riscv/csr.h>
+
+#include "test.h"
+
+// Floating point tests: rounding modes and exception flags.
+
+#define F_ONE       0x3f800000u     // 1.0
+#define F_QUARTER   0x33000000u     // a quarter of an ulp of 1.0
+#define F_2_5       0x40200000u     // 2.5
+#define F_RM_BAD    5               // reserved rounding mode
+
+static void setup_fp(sl_core_params_t *params) {
+    params->arch_options |= SL_RISCV_EXT_F;
+    // poll often, so the host rounding mode is handed back and set again
+    // many times while the guest runs
+    params->poll_budget = 4;
+}
+
+static void set_frm(prog_t *p, u4 rm) {
+    li(p, T0, rm);
+    csrrw(p, ZERO, RV_CSR_FRM, T0);
+}
+
+// Check that a + b rounds to 'expect' in mode rm.
+static void check_fadd(prog_t *p, u4 a, u4 b, u1 rm, u4 expect) {
+    li(p, T0, a);
+    fmv_w_x(p, 1, T0);
+    li(p, T0, b);
+    fmv_w_x(p, 2, T0);
+    fadd_s(p, 3, 1, 2, rm);
+    fmv_x_w(p, T0, 3);
+    prog_check(p, T0, expect);
+}
+
+// Check that a converts to 'expect' in mode rm.
+static void check_fcvt(prog_t *p, u4 a, u1 rm, u4 expect) {
+    li(p, T0, a);
+    fmv_w_x(p, 1, T0);
+    fcvt_w_s(p, T1, 1, rm);
+    prog_check(p, T1, expect);
+}
+
+// Each rounding mode, given in the instruction or taken from frm, rounds
+// additions and conversions its own way. Reserved modes are illegal.
+static void test_fp_round(prog_t *p) {
+    static const struct { u1 rm; u4 up, down, cvt_pos, cvt_neg; } modes[] = {
+        //                      1 + q        -1 - q       2.5  -2.5
+        { RV_FCSR_RM_RNE, F_ONE,       F_ONE | (1u << 31),         2, -2 },
+        { RV_FCSR_RM_RTZ, F_ONE,       F_ONE | (1u << 31),         2, -2 },
+        { RV_FCSR_RM_RDN, F_ONE,       (F_ONE + 1) | (1u << 31),   2, -3 },
+        { RV_FCSR_RM_RUP, F_ONE + 1,   F_ONE | (1u << 31),         3, -2 },
+        { RV_FCSR_RM_RMM, F_ONE,       F_ONE | (1u << 31),         3, -3 },
+    };
+    const u4 nmodes = sizeof(modes) / sizeof(modes[0]);
+    const u4 start = HANDLER_INDEX + 16;
+
+    // the checks run past the handler, which comes first
+    jal(p, ZERO, start);
+    prog_org(p, HANDLER_INDEX);
+    csrrs(p, T1, RV_CSR_MCAUSE, ZERO);
+    prog_check(p, T1, RV_EX_INST_ILLEGAL);
+    addi(p, S1, S1, 1);
+    skip_trap(p);
+
+    prog_org(p, start);
+    set_trap_handler(p);
+    li(p, S1, 0);                       // illegal instructions taken
+    for (u4 i = 0; i < nmodes; i++) {
+        // static mode, with frm set to a mode that rounds differently
+        set_frm(p, modes[(i + 3) % nmodes].rm);
+        check_fadd(p, F_ONE, F_QUARTER, modes[i].rm, modes[i].up);
+        check_fadd(p, F_ONE | (1u << 31), F_QUARTER | (1u << 31), modes[i].rm, modes[i].down);
+        check_fcvt(p, F_2_5, modes[i].rm, modes[i].cvt_pos);
+        check_fcvt(p, F_2_5 | (1u << 31), modes[i].rm, modes[i].cvt_neg);
+
+        // dynamic mode
+        set_frm(p, modes[i].rm);
+        check_fadd(p, F_ONE, F_QUARTER, RV_FCSR_RM_DYN, modes[i].up);
+        check_fadd(p, F_ONE | (1u << 31), F_QUARTER | (1u << 31), RV_FCSR_RM_DYN, modes[i].down);
+        check_fcvt(p, F_2_5, RV_FCSR_RM_DYN, modes[i].cvt_pos);
+        check_fcvt(p, F_2_5 | (1u << 31), RV_FCSR_RM_DYN, modes[i].cvt_neg);
+    }
+
+    // a reserved mode in frm or in the instruction is illegal
+    set_frm(p, F_RM_BAD);
+    fadd_s(p, 3, 1, 2, RV_FCSR_RM_DYN);
+    prog_check(p, S1, 1);
+    set_frm(p, RV_FCSR_RM_RNE);
+    fadd_s(p, 3, 1, 2, F_RM_BAD);
+    prog_check(p, S1, 2);
+
+    // Round up over many polls. The host mode is reset for each poll and has
+    // to be set again for the next rounded op.
+    set_frm(p, RV_FCSR_RM_RUP);
+    li(p, S2, 2000);
+    const u4 top = prog_here(p);
+    check_fadd(p, F_ONE, F_QUARTER, RV_FCSR_RM_DYN, F_ONE + 1);
+    addi(p, S2, S2, -1);
+    bne(p, S2, ZERO, top);
+    prog_exit(p, 0);
+}
+
+// An inexact op raises NX in fflags, kept across device accesses until fflags
+// is written. Exact ops raise nothing.
+static void test_fp_flags(prog_t *p) {
+    csrrw(p, ZERO, RV_CSR_FFLAGS, ZERO);
+    check_fadd(p, F_ONE, F_ONE, RV_FCSR_RM_RNE, 0x40000000);
+    csrrs(p, T1, RV_CSR_FFLAGS, ZERO);
+    prog_check(p, T1, 0);
+
+    check_fadd(p, F_ONE, F_QUARTER, RV_FCSR_RM_RNE, F_ONE);
+    li(p, A2, PLAT_TIMER_BASE);
+    lw(p, T0, A2, 0);
+    csrrs(p, T1, RV_CSR_FFLAGS, ZERO);
+    prog_check(p, T1, RV_FCSR_NX);
+    csrrs(p, T1, RV_CSR_FCSR, ZERO);
+    prog_check(p, T1, RV_FCSR_NX);
+
+    csrrw(p, ZERO, RV_CSR_FFLAGS, ZERO);
+    csrrs(p, T1, RV_CSR_FFLAGS, ZERO);
+    prog_check(p, T1, 0);
+    prog_exit(p, 0);
+}
+
+const test_t fp_tests[] = {
+    { .name = "fp_flags", .build = test_fp_flags, .setup = setup_fp },
+    { .name = "fp_round", .build = test_fp_round, .setup = setup_fp },
+    {},
+};
@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#include <unistd.h>
+
+#include <core/device.h>
+#include <device/sled/dma.h>
+#include <device/sled/intc.h>
+#include <sled/arch.h>
+#include <sled/error.h>
+#include <sled/riscv.h>
+#include <sled/riscv/csr.h>
+
+#include "test.h"
+
+// Machine tests: snapshots, loading and harts.
+
+// Snapshots keep the memory the guest populated, including pages of an
+// earlier snapshot that weren't touched again before the next one.
+static void test_snapshot(prog_t *p) {
+    li(p, A2, DATA_BASE);
+    reg_write(p, 0, 0x1111);
+    li(p, A2, DATA_BASE + 0x200000);
+    reg_write(p, 0, 0x2222);
+    prog_exit(p, 0);
+}
+
+static int check_snapshot(const test_t *t, sl_machine_t *m) {
+    sl_core_t *c = sl_machine_get_core(m, 0);
+    const u4 val = 0x3333;
+    sl_snapshot_t *s0 = NULL, *s1 = NULL;
+    int err;
+
+    if ((err = sl_machine_snapshot(m, &s0))) goto out;
+    if ((err = sl_core_mem_write(c, DATA_BASE, 4, 1, (void *)&val))) goto out;
+    if ((err = sl_machine_snapshot(m, &s1))) goto out;
+    if ((err = sl_core_mem_write(c, DATA_BASE + 0x200000, 4, 1, (void *)&val))) goto out;
+
+    if ((err = sl_machine_restore(m, s1))) goto out;
+    if ((err = test_expect_word(t, c, DATA_BASE, 0x3333))) goto out;
+    if ((err = test_expect_word(t, c, DATA_BASE + 0x200000, 0x2222))) goto out;
+    if ((err = test_expect_word(t, c, DATA_BASE + 0x100000, 0))) goto out;
+    if ((err = sl_machine_restore(m, s0))) goto out;
+    if ((err = test_expect_word(t, c, DATA_BASE, 0x1111))) goto out;
+    err = test_expect_word(t, c, DATA_BASE + 0x200000, 0x2222);
+
+out:
+    if (s1 != NULL) sl_snapshot_destroy(s1);
+    if (s0 != NULL) sl_snapshot_destroy(s0);
+    return err;
+}
+
+#define DMA_SRC     (DATA_BASE + 0x10000)
+#define DMA_DST     (DATA_BASE + 0x20000)
+
+// Start a descriptor that chains to itself, so the DMA keeps copying after
+// the program exits.
+static void test_snapshot_dma(prog_t *p) {
+    const u4 desc = DATA_BASE;
+    li(p, A2, DMA_SRC);
+    reg_write(p, 0, 0x1234);
+    li(p, A2, desc);
+    reg_write(p, DMA_DESC_SRC, DMA_SRC);
+    reg_write(p, DMA_DESC_DST, DMA_DST);
+    reg_write(p, DMA_DESC_LEN, 0x10000);
+    reg_write(p, DMA_DESC_NEXT, desc);
+    li(p, A2, PLAT_DMA_BASE);
+    reg_write(p, DMA_REG_CHAN_DESC_LO(0), desc);
+    reg_write(p, DMA_REG_CHAN_CONFIG(0), DMA_CHAN_CONFIG_RUN);
+    prog_exit(p, 0);
+}
+
+// Clear the first copied word and wait for the DMA to copy it again.
+static int dma_copies(const test_t *t, sl_core_t *c, bool expect) {
+    const u4 zero = 0;
+    int err = sl_core_mem_write(c, DMA_DST, 4, 1, (void *)&zero);
+    for (u4 i = 0; !err && (i < 1000); i++) {
+        u4 v;
+        if ((err = sl_core_mem_read(c, DMA_DST, 4, 1, &v))) break;
+        if (v == 0x1234) break;
+        usleep(1000);
+    }
+    if (err) return err;
+    return expect ? test_expect_word(t, c, DMA_DST, 0x1234) : test_expect_word(t, c, DMA_DST, 0);
+}
+
+// A paused DMA copies nothing until it is resumed, and snapshots taken and
+// restored while it runs leave it running.
+static int check_snapshot_dma(const test_t *t, sl_machine_t *m) {
+    sl_core_t *c = sl_machine_get_core(m, 0);
+    sl_dev_t *dma = sl_machine_get_device_for_name(m, "dma0");
+    sl_snapshot_t *s = NULL;
+    int err;
+
+    if ((err = dma_copies(t, c, true))) return err;
+    dma->ops->pause(dma);
+    err = dma_copies(t, c, false);
+    dma->ops->resume(dma);
+    if (err) return err;
+    if ((err = dma_copies(t, c, true))) return err;
+
+    if ((err = sl_machine_snapshot(m, &s))) return err;
+    if ((err = sl_machine_restore(m, s))) goto out;
+    err = dma_copies(t, c, true);
+
+out:
+    sl_snapshot_destroy(s);
+    return err;
+}
+
+static void test_spin(prog_t *p) {
+    jal(p, ZERO, prog_here(p));
+}
+
+// Snapshots can't be taken or restored while the cores run, and a snapshot of
+// a machine laid out differently is refused before anything is restored.
+static int run_snapshot_refused(const test_t *t) {
+    static const test_t two = { .name = "two_cores", .num_cores = 2 };
+    static prog_t p;
+    sl_machine_t *m, *m2 = NULL;
+    sl_snapshot_t *s = NULL, *s2 = NULL;
+    const u4 val = 0x5555;
+    int err;
+
+    prog_init(&p);
+    test_spin(&p);
+    if ((err = test_machine_create(t, &p, &m))) return err;
+    sl_core_t *c = sl_machine_get_core(m, 0);
+    if ((err = sl_machine_snapshot(m, &s))) goto out;
+    if ((err = sl_machine_start(m))) goto out;
+    const int busy_snap = sl_machine_snapshot(m, &s2);
+    const int busy_restore = sl_machine_restore(m, s);
+    sl_machine_stop(m);
+    sl_machine_join(m);
+    if ((busy_snap != SL_ERR_BUSY) || (busy_restore != SL_ERR_BUSY)) {
+        err = test_fail(t, "snapshot %s, restore %s while running", st_err(busy_snap), st_err(busy_restore));
+        goto out;
+    }
+
+    if ((err = test_machine_create(&two, &p, &m2))) goto out;
+    if ((err = sl_machine_snapshot(m2, &s2))) goto out;
+    if ((err = sl_core_mem_write(c, DATA_BASE, 4, 1, (void *)&val))) goto out;
+    if ((err = sl_machine_restore(m, s2)) != SL_ERR_ARG) {
+        err = test_fail(t, "restore of a two core snapshot: %s", st_err(err));
+        goto out;
+    }
+    if ((err = test_expect_word(t, c, DATA_BASE, val))) goto out;
+    if ((err = sl_machine_restore(m, s))) goto out;
+    err = test_expect_word(t, c, DATA_BASE, 0);
+
+out:
+    sl_snapshot_destroy(s2);
+    sl_snapshot_destroy(s);
+    if (m2 != NULL) sl_machine_destroy(m2);
+    sl_machine_destroy(m);
+    return err;
+}
+
+#define RESUME_INDEX    0x80    // instruction index the restored copy resumes at
+
+// The first run enables the DMA interrupt and exits. A second machine
+// restored from a snapshot of the first resumes at RESUME_INDEX, starts a
+// DMA chain and must take its completion interrupt.
+static void test_restore_irq(prog_t *p) {
+    const u4 src = DATA_BASE;
+    const u4 dst = DATA_BASE + 0x100;
+    const u4 desc = DATA_BASE + 0x200;
+
+    set_trap_handler(p);
+    li(p, S1, 0);                       // interrupts taken
+    enable_ext_irq(p, 0, PLAT_INTC_DMA_IRQ_BIT);
+    prog_exit(p, 0);
+
+    prog_org(p, RESUME_INDEX);
+    li(p, A2, desc);
+    reg_write(p, DMA_DESC_SRC, src);
+    reg_write(p, DMA_DESC_DST, dst);
+    reg_write(p, DMA_DESC_LEN, 16);
+    li(p, A2, PLAT_DMA_BASE);
+    reg_write(p, DMA_IRQ_MASK, ~1u);
+    reg_write(p, DMA_REG_CHAN_DESC_LO(0), desc);
+    reg_write(p, DMA_REG_CHAN_CONFIG(0), DMA_CHAN_CONFIG_RUN);
+    wait_for_irq(p);
+    prog_exit(p, 0);
+
+    prog_org(p, HANDLER_INDEX);
+    csrrs(p, T1, RV_CSR_MCAUSE, ZERO);
+    prog_check(p, T1, RV_CAUSE32_INT | RV_INT_EXTERNAL_M);
+    addi(p, S1, S1, 1);
+    li(p, A2, PLAT_DMA_BASE);
+    reg_write(p, DMA_IRQ_STATUS, 1);
+    li(p, A2, PLAT_INTC_BASE);
+    reg_write(p, INTC_REG_ASSERTED, 1u << PLAT_INTC_DMA_IRQ_BIT);
+    mret(p);
+}
+
+// A snapshot keeps the core's interrupt enable, so a machine restored from it
+// takes interrupts without the guest enabling them again.
+static int run_restore_irq(const test_t *t) {
+    static prog_t p;
+    sl_machine_t *m, *m2 = NULL;
+    sl_snapshot_t *s = NULL;
+    int err;
+
+    prog_init(&p);
+    test_restore_irq(&p);
+    if ((err = test_machine_create(t, &p, &m))) return err;
+    if ((err = test_machine_run(t, m))) goto out;
+    if ((err = sl_machine_snapshot(m, &s))) goto out;
+
+    if ((err = test_machine_create(t, &p, &m2))) goto out;
+    if ((err = sl_machine_restore(m2, s))) goto out;
+    sl_core_set_reg(sl_machine_get_core(m2, 0), SL_CORE_REG_PC, PLAT_MEM_BASE + (RESUME_INDEX * 4));
+    err = test_machine_run(t, m2);
+
+out:
+    sl_snapshot_destroy(s);
+    if (m2 != NULL) sl_machine_destroy(m2);
+    sl_machine_destroy(m);
+    return err;
+}
+
+// Cores are added in hart id order, and the caller's parameters are left as
+// they were.
+static int run_add_core_id(const test_t *t) {
+    sl_core_params_t params = {};
+    params.arch = PLAT_CORE_ARCH;
+    params.subarch = PLAT_CORE_SUBARCH;
+    params.arch_options = SL_RISCV_EXT_A | SL_RISCV_EXT_ZICSR;
+    sl_machine_t *m;
+    int err;
+
+    if ((err = sl_machine_create(&m))) return err;
+    params.id = 1;
+    if ((err = sl_machine_add_core(m, &params)) != SL_ERR_ARG) {
+        err = test_fail(t, "hart 1 added first: %s", st_err(err));
+        goto out;
+    }
+    params.id = 0;
+    if ((err = sl_machine_add_core(m, &params))) goto out;
+    if ((params.id != 0) || (params.name != NULL) || (params.bus != NULL)) {
+        err = test_fail(t, "parameters changed");
+        goto out;
+    }
+    if (sl_machine_add_core(m, &params) != SL_ERR_ARG)
+        err = test_fail(t, "hart 0 added twice");
+
+out:
+    sl_machine_destroy(m);
+    return err;
+}
+
+const test_t machine_tests[] = {
+    { .name = "add_core_id", .run = run_add_core_id },
+    { .name = "snapshot", .build = test_snapshot, .check = check_snapshot },
+    { .name = "snapshot_refused", .run = run_snapshot_refused },
+    { .name = "restore_irq", .run = run_restore_irq },
+    { .name = "snapshot_dma", .build = test_snapshot_dma, .check = check_snapshot_dma },
+    {},
+};
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <device/sled/intc.h>
+#include <device/sled/sled.h>
+#include <sled/arch.h>
+#include <sled/device.h>
+#include <sled/error.h>
+#include <sled/riscv.h>
+#include <sled/riscv/csr.h>
+
+#include "test.h"
+
+static const test_t *suites[] = {
+    block_tests,
+    cache_tests,
+    dev_tests,
+    fp_tests,
+    machine_tests,
+    mapper_tests,
+    mem_tests,
+};
+
+void set_trap_handler(prog_t *p) {
+    li(p, T0, PLAT_MEM_BASE + (HANDLER_INDEX * 4));
+    csrrw(p, ZERO, RV_CSR_MTVEC, T0);
+}
+
+void skip_trap(prog_t *p) {
+    csrrs(p, T1, RV_CSR_MEPC, ZERO);
+    addi(p, T1, T1, 4);
+    csrrw(p, ZERO, RV_CSR_MEPC, T1);
+    mret(p);
+}
+
+void reg_write(prog_t *p, u4 reg, u4 val) {
+    li(p, T0, val);
+    sw(p, T0, A2, reg);
+}
+
+void enable_ext_irq(prog_t *p, u4 hart, u4 bit) {
+    li(p, A2, PLAT_INTC_BASE);
+    for (u4 i = 0; i < INTC_MAX_HARTS; i++)
+        reg_write(p, INTC_REG_TARGET(i), (i == hart) ? (1u << bit) : 0);
+    reg_write(p, INTC_REG_MASK, ~(1u << bit));
+    li(p, T0, 1u << RV_INT_EXTERNAL_M);
+    csrrs(p, ZERO, RV_CSR_MIE, T0);
+    li(p, T0, RV_SR_STATUS_MIE);
+    csrrs(p, ZERO, RV_CSR_MSTATUS, T0);
+}
+
+void wait_for_irq(prog_t *p) {
+    li(p, S2, 50000000);
+    const u4 top = prog_here(p);
+    addi(p, S2, S2, -1);
+    beq(p, S2, ZERO, prog_here(p) + 2);
+    beq(p, S1, ZERO, top);
+    prog_check(p, S1, 1);
+}
+
+static int add_devices(sl_machine_t *m) {
+    static const struct { u4 type; u8 base; const char *name; } devs[] = {
+        { SL_DEV_SLED_INTC,  PLAT_INTC_BASE,  "intc0" },
+        { SL_DEV_SLED_MPU,   PLAT_MPU_BASE,   "mpu0" },
+        { SL_DEV_SLED_TIMER, PLAT_TIMER_BASE, "timer0" },
+        { SL_DEV_SLED_DMA,   PLAT_DMA_BASE,   "dma0" },
+    };
+    int err;
+    for (u4 i = 0; i < sizeof(devs) / sizeof(devs[0]); i++) {
+        if ((err = sl_machine_add_device(m, devs[i].type, devs[i].base, devs[i].name))) return err;
+    }
+    sl_dev_t *intc = sl_machine_get_device_for_name(m, "intc0");
+    if ((err = sled_intc_set_input(intc, sl_machine_get_device_for_name(m, "timer0"), PLAT_INTC_TIMER_IRQ_BIT)))
+        return err;
+    return sled_intc_set_input(intc, sl_machine_get_device_for_name(m, "dma0"), PLAT_INTC_DMA_IRQ_BIT);
+}
+
+static int add_cores(const test_t *t, sl_machine_t *m, u4 num) {
+    static const char *core_names[MAX_CORES] = { "cpu0", "cpu1", "cpu2", "cpu3", "cpu4", "cpu5", "cpu6", "cpu7" };
+    sl_dev_t *mpu = sl_machine_get_device_for_name(m, "mpu0");
+    int err;
+    for (u4 i = 0; i < num; i++) {
+        sl_core_params_t params = {};
+        params.arch = PLAT_CORE_ARCH;
+        params.subarch = PLAT_CORE_SUBARCH;
+        params.id = i;
+        params.options = SL_CORE_OPT_TRAP_SYSCALL;
+        params.arch_options = SL_RISCV_EXT_A | SL_RISCV_EXT_ZICSR;
+        params.name = core_names[i];
+        if (t->setup != NULL) t->setup(&params);
+        if ((err = sl_machine_add_core(m, &params))) return err;
+        sl_core_t *c = sl_machine_get_core(m, i);
+        err = (i == 0) ? sl_core_set_mapper(c, mpu) : sl_core_share_mapper(c, mpu);
+        if (err < 0) return err;
+    }
+    return 0;
+}
+
+int test_machine_create(const test_t *t, const prog_t *p, sl_machine_t **m_out) {
+    const u4 num_cores = t->num_cores ? t->num_cores : 1;
+    sl_machine_t *m;
+    int err;
+
+    if ((err = sl_machine_create(&m))) return err;
+    if ((err = sl_machine_add_mem(m, PLAT_MEM_BASE, PLAT_MEM_SIZE))) goto out_err;
+    if ((err = add_devices(m))) goto out_err;
+    if ((err = add_cores(t, m, num_cores))) goto out_err;
+    if ((err = sl_machine_load_core_raw(m, 0, PLAT_MEM_BASE, (void *)p->inst, p->len * 4))) goto out_err;
+    for (u4 i = 0; i < num_cores; i++)
+        sl_core_set_reg(sl_machine_get_core(m, i), SL_CORE_REG_PC, PLAT_MEM_BASE);
+    *m_out = m;
+    return 0;
+
+out_err:
+    sl_machine_destroy(m);
+    return err;
+}
+
+int test_machine_run(const test_t *t, sl_machine_t *m) {
+    u4 id = 0;
+
+    // the first core to stop ends the test
+    int err = sl_machine_start(m);
+    if (err) return err;
+    err = sl_machine_wait(m, &id);
+    sl_machine_stop(m);
+    sl_machine_join(m);
+    if (err != SL_ERR_SYSCALL) {
+        printf("%s: unexpected run status: %s\n", t->name, st_err(err));
+        return err ? err : SL_ERR;
+    }
+
+    sl_core_t *c = sl_machine_get_core(m, id);
+    const u8 a0 = sl_core_get_reg(c, SL_CORE_REG_ARG0);
+    const u8 a1 = sl_core_get_reg(c, SL_CORE_REG_ARG1);
+    if (a0 != 0x666) {
+        printf("%s: unexpected exit syscall %#" PRIx64 "\n", t->name, a0);
+        return SL_ERR;
+    }
+    if (a1 != 0) {
+        printf("%s: cpu%u failed check %" PRIu64 "\n", t->name, id, a1);
+        return SL_ERR;
+    }
+    return 0;
+}
+
+int test_expect_word(const test_t *t, sl_core_t *c, u8 addr, u4 val) {
+    u4 v = 0;
+    int err = sl_core_mem_read(c, addr, 4, 1, &v);
+    if (err) return err;
+    if (v == val) return 0;
+    printf("%s: %#" PRIx64 " holds %#x, expected %#x\n", t->name, addr, v, val);
+    return SL_ERR;
+}
+
+int test_fail(const test_t *t, const char *fmt, ...) {
+    va_list args;
+    printf("%s: ", t->name);
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    printf("\n");
+    return SL_ERR;
+}
+
+static int run_test(const test_t *t) {
+    static prog_t p;
+    sl_machine_t *m;
+    int err;
+
+    if (t->run != NULL) return t->run(t);
+
+    prog_init(&p);
+    t->build(&p);
+    if ((err = test_machine_create(t, &p, &m))) return err;
+    err = test_machine_run(t, m);
+    if (!err && (t->check != NULL)) err = t->check(t, m);
+    sl_machine_destroy(m);
+    return err;
+}
+
+int main(int argc, char *argv[]) {
+    u4 failed = 0;
+    u4 ran = 0;
+
+    for (u4 s = 0; s < sizeof(suites) / sizeof(suites[0]); s++) {
+        for (const test_t *t = suites[s]; t->name != NULL; t++) {
+            bool selected = (argc < 2);
+            for (int a = 1; a < argc; a++) selected |= !strcmp(argv[a], t->name);
+            if (!selected) continue;
+
+            ran++;
+            const int err = run_test(t);
+            printf("%-24s %s\n", t->name, err ? "FAIL" : "ok");
+            if (err) failed++;
+        }
+    }
+    printf("%u of %u tests passed\n", ran - failed, ran);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include <core/mapper.h>
+#include <sled/error.h>
+#include <sled/io.h>
+#include <sled/mapper.h>
+
+#include "test.h"
+
+// Mapper tests, run on mappers of their own outside a machine. The endpoint
+// resolves every address to itself, so a lookup returns the translated
+// address.
+
+#define MAP_MAX_ENTS    64
+
+static int echo_io(sl_map_ep_t *ep, sl_io_op_t *op) {
+    op->arg[0] = op->addr;
+    op->arg[1] = 1;
+    return 0;
+}
+
+static sl_map_ep_t echo_ep = { .io = echo_io };
+
+static void mapping_set(sl_mapping_t *e, u8 base, u8 len, u8 out) {
+    e->input_base = base;
+    e->length = len;
+    e->output_base = out;
+    e->domain = 0;
+    e->permissions = SL_MAP_PERM_ALL;
+    e->type = SL_MAP_TYPE_MEMORY;
+    e->ep = &echo_ep;
+}
+
+// Resolve addr and check that it translates to 'expect', or isn't mapped if
+// 'expect' is ~0.
+static int expect_resolve(const test_t *t, sl_mapper_t *m, u8 addr, u8 expect) {
+    u8 len;
+    u2 perm;
+    resultptr_t res = sl_mapper_resolve(m, addr, &len, &perm);
+    if (expect == ~0ull) {
+        if (res.err == SL_ERR_IO_NOMAP) return 0;
+        return test_fail(t, "%#" PRIx64 " resolved (%s), expected no mapping", addr, st_err(res.err));
+    }
+    if (res.err) return test_fail(t, "%#" PRIx64 ": %s", addr, st_err(res.err));
+    if ((u8)(uptr)res.value != expect)
+        return test_fail(t, "%#" PRIx64 " resolved to %#" PRIx64 ", expected %#" PRIx64, addr, (u8)(uptr)res.value, expect);
+    return 0;
+}
+
+// Map 'ents', given out of order, and check the first and last address of
+// each and the gaps on either side. The entries are apart.
+static int check_map(const test_t *t, sl_mapper_t *m, sl_mapping_t *ents, u4 num) {
+    int err = sl_mapper_update(m, SL_MAP_OP_MODE_TRANSLATE | SL_MAP_OP_REPLACE, num, ents);
+    if (err) return err;
+    // twice, so the second pass hits the entries hinted by the first
+    for (u4 pass = 0; pass < 2; pass++) {
+        for (u4 i = 0; i < num; i++) {
+            const sl_mapping_t *e = &ents[i];
+            const u8 end = e->input_base + e->length;
+            if ((err = expect_resolve(t, m, e->input_base, e->output_base))) return err;
+            if ((err = expect_resolve(t, m, end - 1, e->output_base + e->length - 1))) return err;
+            if ((err = expect_resolve(t, m, end, ~0ull))) return err;
+            if ((err = expect_resolve(t, m, e->input_base - 1, ~0ull))) return err;
+        }
+    }
+    return 0;
+}
+
+// Lookups find the entry for an address through the slot table, in slots
+// shared by several entries, and by searching maps too sparse for slots.
+static int run_mapper_lookup(const test_t *t) {
+    sl_mapping_t ents[MAP_MAX_ENTS];
+    sl_mapper_t *m;
+    int err;
+
+    if ((err = sl_mapper_create(&m))) return err;
+
+    // one entry per slot, added highest first
+    for (u4 i = 0; i < 32; i++) {
+        const u8 base = 0x10000 + (0x10000 * (31 - i)) + ((i % 3) * 0x100);
+        mapping_set(&ents[i], base, 0x8000, 0x100000000ull + base);
+    }
+    if ((err = check_map(t, m, ents, 32))) goto out;
+    if ((err = expect_resolve(t, m, 0x10000 * 40, ~0ull))) goto out;
+    if ((err = expect_resolve(t, m, 0, ~0ull))) goto out;
+
+    // several entries per slot
+    for (u4 i = 0; i < 48; i++) {
+        const u8 base = 0x40000 + (0x2000 * ((i * 7) % 48));
+        mapping_set(&ents[i], base, 0x1000, 0x200000000ull + base);
+    }
+    if ((err = check_map(t, m, ents, 48))) goto out;
+
+    // too sparse for slots
+    for (u4 i = 0; i < 16; i++) {
+        const u8 base = ((u8)(16 - i) << 32) + 0x1000;
+        mapping_set(&ents[i], base, 0x3000, 0x300000000ull + (i * 0x10000));
+    }
+    if ((err = check_map(t, m, ents, 16))) goto out;
+
+    // nothing mapped
+    if ((err = sl_mapper_update(m, SL_MAP_OP_MODE_TRANSLATE | SL_MAP_OP_REPLACE, 0, NULL))) goto out;
+    err = expect_resolve(t, m, ents[0].input_base, ~0ull);
+
+out:
+    sl_mapper_destroy(m);
+    return err;
+}
+
+// A lookup never takes its entry from a hint left by an earlier table, even
+// when a replaced table is freed and the next one allocated in its place. The
+// tables alternate between layouts that map the hinted address differently,
+// to other entries, or not at all.
+static int run_mapper_hint(const test_t *t) {
+    sl_mapping_t ents[3];
+    sl_mapper_t *m;
+    int err;
+
+    if ((err = sl_mapper_create(&m))) return err;
+    for (u4 i = 0; i < 3000; i++) {
+        const u8 out = (u8)i << 32;
+        u4 num;
+        u8 expect;
+        switch (i % 3) {
+        case 0:
+            mapping_set(&ents[0], 0x0, 0x1000, out);
+            mapping_set(&ents[1], 0x8000, 0x1000, out + 0x8000);
+            mapping_set(&ents[2], 0x10000, 0x10000, out + 0x10000);
+            num = 3;
+            expect = out + 0x10010;
+            break;
+        case 1:
+            mapping_set(&ents[0], 0x10000, 0x10, out + 0x10000);
+            num = 1;
+            expect = ~0ull;
+            break;
+        default:
+            mapping_set(&ents[0], 0x10000, 0x20, out);
+            mapping_set(&ents[1], 0x10000 - 0x100, 0x100, out + 0x1000);
+            num = 2;
+            expect = out + 0x10;
+            break;
+        }
+        if ((err = sl_mapper_update(m, SL_MAP_OP_MODE_TRANSLATE | SL_MAP_OP_REPLACE, num, ents))) break;
+        // hint the first entry, then look up the address tested
+        if ((err = expect_resolve(t, m, ents[0].input_base, ents[0].output_base))) break;
+        if ((err = expect_resolve(t, m, 0x10010, expect))) break;
+        if ((err = expect_resolve(t, m, 0x10010, expect))) break;
+    }
+    sl_mapper_destroy(m);
+    return err;
+}
+
+#define RACE_TABLES     20000
+#define RACE_SPAN       0x40000
+
+typedef struct {
+    const test_t *t;
+    sl_mapper_t *m;
+    atomic_uint published;      // tables published, or about to be
+    atomic_bool done;
+    int publish_err;
+    int resolve_err;
+    u8 lookups;
+} race_t;
+
+// Table k splits the span into entries of a size of its own and translates
+// to k in the upper half.
+static int race_table(race_t *r, u4 k) {
+    sl_mapping_t ents[MAP_MAX_ENTS];
+    const u8 len = 0x1000u << (k % 5);
+    const u4 num = RACE_SPAN / len;
+    for (u4 i = 0; i < num; i++)
+        mapping_set(&ents[i], i * len, len, ((u8)k << 32) + (i * len));
+    atomic_store(&r->published, k);
+    return sl_mapper_update(r->m, SL_MAP_OP_MODE_TRANSLATE | SL_MAP_OP_REPLACE, num, ents);
+}
+
+static void * race_publish(void *arg) {
+    race_t *r = arg;
+    for (u4 k = 1; (k <= RACE_TABLES) && !r->publish_err; k++)
+        r->publish_err = race_table(r, k);
+    atomic_store(&r->done, true);
+    return NULL;
+}
+
+// Every lookup translates through one table, and never through a table older
+// than one an earlier lookup used.
+static void * race_resolve(void *arg) {
+    race_t *r = arg;
+    u8 addr = 0;
+    u8 last = 0;
+    while (!atomic_load(&r->done)) {
+        addr = (addr + 0x1234) % RACE_SPAN;
+        for (u4 i = 0; i < 2; i++) {
+            u8 len;
+            u2 perm;
+            resultptr_t res = sl_mapper_resolve(r->m, addr, &len, &perm);
+            if (res.err) {
+                r->resolve_err = test_fail(r->t, "%#" PRIx64 ": %s", addr, st_err(res.err));
+                return NULL;
+            }
+            const u8 out = (uptr)res.value;
+            const u8 k = out >> 32;
+            if (((u4)out != addr) || (k < last) || (k > atomic_load(&r->published))) {
+                r->resolve_err = test_fail(r->t, "%#" PRIx64 " resolved to %#" PRIx64 " after table %" PRIu64,
+                    addr, out, last);
+                return NULL;
+            }
+            last = k;
+            r->lookups++;
+        }
+    }
+    return NULL;
+}
+
+// One thread keeps replacing the table while another keeps resolving through
+// it. Tables retired while the lookups ran are all freed once they stop.
+// Run under BLD_HOST_USE_SANITIZERS=1 to catch tables freed too early.
+static int run_mapper_publish_race(const test_t *t) {
+    race_t r = { .t = t };
+    pthread_t pub, res;
+    int err;
+
+    if ((err = sl_mapper_create(&r.m))) return err;
+    if ((err = race_table(&r, 0))) goto out;
+    if ((err = pthread_create(&res, NULL, race_resolve, &r))) {
+        err = SL_ERR;
+        goto out;
+    }
+    if (pthread_create(&pub, NULL, race_publish, &r)) {
+        atomic_store(&r.done, true);
+        pthread_join(res, NULL);
+        err = SL_ERR;
+        goto out;
+    }
+    pthread_join(pub, NULL);
+    pthread_join(res, NULL);
+
+    if ((err = r.publish_err)) goto out;
+    if ((err = r.resolve_err)) goto out;
+    if (r.lookups == 0) {
+        err = test_fail(t, "no lookups ran");
+        goto out;
+    }
+    const u4 retired = mapper_retired_count(r.m);
+    if (retired != 0) err = test_fail(t, "%u retired tables not freed", retired);
+
+out:
+    sl_mapper_destroy(r.m);
+    return err;
+}
+
+const test_t mapper_tests[] = {
+    { .name = "mapper_lookup", .run = run_mapper_lookup },
+    { .name = "mapper_hint", .run = run_mapper_hint },
+    { .name = "mapper_publish_race", .run = run_mapper_publish_race },
+    {},
+};
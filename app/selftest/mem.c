@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#include <sled/riscv.h>
+#include <sled/riscv/csr.h>
+
+#include "test.h"
+
+// Guest memory tests: loads, stores and atomics, and writes to code.
+
+// An atomic that lands on decoded code resets it like a plain store does, so
+// the next call runs the rewritten instruction.
+static void test_amo_code_write(prog_t *p) {
+    const u4 func = 0x80;
+
+    jal(p, RA, func);
+    prog_check(p, A0, 1);
+    li(p, T0, PLAT_MEM_BASE + (func * 4));
+    li(p, T1, 1u << 20);                // addi immediate + 1
+    amoadd_w(p, ZERO, T0, T1);
+    jal(p, RA, func);
+    prog_check(p, A0, 2);
+    prog_exit(p, 0);
+
+    prog_org(p, func);
+    addi(p, A0, ZERO, 1);
+    jalr(p, ZERO, RA, 0);
+}
+
+// Memory regions smaller than a cache page, one starting mid page and one
+// starting a page, can't be cached. Code runs from the first and data is kept
+// in the second through the mapper, which still refuses an access past its end.
+#define SMALL_CODE  0x6000800
+#define SMALL_DATA  0x6002000
+#define SMALL_SIZE  0x100
+
+static void build_small_main(prog_t *p) {
+    set_trap_handler(p);
+    li(p, S1, 0);                       // faults taken
+    li(p, T0, SMALL_CODE);
+    jalr(p, RA, T0, 0);
+    prog_check(p, A0, 0x5a5a);
+    prog_check(p, S1, 1);
+    li(p, S0, SMALL_DATA);
+    lw(p, A0, S0, 4);
+    prog_check(p, A0, 0x1234);
+    prog_exit(p, 0);
+
+    prog_org(p, HANDLER_INDEX);
+    csrrs(p, T1, RV_CSR_MCAUSE, ZERO);
+    prog_check(p, T1, RV_EX_LOAD_FAULT);
+    addi(p, S1, S1, 1);
+    skip_trap(p);
+}
+
+static void build_small_func(prog_t *p) {
+    li(p, S0, SMALL_DATA);
+    li(p, T1, 0x5a5a);
+    sw(p, T1, S0, 0);
+    lw(p, A0, S0, 0);
+    lw(p, T1, S0, SMALL_SIZE);          // skipped by the handler
+    li(p, T1, 0x1234);
+    sw(p, T1, S0, 4);
+    jalr(p, ZERO, RA, 0);
+}
+
+static int run_small_region(const test_t *t) {
+    static prog_t main, func;
+    sl_machine_t *m;
+    int err;
+
+    prog_init(&main);
+    build_small_main(&main);
+    prog_init(&func);
+    build_small_func(&func);
+    if ((err = test_machine_create(t, &main, &m))) return err;
+    if ((err = sl_machine_add_mem(m, SMALL_CODE, SMALL_SIZE))) goto out;
+    if ((err = sl_machine_add_mem(m, SMALL_DATA, SMALL_SIZE))) goto out;
+    if ((err = sl_machine_load_core_raw(m, 0, SMALL_CODE, func.inst, func.len * 4))) goto out;
+    err = test_machine_run(t, m);
+
+out:
+    sl_machine_destroy(m);
+    return err;
+}
+
+const test_t mem_tests[] = {
+    { .name = "amo_code_write", .build = test_amo_code_write },
+    { .name = "small_region",   .run = run_small_region },
+    {},
+};
@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#include <assert.h>
+
+#include "prog.h"
+
+#define OP_LUI      0x37
+#define OP_AUIPC    0x17
+#define OP_IMM      0x13
+#define OP_REG      0x33
+#define OP_LOAD     0x03
+#define OP_STORE    0x23
+#define OP_BRANCH   0x63
+#define OP_JAL      0x6f
+#define OP_JALR     0x67
+#define OP_SYSTEM   0x73
+#define OP_AMO      0x2f
+#define OP_FENCE    0x0f
+#define OP_FP       0x53
+
+#define EXIT_SYSCALL 0x666
+
+static u4 enc_r(u1 f7, u1 rs2, u1 rs1, u1 f3, u1 rd, u1 op) {
+    return ((u4)f7 << 25) | ((u4)rs2 << 20) | ((u4)rs1 << 15) | ((u4)f3 << 12) | ((u4)rd << 7) | op;
+}
+
+static u4 enc_i(i4 imm, u1 rs1, u1 f3, u1 rd, u1 op) {
+    return (((u4)imm & 0xfff) << 20) | ((u4)rs1 << 15) | ((u4)f3 << 12) | ((u4)rd << 7) | op;
+}
+
+static u4 enc_s(i4 imm, u1 rs2, u1 rs1, u1 f3, u1 op) {
+    const u4 v = (u4)imm;
+    return (((v >> 5) & 0x7f) << 25) | ((u4)rs2 << 20) | ((u4)rs1 << 15) | ((u4)f3 << 12) | ((v & 0x1f) << 7) | op;
+}
+
+static u4 enc_b(i4 off, u1 rs2, u1 rs1, u1 f3) {
+    const u4 v = (u4)off;
+    assert((off >= -4096) && (off < 4096));
+    return (((v >> 12) & 1) << 31) | (((v >> 5) & 0x3f) << 25) | ((u4)rs2 << 20) | ((u4)rs1 << 15) |
+        ((u4)f3 << 12) | (((v >> 1) & 0xf) << 8) | (((v >> 11) & 1) << 7) | OP_BRANCH;
+}
+
+static u4 enc_j(i4 off, u1 rd) {
+    const u4 v = (u4)off;
+    return (((v >> 20) & 1) << 31) | (((v >> 1) & 0x3ff) << 21) | (((v >> 11) & 1) << 20) |
+        (((v >> 12) & 0xff) << 12) | ((u4)rd << 7) | OP_JAL;
+}
+
+static void emit(prog_t *p, u4 inst) {
+    assert(p->len < PROG_MAX_INSTS);
+    p->inst[p->len++] = inst;
+}
+
+static i4 offset(u4 from, u4 to) {
+    return ((i4)to - (i4)from) * 4;
+}
+
+void prog_init(prog_t *p) {
+    p->len = 0;
+    p->num_checks = 0;
+}
+
+u4 prog_here(prog_t *p) {
+    return p->len;
+}
+
+void prog_org(prog_t *p, u4 at) {
+    assert(at >= p->len);
+    while (p->len < at) emit(p, 0);
+}
+
+void lui(prog_t *p, u1 rd, u4 imm) {
+    emit(p, (imm << 12) | ((u4)rd << 7) | OP_LUI);
+}
+
+void auipc(prog_t *p, u1 rd, u4 imm) {
+    emit(p, (imm << 12) | ((u4)rd << 7) | OP_AUIPC);
+}
+
+void addi(prog_t *p, u1 rd, u1 rs1, i4 imm) {
+    emit(p, enc_i(imm, rs1, 0, rd, OP_IMM));
+}
+
+void slli(prog_t *p, u1 rd, u1 rs1, u1 shamt) {
+    emit(p, enc_i(shamt & 0x3f, rs1, 1, rd, OP_IMM));
+}
+
+void srli(prog_t *p, u1 rd, u1 rs1, u1 shamt) {
+    emit(p, enc_i(shamt & 0x3f, rs1, 5, rd, OP_IMM));
+}
+
+void srai(prog_t *p, u1 rd, u1 rs1, u1 shamt) {
+    emit(p, enc_i(0x400 | (shamt & 0x3f), rs1, 5, rd, OP_IMM));
+}
+
+void add(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0, rs2, rs1, 0, rd, OP_REG));
+}
+
+void sub(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0x20, rs2, rs1, 0, rd, OP_REG));
+}
+
+void sll(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0, rs2, rs1, 1, rd, OP_REG));
+}
+
+void slt(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0, rs2, rs1, 2, rd, OP_REG));
+}
+
+void sltu(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0, rs2, rs1, 3, rd, OP_REG));
+}
+
+void xor(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0, rs2, rs1, 4, rd, OP_REG));
+}
+
+void srl(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0, rs2, rs1, 5, rd, OP_REG));
+}
+
+void sra(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0x20, rs2, rs1, 5, rd, OP_REG));
+}
+
+void or(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0, rs2, rs1, 6, rd, OP_REG));
+}
+
+void and(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0, rs2, rs1, 7, rd, OP_REG));
+}
+
+void li(prog_t *p, u1 rd, u4 val) {
+    i4 lo = val & 0xfff;
+    if (lo >= 0x800) lo -= 0x1000;
+    lui(p, rd, ((val - (u4)lo) >> 12) & 0xfffff);
+    addi(p, rd, rd, lo);
+}
+
+void lb(prog_t *p, u1 rd, u1 rs1, i4 imm) {
+    emit(p, enc_i(imm, rs1, 0, rd, OP_LOAD));
+}
+
+void lh(prog_t *p, u1 rd, u1 rs1, i4 imm) {
+    emit(p, enc_i(imm, rs1, 1, rd, OP_LOAD));
+}
+
+void lw(prog_t *p, u1 rd, u1 rs1, i4 imm) {
+    emit(p, enc_i(imm, rs1, 2, rd, OP_LOAD));
+}
+
+void lbu(prog_t *p, u1 rd, u1 rs1, i4 imm) {
+    emit(p, enc_i(imm, rs1, 4, rd, OP_LOAD));
+}
+
+void lhu(prog_t *p, u1 rd, u1 rs1, i4 imm) {
+    emit(p, enc_i(imm, rs1, 5, rd, OP_LOAD));
+}
+
+void sb(prog_t *p, u1 rs2, u1 rs1, i4 imm) {
+    emit(p, enc_s(imm, rs2, rs1, 0, OP_STORE));
+}
+
+void sh(prog_t *p, u1 rs2, u1 rs1, i4 imm) {
+    emit(p, enc_s(imm, rs2, rs1, 1, OP_STORE));
+}
+
+void sw(prog_t *p, u1 rs2, u1 rs1, i4 imm) {
+    emit(p, enc_s(imm, rs2, rs1, 2, OP_STORE));
+}
+
+void csrrw(prog_t *p, u1 rd, u2 csr, u1 rs1) {
+    emit(p, enc_i(csr, rs1, 1, rd, OP_SYSTEM));
+}
+
+void csrrs(prog_t *p, u1 rd, u2 csr, u1 rs1) {
+    emit(p, enc_i(csr, rs1, 2, rd, OP_SYSTEM));
+}
+
+void amoadd_w(prog_t *p, u1 rd, u1 rs1, u1 rs2) {
+    emit(p, enc_r(0, rs2, rs1, 2, rd, OP_AMO));
+}
+
+void fadd_s(prog_t *p, u1 frd, u1 frs1, u1 frs2, u1 rm) {
+    emit(p, enc_r(0x00, frs2, frs1, rm, frd, OP_FP));
+}
+
+void fcvt_w_s(prog_t *p, u1 rd, u1 frs1, u1 rm) {
+    emit(p, enc_r(0x60, 0, frs1, rm, rd, OP_FP));
+}
+
+void fmv_x_w(prog_t *p, u1 rd, u1 frs1) {
+    emit(p, enc_r(0x70, 0, frs1, 0, rd, OP_FP));
+}
+
+void fmv_w_x(prog_t *p, u1 frd, u1 rs1) {
+    emit(p, enc_r(0x78, 0, rs1, 0, frd, OP_FP));
+}
+
+void ecall(prog_t *p) {
+    emit(p, OP_SYSTEM);
+}
+
+void mret(prog_t *p) {
+    emit(p, 0x30200073);
+}
+
+void fence_i(prog_t *p) {
+    emit(p, enc_i(0, 0, 1, 0, OP_FENCE));
+}
+
+void beq(prog_t *p, u1 rs1, u1 rs2, u4 target) {
+    emit(p, enc_b(offset(p->len, target), rs2, rs1, 0));
+}
+
+void bne(prog_t *p, u1 rs1, u1 rs2, u4 target) {
+    emit(p, enc_b(offset(p->len, target), rs2, rs1, 1));
+}
+
+void blt(prog_t *p, u1 rs1, u1 rs2, u4 target) {
+    emit(p, enc_b(offset(p->len, target), rs2, rs1, 4));
+}
+
+void bge(prog_t *p, u1 rs1, u1 rs2, u4 target) {
+    emit(p, enc_b(offset(p->len, target), rs2, rs1, 5));
+}
+
+void bltu(prog_t *p, u1 rs1, u1 rs2, u4 target) {
+    emit(p, enc_b(offset(p->len, target), rs2, rs1, 6));
+}
+
+void bgeu(prog_t *p, u1 rs1, u1 rs2, u4 target) {
+    emit(p, enc_b(offset(p->len, target), rs2, rs1, 7));
+}
+
+void jal(prog_t *p, u1 rd, u4 target) {
+    emit(p, enc_j(offset(p->len, target), rd));
+}
+
+void jalr(prog_t *p, u1 rd, u1 rs1, i4 imm) {
+    emit(p, enc_i(imm, rs1, 0, rd, OP_JALR));
+}
+
+void prog_exit(prog_t *p, u4 status) {
+    li(p, A1, status);
+    addi(p, A0, ZERO, EXIT_SYSCALL);
+    ecall(p);
+}
+
+void prog_check(prog_t *p, u1 reg, u4 val) {
+    const u4 status = ++p->num_checks;
+    li(p, T2, val);
+    // skip the exit: li a1 (2), li a0 (1), ecall (1)
+    beq(p, reg, T2, prog_here(p) + 5);
+    prog_exit(p, status);
+}
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#pragma once
+
+#include <sled/types.h>
+
+// Minimal RV32 assembler for building test programs in memory.
+// Addresses in the program are instruction indices.
+
+#define PROG_MAX_INSTS  4096
+
+enum {
+    ZERO = 0, RA = 1, SP = 2, T0 = 5, T1 = 6, T2 = 7, S0 = 8, S1 = 9,
+    A0 = 10, A1 = 11, A2 = 12, A3 = 13, A4 = 14, A5 = 15, A6 = 16, A7 = 17,
+    S2 = 18, S3 = 19, S4 = 20, S5 = 21, S6 = 22, S7 = 23, T3 = 28, T4 = 29,
+};
+
+typedef struct {
+    u4 inst[PROG_MAX_INSTS];
+    u4 len;
+    u4 num_checks;
+} prog_t;
+
+void prog_init(prog_t *p);
+u4 prog_here(prog_t *p);
+// pad with illegal instructions up to index 'at'
+void prog_org(prog_t *p, u4 at);
+
+void lui(prog_t *p, u1 rd, u4 imm);
+void auipc(prog_t *p, u1 rd, u4 imm);
+void addi(prog_t *p, u1 rd, u1 rs1, i4 imm);
+void slli(prog_t *p, u1 rd, u1 rs1, u1 shamt);
+void srli(prog_t *p, u1 rd, u1 rs1, u1 shamt);
+void srai(prog_t *p, u1 rd, u1 rs1, u1 shamt);
+void add(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+void sub(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+void sll(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+void slt(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+void sltu(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+void xor(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+void srl(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+void sra(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+void or(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+void and(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+// lui and addi, always two instructions
+void li(prog_t *p, u1 rd, u4 val);
+void lb(prog_t *p, u1 rd, u1 rs1, i4 imm);
+void lh(prog_t *p, u1 rd, u1 rs1, i4 imm);
+void lw(prog_t *p, u1 rd, u1 rs1, i4 imm);
+void lbu(prog_t *p, u1 rd, u1 rs1, i4 imm);
+void lhu(prog_t *p, u1 rd, u1 rs1, i4 imm);
+void sb(prog_t *p, u1 rs2, u1 rs1, i4 imm);
+void sh(prog_t *p, u1 rs2, u1 rs1, i4 imm);
+void sw(prog_t *p, u1 rs2, u1 rs1, i4 imm);
+void csrrw(prog_t *p, u1 rd, u2 csr, u1 rs1);
+void csrrs(prog_t *p, u1 rd, u2 csr, u1 rs1);
+void amoadd_w(prog_t *p, u1 rd, u1 rs1, u1 rs2);
+// Single precision ops on f registers, with a rounding mode where they round.
+void fadd_s(prog_t *p, u1 frd, u1 frs1, u1 frs2, u1 rm);
+void fcvt_w_s(prog_t *p, u1 rd, u1 frs1, u1 rm);
+void fmv_x_w(prog_t *p, u1 rd, u1 frs1);
+void fmv_w_x(prog_t *p, u1 frd, u1 rs1);
+void ecall(prog_t *p);
+void mret(prog_t *p);
+void fence_i(prog_t *p);
+
+// Branch and jump targets are instruction indices, before or after this one.
+void beq(prog_t *p, u1 rs1, u1 rs2, u4 target);
+void bne(prog_t *p, u1 rs1, u1 rs2, u4 target);
+void blt(prog_t *p, u1 rs1, u1 rs2, u4 target);
+void bge(prog_t *p, u1 rs1, u1 rs2, u4 target);
+void bltu(prog_t *p, u1 rs1, u1 rs2, u4 target);
+void bgeu(prog_t *p, u1 rs1, u1 rs2, u4 target);
+void jal(prog_t *p, u1 rd, u4 target);
+void jalr(prog_t *p, u1 rd, u1 rs1, i4 imm);
+
+// Exit through the sled exit syscall with 'status' in a1.
+void prog_exit(prog_t *p, u4 status);
+// Exit with a status unique to this check unless reg == val. Clobbers t2.
+void prog_check(prog_t *p, u1 reg, u4 val);
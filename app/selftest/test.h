@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#pragma once
+
+#include <plat/platform.h>
+#include <sled/core.h>
+#include <sled/machine.h>
+
+#include "prog.h"
+
+// Machine level tests. Most tests build a small guest program that runs on the
+// simple platform and exits through the sled exit syscall, with a status of 0
+// on success or the number of the failed check. Tests with a run function
+// drive the host API or the core internals directly instead.
+
+#define MAX_CORES       8
+#define HANDLER_INDEX   0x100   // instruction index of the trap handler
+#define DATA_BASE       (PLAT_MEM_BASE + 0x100000)
+
+typedef struct test test_t;
+
+struct test {
+    const char *name;
+    void (*build)(prog_t *p);
+    u4 num_cores;               // 0 is one core
+    // optional change to the parameters of every core
+    void (*setup)(sl_core_params_t *params);
+    // optional check of the machine after the program passed
+    int (*check)(const test_t *t, sl_machine_t *m);
+    // host test, run in place of a guest program
+    int (*run)(const test_t *t);
+};
+
+// Test suites, each ended by an entry without a name.
+extern const test_t block_tests[];
+extern const test_t cache_tests[];
+extern const test_t dev_tests[];
+extern const test_t fp_tests[];
+extern const test_t machine_tests[];
+extern const test_t mapper_tests[];
+extern const test_t mem_tests[];
+
+// Guest program helpers
+
+void set_trap_handler(prog_t *p);
+// Handler tail that resumes after the trapping instruction. Clobbers t1.
+void skip_trap(prog_t *p);
+// write 'val' to the device register at 'reg' from the base in a2
+void reg_write(prog_t *p, u4 reg, u4 val);
+// Route intc input 'bit' to 'hart' alone and take its interrupt there.
+void enable_ext_irq(prog_t *p, u4 hart, u4 bit);
+// Spin until the handler has counted an interrupt in s1, or give up.
+void wait_for_irq(prog_t *p);
+
+// Machine helpers
+
+// Create the test machine with the program loaded at PLAT_MEM_BASE.
+int test_machine_create(const test_t *t, const prog_t *p, sl_machine_t **m_out);
+// Run until a core stops and check that it exited with a status of 0.
+int test_machine_run(const test_t *t, sl_machine_t *m);
+int test_expect_word(const test_t *t, sl_core_t *c, u8 addr, u4 val);
+// Print why test t failed and return SL_ERR.
+int test_fail(const test_t *t, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
@@ -27,6 +27,7 @@
 // #define ISSUE_INTERRUPT 1
 #define DEFAULT_STEP_COUNT 0
 #define DEFAULT_CONSOLE    0
+#define MAX_CORES          8
 
 #define BIN_FLAG_ELF        (1u << 0)
 #define BIN_FLAG_INIT       (1u << 1)
@@ -43,6 +44,7 @@ typedef struct {
     sl_machine_t *m;
     pthread_t core0;
     int core_id;
+    u4 num_cores;
 
     u8 steps;
     u8 entry;
@@ -60,6 +62,7 @@ typedef struct {
 
 static const struct option longopts[] = {
     { "console",   no_argument,        NULL,   'c' },
+    { "cores",     required_argument,  NULL,   3   },
     { "entry",     required_argument,  NULL,   'e' },
     { "help",      no_argument,        NULL,   'h' },
     { "kernel",    required_argument,  NULL,   'k' },
@@ -107,6 +110,11 @@ static void usage(void) {
     "       0 - don't trap anything except the emulator exit trap. Best for kernels that handle exceptions.\n"
     "       1 - trap all exceptions. Best for standalone binaries.\n"
     "\n"
+    "  --cores=<num>\n"
+    "       Number of cores to run, each on a thread of its own. Binaries are loaded by\n"
+    "       core 0 and all cores start at the entry point. Console and step options\n"
+    "       only apply to a single core. Default 1.\n"
+    "\n"
     "  --serial=<output>\n"
     "       Set serial input and output. Possible 'output' values are:\n"
     "         '-' direct io to stdio (default)\n"
@@ -219,6 +227,14 @@ static int parse_opts(int argc, char *argv[], sm_t *sm) {
             sm->top = true;
             break;
 
+        case 3:
+            sm->num_cores = strtoul(optarg, NULL, 0);
+            if ((sm->num_cores == 0) || (sm->num_cores > MAX_CORES)) {
+                fprintf(stderr, "invalid number of cores '%s'\n", optarg);
+                return -1;
+            }
+            break;
+
         default:
             fprintf(stderr, "invalid argument\n"); // which argument?
             return -1;
@@ -354,6 +370,11 @@ int simple_machine(sm_t *sm) {
         goto out_err_machine;
     }
 
+    if ((err = sl_machine_add_device(m, SL_DEV_SLED_DMA, PLAT_DMA_BASE, "dma0"))) {
+        fprintf(stderr, "add dma failed: %s\n", st_err(err));
+        goto out_err_machine;
+    }
+
     sl_dev_t *d = sl_machine_get_device_for_name(m, "uart0");
     sled_uart_set_channel(d, sm->uart_io, sm->uart_fd_in, sm->uart_fd_out);
 
@@ -363,28 +384,42 @@ int simple_machine(sm_t *sm) {
         fprintf(stderr, "intc set input failed: %s\n", st_err(err));
         goto out_err_machine;
     }
+    sl_dev_t *dma = sl_machine_get_device_for_name(m, "dma0");
+    if ((err = sled_intc_set_input(intc, dma, PLAT_INTC_DMA_IRQ_BIT))) {
+        fprintf(stderr, "intc set input failed: %s\n", st_err(err));
+        goto out_err_machine;
+    }
 
-    // create core
+    // create cores
 
+    static const char *core_names[MAX_CORES] = { "cpu0", "cpu1", "cpu2", "cpu3", "cpu4", "cpu5", "cpu6", "cpu7" };
     sl_core_params_t params = {};
-    params.arch = PLAT_CORE_ARCH;
-    params.subarch = PLAT_CORE_SUBARCH;
-    params.id = 0;
-    if (sm->trap)
-        params.options = SL_CORE_OPT_TRAP_SYSCALL | SL_CORE_OPT_TRAP_BREAKPOINT | SL_CORE_OPT_TRAP_ABORT | SL_CORE_OPT_TRAP_UNDEF | SL_CORE_OPT_TRAP_PREFETCH_ABORT;
-    else
-        params.options = SL_CORE_OPT_TRAP_SYSCALL;
-    params.arch_options = PLAT_ARCH_OPTIONS;
-    params.name = "cpu0";
-
-    if ((err = sl_machine_add_core(m, &params))) {
-        printf("sl_machine_add_core failed: %s\n", st_err(err));
-        goto out_err_machine;
+    d = sl_machine_get_device_for_name(m, "mpu0");
+    for (u4 i = 0; i < sm->num_cores; i++) {
+        params.arch = PLAT_CORE_ARCH;
+        params.subarch = PLAT_CORE_SUBARCH;
+        params.id = i;
+        if (sm->trap)
+            params.options = SL_CORE_OPT_TRAP_SYSCALL | SL_CORE_OPT_TRAP_BREAKPOINT | SL_CORE_OPT_TRAP_ABORT | SL_CORE_OPT_TRAP_UNDEF | SL_CORE_OPT_TRAP_PREFETCH_ABORT;
+        else
+            params.options = SL_CORE_OPT_TRAP_SYSCALL;
+        params.arch_options = PLAT_ARCH_OPTIONS;
+        params.name = core_names[i];
+
+        if ((err = sl_machine_add_core(m, &params))) {
+            printf("sl_machine_add_core failed: %s\n", st_err(err));
+            goto out_err_machine;
+        }
+        // every hart is protected by mpu0, whose events go to cpu0
+        sl_core_t *hart = sl_machine_get_core(m, i);
+        err = (i == 0) ? sl_core_set_mapper(hart, d) : sl_core_share_mapper(hart, d);
+        if (err < 0) {
+            fprintf(stderr, "set mpu for %s failed: %s\n", core_names[i], st_err(err));
+            goto out_err_machine;
+        }
     }
 
     sl_core_t *c = sl_machine_get_core(m, sm->core_id);
-    d = sl_machine_get_device_for_name(m, "mpu0");
-    sl_core_set_mapper(c, d);
 
     bool configured = false;
     for (bin_file_t *b = sm->bin_list; b != NULL; b = b->next) {
@@ -396,22 +431,44 @@ int simple_machine(sm_t *sm) {
             }
             const bool config = (b->flags & BIN_FLAG_INIT) ? true : false;
             if (config && configured) printf("warning: cpu already configured\n");
-            if ((err = sl_machine_load_core(m, params.id, eo, config))) {
+            if ((err = sl_machine_load_core(m, sm->core_id, eo, config))) {
                 fprintf(stderr, "sl_machine_load_core failed: %s\n", st_err(err));
                 goto out_err_machine;
             }
+            for (u4 i = 1; config && (i < sm->num_cores); i++) {
+                if ((err = sl_machine_configure_core(m, i, eo))) {
+                    fprintf(stderr, "sl_machine_configure_core failed: %s\n", st_err(err));
+                    goto out_err_machine;
+                }
+            }
             configured = true;
             sl_elf_close(eo);
             eo = NULL;
         } else {
-            if ((err = load_binary(m, params.id, b))) goto out_err_machine;
+            if ((err = load_binary(m, sm->core_id, b))) goto out_err_machine;
         }
     }
 
-    if (sm->entry != 0) sl_core_set_reg(c, SL_CORE_REG_PC, sm->entry);
+    if (sm->entry != 0) {
+        for (u4 i = 0; i < sm->num_cores; i++)
+            sl_core_set_reg(sl_machine_get_core(m, i), SL_CORE_REG_PC, sm->entry);
+    }
 
     // run
-    sm->core_id = params.id;
+    if (sm->num_cores > 1) {
+        // the first core to stop ends the run
+        u4 id;
+        if ((err = sl_machine_start(m))) {
+            fprintf(stderr, "sl_machine_start failed: %s\n", st_err(err));
+            goto out_err_machine;
+        }
+        err = sl_machine_wait(m, &id);
+        sl_machine_stop(m);
+        sl_machine_join(m);
+        c = sl_machine_get_core(m, id);
+        goto run_done;
+    }
+
     if ((err = start_thread_for_core(sm))) {
         fprintf(stderr, "start_thread_for_core failed\n");
         goto out_err_machine;
@@ -431,6 +488,7 @@ int simple_machine(sm_t *sm) {
     pthread_join(sm->core0, &retval);
     err = (int)(uintptr_t)retval;
 
+run_done:
     if (err == SL_OK) goto out;
     if (err != SL_ERR_SYSCALL) {
         printf("unexpected run status: %s\n", st_err(err));
@@ -453,7 +511,12 @@ int simple_machine(sm_t *sm) {
 
     // printf("success\n");
 out:
-    printf("%" PRIu64 " instructions dispatched\n", sl_core_get_cycles(c));
+    if (sm->num_cores > 1) {
+        for (u4 i = 0; i < sm->num_cores; i++)
+            printf("cpu%u: %" PRIu64 " instructions dispatched\n", i, sl_core_get_cycles(sl_machine_get_core(m, i)));
+    } else {
+        printf("%" PRIu64 " instructions dispatched\n", sl_core_get_cycles(c));
+    }
     sl_core_print_cache_stats(c);
     err = 0;
 
@@ -477,6 +540,7 @@ int main(int argc, char *argv[]) {
         .steps = DEFAULT_STEP_COUNT,
         .cons_on_err = DEFAULT_CONSOLE,
         .trap = true,
+        .num_cores = 1,
     };
 
     int ret = parse_opts(argc, argv, &sm);
@@ -33,3 +33,7 @@ LIB_CSOURCES += \
 	$(SRCDIR)/sym.c \
 	$(SRCDIR)/worker.c \
 
+ifeq ($(JIT),1)
+LIB_CSOURCES += $(SRCDIR)/jit_x64.c
+endif
+
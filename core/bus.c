@@ -54,6 +54,7 @@ int bus_add_mem_region(sl_bus_t *b, mem_region_t *r) {
     sl_mapping_t m = {};
     m.input_base = r->base;
     m.length = r->length;
+    m.permissions = SL_MAP_PERM_ALL;
     m.output_base = 0;
     m.type = SL_MAP_TYPE_MEMORY;
     m.ep = &r->ep;
@@ -68,6 +69,7 @@ int bus_add_device(sl_bus_t *b, sl_dev_t *dev, u8 base) {
     sl_mapping_t m = {};
     m.input_base = dev->base;
     m.length = dev->aperture;
+    m.permissions = SL_MAP_PERM_READ | SL_MAP_PERM_WRITE;
     m.output_base = 0;
     m.type = SL_MAP_TYPE_DEVICE;
     m.ep = &dev->map_ep;
@@ -87,7 +89,10 @@ int sl_bus_init(sl_bus_t *b, const char *name, sl_dev_config_t *cfg) {
     int err = sl_device_init(&b->dev, cfg);
     if (err) return err;
     mapper_init(&b->mapper);
-    sl_mapper_set_mode(&b->mapper, SL_MAP_OP_MODE_TRANSLATE);
+    if ((err = sl_mapper_set_mode(&b->mapper, SL_MAP_OP_MODE_TRANSLATE))) {
+        mapper_shutdown(&b->mapper);
+        return err;
+    }
     sl_device_set_context(&b->dev, b);
     sl_device_set_mapper(&b->dev, &b->mapper);
     sl_list_init(&b->mem_list);
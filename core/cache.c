@@ -6,36 +6,33 @@
 #include <string.h>
 
 #include <core/cache.h>
+#include <core/common.h>
+#include <sled/core.h>
 #include <sled/error.h>
 #include <sled/slac.h>
 
-#define DEFAULT_CACHE_SHIFT 12  // 4096
-
-static inline u1 base_hash(u8 base) {
-    return base & (SL_CACHE_ENTS - 1);
-}
-
 int sl_cache_rw_single(sl_cache_t *c, u8 addr, usize size, void *buf, bool read) {
     const u1 shift = c->page_shift;
     const u8 base = addr >> shift;
     const u8 offset = addr - (base << shift);
 
-    // is current page?
-    const u1 hash = base_hash(base);
-    if (base == c->page[hash].base) {
-        c->hash_hit++;
-        goto current_page;
+    sl_cache_page_t *pg = sl_cache_find_page(c, base);
+    if (pg == NULL) {
+        c->miss_addr = addr;
+        c->hash_miss++;
+        return SL_ERR_NOT_FOUND;
     }
 
-    c->miss_addr = addr;
-    c->hash_miss++;
-    return SL_ERR_NOT_FOUND;
-
-current_page:
-    if (read)
-        memcpy(buf, c->page[hash].buf + offset, size);
-    else
-        memcpy(c->page[hash].buf + offset, buf, size);
+    if (read) {
+        memcpy(buf, pg->buf + offset, size);
+    } else if (likely(pg->wbuf != NULL)) {
+        memcpy(pg->wbuf + offset, buf, size);
+    } else if (pg->code) {
+        memcpy(pg->buf + offset, buf, size);
+        sl_cache_code_written(c, pg, offset, size);
+    } else {
+        return SL_ERR_IO_PERM;
+    }
     return 0;
 }
 
@@ -67,73 +64,387 @@ int sl_cache_write(sl_cache_t *c, u8 addr, usize size, void *buf) {
     return cache_rw(c, addr, size, buf, false);
 }
 
-int sl_cache_get_instruction(sl_cache_t *c, u8 addr, sl_slac_inst_t **inst_out) {
+int sl_cache_get_instruction(sl_cache_t *c, u8 addr, sl_slac_inst_t **inst_out, sl_cache_page_t **pg_out) {
     const u1 shift = c->page_shift;
     const u8 base = addr >> shift;
     const u8 offset = addr - (base << shift);
-    const u1 hash = base_hash(base);
 
-    if (base != c->page[hash].base) {
+    sl_cache_page_t *pg = sl_cache_find_page(c, base);
+    if (pg == NULL) {
         c->miss_addr = addr;
         return SL_ERR_NOT_FOUND;
     }
-    *inst_out = &c->page[hash].decoded[offset / 2];
+    *inst_out = sl_cache_get_slot(c, pg, offset / 2);
+    *pg_out = pg;
     return 0;
 }
 
-void sl_cache_set_data_page(sl_cache_t *c, u8 addr, void *buf) {
-    const u1 shift = c->page_shift;
-    const u8 base = addr >> shift;
-    const u1 hash = base_hash(base);
-    c->page[hash].base = base;
-    c->page[hash].buf = buf;
+// Pick the page to replace for page number base: an empty way if the set has
+// one, otherwise the pseudo-LRU way. The chosen way becomes most recently used.
+static sl_cache_page_t *cache_replace(sl_cache_t *c, u8 base) {
+    sl_cache_page_t *set = &c->page[(base & c->set_mask) * c->ways];
+    u1 w;
+    for (w = 0; w < c->ways; w++) {
+        if (set[w].base == ~((u8)0)) break;
+    }
+    if (w == c->ways) {
+        u1 node = 1;
+        w = 0;
+        for (u1 half = c->ways >> 1; half != 0; half >>= 1) {
+            const u1 right = (set->plru >> (node - 1)) & 1;
+            if (right) w |= half;
+            node = (node * 2) + right;
+        }
+    }
+    if (c->ways > 1)
+        set->plru = sl_cache_plru_touch(set->plru, c->ways, w);
+    return &set[w];
 }
 
-void sl_cache_set_instruction_page(sl_cache_t *c, u8 addr, void *buf, bool overread) {
-    const u1 shift = c->page_shift;
-    const u8 base = addr >> shift;
-    const u1 hash = base_hash(base);
-    c->page[hash].base = base;
-    c->page[hash].buf = buf;
-
-    const u4 pg_size = 1u << shift;
-    sl_slac_inst_t *d = c->page[hash].decoded;
-    const u2 *inst = buf;
-    int i;
-    for (i = 0; i < (pg_size / 2) - 1; i++) {
-        d[i].raw = SLAC_IN_INVALID;
-        d[i].desc.machine_op = inst[0] | ((u4)inst[1] << 16);
-        inst++;
-    }
-    d[i].raw = SLAC_IN_INVALID;
-    if (overread) {
-        // buffer extends beyond page size.
-        // we can fetch the last bytes of unaligned instructions spanning page boundaries
-        d[i].desc.machine_op = inst[0] | ((u4)inst[1] << 16);
+static inline u4 dpage_hash(sl_cache_t *c, u8 base) {
+    return base & c->dhash_mask;
+}
+
+static inline u4 dpage_bhash(sl_cache_t *c, uptr buf) {
+    return (buf >> c->page_shift) & c->dhash_mask;
+}
+
+// Decoded slots are reset when the memory they were decoded from is written.
+// Slots up to 6 bytes before a write are reset too, as an instruction or fused
+// pair starting there may cover it. Blocks running into the reset slots are
+// marked to be built again, which also drops their compiled code.
+static void dpage_reset(sl_cache_t *c, sl_cache_dpage_t *dp, uptr lo, uptr hi) {
+    const uptr buf = (uptr)dp->buf;
+    const u4 slots = 1u << (c->page_shift - 1);
+    const u4 first = (lo > buf + 6) ? (lo - buf - 6) / 2 : 0;
+    u4 end = (hi - buf + 1) / 2;
+    if (end > slots) end = slots;
+
+    sl_slac_inst_t *d = dp->decoded;
+    for (u4 i = first; i < end; i++) {
+        if (d[i].fill == dp->fill) {
+            d[i].fill = 0;
+            d[i].blen = 0;
+        }
+    }
+    const u4 block_slots = SL_CACHE_BLOCK_BYTES / 2;
+    for (u4 i = (first > block_slots) ? first - block_slots : 0; i < first; i++)
+        d[i].blen = 0;
+}
+
+// Find the decoded pages filled from memory overlapping [lo, hi), and reset
+// their slots covering it if reset is set. Returns true if any were found.
+static bool code_scan(sl_cache_t *c, uptr lo, uptr hi, bool reset) {
+    // pages filled with overread are decoded up to 2 bytes past the end
+    const uptr span = (1u << c->page_shift) + 2;
+    const uptr first = (lo > span) ? (lo - span) >> c->page_shift : 0;
+    uptr last = (hi - 1) >> c->page_shift;
+    if (last - first > c->dhash_mask)
+        last = first + c->dhash_mask;
+
+    bool found = false;
+    for (uptr b = first; b <= last; b++) {
+        for (sl_cache_dpage_t *dp = c->bhash[b & c->dhash_mask]; dp != NULL; dp = dp->bnext) {
+            const uptr buf = (uptr)dp->buf;
+            if ((buf >= hi) || (buf + span <= lo)) continue;
+            if (!reset) return true;
+            dpage_reset(c, dp, lo, hi);
+            found = true;
+        }
+    }
+    return found;
+}
+
+// A data page overlapping decoded code was written. Once no code is left
+// anywhere in the page, writes to it are no longer checked.
+void sl_cache_code_written(sl_cache_t *c, sl_cache_page_t *pg, u8 offset, usize size) {
+    sl_cache_t *ic = c->peer;
+    const uptr lo = (uptr)pg->buf + offset;
+    if (code_scan(ic, lo, lo + size, true)) {
+        ic->code_write++;
+        return;
+    }
+    if (!code_scan(ic, (uptr)pg->buf, (uptr)pg->buf + (1u << c->page_shift), false)) {
+        pg->code = false;
+        pg->wbuf = pg->buf;
+    }
+}
+
+void sl_cache_host_written(sl_cache_t *c, uptr lo, uptr hi) {
+    if (code_scan(c, lo, hi, true))
+        c->code_write++;
+}
+
+void sl_cache_set_data_page(sl_cache_t *c, u8 addr, void *buf, bool writable) {
+    const u8 base = addr >> c->page_shift;
+    sl_cache_page_t *pg = cache_replace(c, base);
+    pg->base = base;
+    pg->buf = buf;
+    pg->code = writable && (c->peer != NULL) &&
+        code_scan(c->peer, (uptr)buf, (uptr)buf + (1u << c->page_shift), false);
+    pg->wbuf = (writable && !pg->code) ? buf : NULL;
+}
+
+// Mark the data pages overlapping memory that was just decoded.
+static void mark_code(sl_cache_t *c, uptr lo, uptr hi) {
+    const u4 num = (c->set_mask + 1) * c->ways;
+    const uptr size = 1u << c->page_shift;
+    for (u4 i = 0; i < num; i++) {
+        sl_cache_page_t *pg = &c->page[i];
+        if ((pg->base == ~((u8)0)) || (pg->wbuf == NULL)) continue;
+        const uptr buf = (uptr)pg->buf;
+        if ((buf < hi) && (buf + size > lo)) {
+            pg->code = true;
+            pg->wbuf = NULL;
+        }
+    }
+}
+
+static sl_cache_dpage_t *dpage_find(sl_cache_t *c, u8 base, void *buf) {
+    for (sl_cache_dpage_t *dp = c->dhash[dpage_hash(c, base)]; dp != NULL; dp = dp->next) {
+        if ((dp->base == base) && (dp->buf == buf))
+            return dp;
+    }
+    return NULL;
+}
+
+static void dpage_unlink(sl_cache_t *c, sl_cache_dpage_t *dp) {
+    sl_cache_dpage_t **p = &c->dhash[dpage_hash(c, dp->base)];
+    while (*p != dp) p = &(*p)->next;
+    *p = dp->next;
+    p = &c->bhash[dpage_bhash(c, (uptr)dp->buf)];
+    while (*p != dp) p = &(*p)->bnext;
+    *p = dp->bnext;
+}
+
+// Take a store entry for a page that hasn't been decoded yet. Entries in use
+// by the cache are never taken, and the store has more entries than the cache.
+// Returns NULL if the decode arrays of a new entry can't be allocated.
+static sl_cache_dpage_t *dpage_take(sl_cache_t *c, u8 base, void *buf) {
+    sl_cache_dpage_t *dp;
+    for ( ; ; ) {
+        dp = &c->dpage[c->dclock];
+        if (++c->dclock == c->dpage_num) c->dclock = 0;
+        if (dp->held) continue;
+        if (!dp->ref) break;
+        dp->ref = false;
+    }
+
+    if (dp->decoded == NULL) {
+#if SLAC_TRACE
+        void *p;
+        if (posix_memalign(&p, c->dalign_mask + 1, c->dpage_bytes))
+            return NULL;
+#else
+        void *p = malloc(c->dpage_bytes);
+        if (p == NULL) return NULL;
+#endif
+        // slot tags start out zero, which no filled page uses
+        memset(p, 0, c->dpage_bytes);
+        dp->decoded = p;
+    }
+
+    if (dp->base != ~((u8)0))
+        dpage_unlink(c, dp);
+    u4 hash = dpage_hash(c, base);
+    dp->base = base;
+    dp->buf = buf;
+    dp->next = c->dhash[hash];
+    c->dhash[hash] = dp;
+    hash = dpage_bhash(c, (uptr)buf);
+    dp->bnext = c->bhash[hash];
+    c->bhash[hash] = dp;
+
+    if (++dp->fill == 0) {
+        // Tags wrapped. Clear every slot tag so none can match the new page.
+        const u4 slots = 1u << (c->page_shift - 1);
+        for (u4 i = 0; i < slots; i++)
+            dp->decoded[i].fill = 0;
+        dp->fill = 1;
+    }
+    return dp;
+}
+
+int sl_cache_set_instruction_page(sl_cache_t *c, u8 addr, void *buf, bool overread) {
+    const u8 base = addr >> c->page_shift;
+    sl_cache_dpage_t *dp = dpage_find(c, base, buf);
+    if (dp != NULL) {
+        c->decode_hit++;
+        dp->ref = true;
     } else {
-        d[i].desc.machine_op = inst[0];
+        if ((dp = dpage_take(c, base, buf)) == NULL)
+            return SL_ERR_MEM;
+        c->decode_miss++;
+        if (c->peer != NULL)
+            mark_code(c->peer, (uptr)buf, (uptr)buf + (1u << c->page_shift) + 2);
     }
+
+    sl_cache_page_t *pg = cache_replace(c, base);
+    if (pg->dpage != NULL)
+        pg->dpage->held = false;
+    dp->held = true;
+
+    pg->base = base;
+    pg->buf = buf;
+    pg->overread = overread;
+    pg->decoded = dp->decoded;
+    pg->fill = dp->fill;
+    pg->dpage = dp;
+    return 0;
+}
+
+void sl_cache_reset_slot(sl_cache_t *c, sl_cache_page_t *pg, u4 slot) {
+    sl_slac_inst_t *si = &pg->decoded[slot];
+    si->raw = SLAC_IN_INVALID;
+    si->blen = 0;
+    si->fill = pg->fill;
 }
 
-int sl_cache_init(sl_cache_t *c, u1 type) {
-    c->page_shift = DEFAULT_CACHE_SHIFT;
+u4 sl_cache_machine_op(sl_cache_t *c, sl_cache_page_t *pg, u4 slot) {
+    const u4 last = (1u << (c->page_shift - 1)) - 1;
+    const u2 *inst = (const u2 *)pg->buf + slot;
+    // when the buffer extends beyond the page size, we can fetch the last
+    // bytes of unaligned instructions spanning page boundaries
+    if ((slot < last) || pg->overread)
+        return inst[0] | ((u4)inst[1] << 16);
+    return inst[0];
+}
+
+void sl_cache_invalidate_page(sl_cache_t *c, u8 addr) {
+    const u8 base = addr >> c->page_shift;
+    sl_cache_page_t *pg = sl_cache_find_page(c, base);
+    if (pg != NULL) {
+        pg->base = ~((u8)0);
+        pg->dpage = NULL;
+    }
+    if (c->dpage != NULL) {
+        // drop the decode results of the page, whatever memory they came from
+        sl_cache_dpage_t *dp = c->dhash[dpage_hash(c, base)];
+        while (dp != NULL) {
+            sl_cache_dpage_t *next = dp->next;
+            if (dp->base == base) {
+                dpage_unlink(c, dp);
+                dp->base = ~((u8)0);
+                dp->held = false;
+                dp->ref = false;
+            }
+            dp = next;
+        }
+    }
+}
+
+void sl_cache_invalidate_all(sl_cache_t *c) {
+    const u4 num = (c->set_mask + 1) * c->ways;
+    for (u4 i = 0; i < num; i++) {
+        c->page[i].base = ~((u8)0);
+        c->page[i].dpage = NULL;
+    }
+    if (c->dpage != NULL) {
+        // decode results are dropped too, fill tags are kept so slots of
+        // dropped pages don't match when an entry is taken again
+        for (u4 i = 0; i < c->dpage_num; i++) {
+            c->dpage[i].base = ~((u8)0);
+            c->dpage[i].held = false;
+            c->dpage[i].ref = false;
+        }
+        memset(c->dhash, 0, (c->dhash_mask + 1) * sizeof(sl_cache_dpage_t *));
+        memset(c->bhash, 0, (c->dhash_mask + 1) * sizeof(sl_cache_dpage_t *));
+    }
+}
+
+void sl_cache_drop_pages(sl_cache_t *c) {
+    const u4 num = (c->set_mask + 1) * c->ways;
+    for (u4 i = 0; i < num; i++) {
+        sl_cache_page_t *pg = &c->page[i];
+        if (pg->dpage != NULL) pg->dpage->held = false;
+        pg->base = ~((u8)0);
+        pg->dpage = NULL;
+    }
+}
+
+static inline bool is_pow2(u4 v) {
+    return (v != 0) && ((v & (v - 1)) == 0);
+}
+
+int sl_cache_init(sl_cache_t *c, u1 type, const sl_cache_geometry_t *g, u8 decode_budget) {
+    const u4 sets = g->sets ? g->sets : SL_CACHE_DEFAULT_SETS;
+    const u1 ways = g->ways ? g->ways : SL_CACHE_DEFAULT_WAYS;
+    const u1 shift = g->page_shift ? g->page_shift : SL_CACHE_DEFAULT_SHIFT;
+    if (!is_pow2(sets) || (sets > (1u << 20)) || !is_pow2(ways) || (ways > SL_CACHE_MAX_WAYS))
+        return SL_ERR_ARG;
+    if ((shift < SL_CACHE_MIN_SHIFT) || (shift > SL_CACHE_MAX_SHIFT))
+        return SL_ERR_ARG;
+
+    memset(c, 0, sizeof(*c));
+    c->page_shift = shift;
     c->type = type;
-    for (int i = 0; i < SL_CACHE_ENTS; i++)
+    c->ways = ways;
+    c->set_mask = sets - 1;
+    const u4 num = sets * ways;
+    c->page = calloc(num, sizeof(sl_cache_page_t));
+    if (c->page == NULL)
+        return SL_ERR_MEM;
+    for (u4 i = 0; i < num; i++)
         c->page[i].base = ~((u8)0);
-    c->hash_hit = 0;
-    c->hash_miss = 0;
+
     if (type == SL_CACHE_TYPE_INSTRUCTION) {
-        const u4 pg_bytes = 1u << c->page_shift;
-        const usize decode_size = (pg_bytes / 2) * sizeof(sl_slac_inst_t);
-        void *buf = malloc(SL_CACHE_ENTS * decode_size);
-        if (buf == NULL)
+        const u8 slots = 1u << (shift - 1);
+        u8 page_bytes = slots * sizeof(sl_slac_inst_t);
+#if SLAC_TRACE
+        c->desc_ext = page_bytes;
+        page_bytes += slots * sizeof(sl_slac_desc_t);
+        c->dalign_mask = 1;
+        while (c->dalign_mask < page_bytes - 1)
+            c->dalign_mask = (c->dalign_mask << 1) | 1;
+#endif
+        c->dpage_bytes = page_bytes;
+        // the store must have an entry to take while every way holds one
+        const u8 min_budget = (u8)(num + 1) * page_bytes;
+        if (decode_budget == 0) {
+            decode_budget = SL_CACHE_DEFAULT_DECODE_BUDGET;
+            if (decode_budget < min_budget) decode_budget = min_budget;
+        } else if (decode_budget < min_budget) {
+            sl_cache_shutdown(c);
+            return SL_ERR_ARG;
+        }
+        c->decode_budget = decode_budget;
+        u8 dnum = decode_budget / page_bytes;
+        if (dnum > SL_CACHE_MAX_DECODE_PAGES) dnum = SL_CACHE_MAX_DECODE_PAGES;
+        c->dpage_num = dnum;
+        c->dhash_mask = 1;
+        while (c->dhash_mask < dnum - 1)
+            c->dhash_mask = (c->dhash_mask << 1) | 1;
+
+        c->dpage = calloc(dnum, sizeof(sl_cache_dpage_t));
+        c->dhash = calloc(c->dhash_mask + 1, sizeof(sl_cache_dpage_t *));
+        c->bhash = calloc(c->dhash_mask + 1, sizeof(sl_cache_dpage_t *));
+        if ((c->dpage == NULL) || (c->dhash == NULL) || (c->bhash == NULL)) {
+            sl_cache_shutdown(c);
             return SL_ERR_MEM;
-        for (int i = 0; i < SL_CACHE_ENTS; i++) {
-            c->page[i].decoded = buf;
-            buf += decode_size;
         }
+        for (u4 i = 0; i < dnum; i++)
+            c->dpage[i].base = ~((u8)0);
     }
     return 0;
 }
 
-void sl_cache_shutdown(sl_cache_t *c) {}
+void sl_cache_get_geometry(sl_cache_t *c, sl_cache_geometry_t *g) {
+    g->sets = c->set_mask + 1;
+    g->ways = c->ways;
+    g->page_shift = c->page_shift;
+}
+
+void sl_cache_shutdown(sl_cache_t *c) {
+    if (c->dpage != NULL) {
+        for (u4 i = 0; i < c->dpage_num; i++)
+            free(c->dpage[i].decoded);
+    }
+    free(c->dpage);
+    free(c->dhash);
+    free(c->bhash);
+    free(c->page);
+    c->dpage = NULL;
+    c->dhash = NULL;
+    c->bhash = NULL;
+    c->page = NULL;
+}
@@ -5,6 +5,8 @@
 #include <inttypes.h>
 #include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <core/arch.h>
 #include <core/bus.h>
@@ -12,6 +14,7 @@
 #include <core/device.h>
 #include <core/core.h>
 #include <core/ex.h>
+#include <core/jit.h>
 #include <core/mapper.h>
 #include <core/sym.h>
 #include <sled/error.h>
@@ -32,7 +35,67 @@ void sl_core_config_get(sl_core_t *c, sl_core_params_t *p) {
     p->id = c->id;
     p->options = c->options;
     p->arch_options = c->arch_options;
+    p->poll_budget = c->poll_budget;
     p->name = c->name;
+    sl_cache_get_geometry(&c->icache, &p->icache);
+    sl_cache_get_geometry(&c->dcache, &p->dcache);
+    p->decode_budget = c->icache.decode_budget;
+}
+
+int sl_core_save_state(sl_core_t *c, sl_core_state_t **state_out) {
+    sl_core_state_t *s = malloc(sizeof(*s) + c->arch_state_len);
+    if (s == NULL) return SL_ERR_MEM;
+    sl_core_fp_flags_sync(c);
+    s->el = c->el;
+    s->mode = c->mode;
+    s->state = c->state;
+    s->pc = c->pc;
+    memcpy(s->r, c->r, sizeof(s->r));
+    s->fexc = c->fexc;
+    s->frm = c->frm;
+    memcpy(s->f, c->f, sizeof(s->f));
+    s->monitor_addr = c->monitor_addr;
+    s->monitor_value = c->monitor_value;
+    s->monitor_status = c->monitor_status;
+    s->ticks = c->ticks;
+    s->engine_state = c->engine.state;
+    s->irq_asserted = c->engine.irq_ep.asserted;
+    s->irq_retained = c->engine.irq_ep.retained;
+    s->arch_state_len = c->arch_state_len;
+    memcpy(s->arch_state, c->arch_state, c->arch_state_len);
+    *state_out = s;
+    return 0;
+}
+
+int sl_core_restore_state(sl_core_t *c, const sl_core_state_t *s) {
+    if (s->arch_state_len != c->arch_state_len) return SL_ERR_ARG;
+    c->el = s->el;
+    c->mode = s->mode;
+    c->state = s->state;
+    c->pc = s->pc;
+    memcpy(c->r, s->r, sizeof(c->r));
+    sl_core_fp_flags_sync(c);
+    c->fexc = s->fexc;
+    c->frm = s->frm;
+    memcpy(c->f, s->f, sizeof(c->f));
+    c->monitor_addr = s->monitor_addr;
+    c->monitor_value = s->monitor_value;
+    c->monitor_status = s->monitor_status;
+    c->ticks = s->ticks;
+    memcpy(c->arch_state, s->arch_state, s->arch_state_len);
+    // The engine's interrupt enable follows the arch state, and wfi decides
+    // whether the worker runs the core, so both go through their setters.
+    sl_irq_ep_t *ep = &c->engine.irq_ep;
+    ep->asserted = s->irq_asserted;
+    ep->retained = s->irq_retained;
+    sl_irq_mux_set_active(&ep->mux, ep->retained & ep->mux.enabled);
+    sl_engine_interrupt_set(&c->engine, s->engine_state & SL_CORE_STATE_INTERRUPTS_EN);
+    if (c->engine.worker != NULL) sl_engine_set_wfi(&c->engine, s->engine_state & SL_CORE_STATE_WFI);
+    c->prev_len = 0;
+    c->branch_taken = false;
+    sl_cache_invalidate_all(&c->icache);
+    sl_cache_invalidate_all(&c->dcache);
+    return 0;
 }
 
 static void config_set_internal(sl_core_t *c, sl_core_params_t *p) {
@@ -41,6 +104,7 @@ static void config_set_internal(sl_core_t *c, sl_core_params_t *p) {
     c->id = p->id;
     c->options = p->options;
     c->arch_options = p->arch_options;
+    c->poll_budget = p->poll_budget ? p->poll_budget : CORE_POLL_BUDGET;
     c->name = p->name;
     c->arch_ops = arch_get_ops(c->arch);
     c->bus = p->bus;
@@ -76,6 +140,8 @@ int sl_core_endian_set(sl_core_t *c, bool big) {
 
 void sl_core_instruction_barrier(sl_core_t *c) {
     atomic_thread_fence(memory_order_acquire);
+    // decoded pages outlive the icache, drop them in case code was written
+    sl_cache_invalidate_all(&c->icache);
 }
 
 void sl_core_memory_barrier(sl_core_t *c, u4 type) {
@@ -95,20 +161,47 @@ void sl_core_memory_barrier(sl_core_t *c, u4 type) {
     }
 }
 
+static void core_host_written(void *ctx, uptr lo, uptr hi) {
+    sl_cache_host_written(ctx, lo, hi);
+}
+
+// Host pointers in the caches come from mappings resolved through the core's
+// mappers, so the cached pages are dropped once one of them has changed.
+// Decoded pages are keyed by the memory they were decoded from and are kept,
+// less the code that other bus masters logged writes to on the bus mapper.
+// Changes made by this core through a device are seen right after the access,
+// changes made elsewhere at the next poll or device access.
+static inline void core_check_mappings(sl_core_t *c) {
+    sl_mapper_t *bm = bus_get_mapper(c->bus);
+    if (unlikely(mapper_write_seq(bm) != c->write_seq)) {
+        if (!mapper_logged_writes(bm, &c->write_seq, core_host_written, &c->icache))
+            sl_cache_invalidate_all(&c->icache);
+    }
+    const u4 gen = mapper_chain_gen(c->mapper);
+    if (likely(gen == c->map_gen)) return;
+    c->map_gen = gen;
+    sl_cache_drop_pages(&c->icache);
+    sl_cache_drop_pages(&c->dcache);
+}
+
 static inline u8 get_page_base(u8 addr, u1 page_shift) {
     return (addr >> page_shift) << page_shift;
 }
 
+// Cache the data page holding addr. Pages that aren't wholly backed by one
+// block of host memory, and memory that can't be read, are left to the mapper,
+// which also reports the error for an address that isn't mapped.
 static int fill_cache_for_addr(sl_core_t *c, u8 addr) {
     const u8 page_base = get_page_base(addr, c->dcache.page_shift);
     u8 len;
-    resultptr_t rp = sl_mapper_resolve(c->mapper, page_base, &len);
-    if (rp.err)
-        return rp.err;
-
-    // todo: handle cases where len is less than page size
-    // assert(len >= 1u << c->dcache.page_shift);
-    sl_cache_set_data_page(&c->dcache, page_base, rp.value);
+    u2 perm;
+    resultptr_t rp = sl_mapper_resolve(c->mapper, page_base, &len, &perm);
+    if (rp.err || (len < (1u << c->dcache.page_shift)))
+        return SL_ERR_IO_NOCACHE;
+    if ((perm & SL_MAP_PERM_READ) == 0)
+        return SL_ERR_IO_NOCACHE;
+
+    sl_cache_set_data_page(&c->dcache, page_base, rp.value, perm & SL_MAP_PERM_WRITE);
     return 0;
 }
 
@@ -150,6 +243,21 @@ int sl_core_mem_write_single(sl_core_t *c, u8 addr, u1 size, void *buf) {
     return sl_cache_rw_single(&c->dcache, addr, size, buf, false);
 }
 
+// drop host fp flags that weren't raised by guest instructions
+static inline void core_fp_flags_discard(void) {
+    const int raised = fetestexcept(FE_ALL_EXCEPT);
+    if (raised) feclearexcept(raised);
+}
+
+// Device handlers run host code that may raise fp flags of its own. Keep the
+// guest's flags and drop the device's.
+static int core_mapper_io(sl_core_t *c, sl_io_op_t *op) {
+    sl_core_fp_flags_sync(c);
+    const int err = sl_mapper_io(c->mapper, op);
+    core_fp_flags_discard();
+    return err;
+}
+
 int sl_core_mem_read(sl_core_t *c, u8 addr, u4 size, u4 count, void *buf) {
     sl_io_op_t op;
     op.addr = addr;
@@ -159,7 +267,24 @@ int sl_core_mem_read(sl_core_t *c, u8 addr, u4 size, u4 count, void *buf) {
     op.align = 1;
     op.buf = buf;
     op.agent = c;
-    return sl_mapper_io(c->mapper, &op);
+    const int err = core_mapper_io(c, &op);
+    core_check_mappings(c);
+    return err;
+}
+
+// Stores that miss the data cache can still land on memory code was decoded
+// from, such as a region too small to cache, or be made on behalf of the host.
+static void core_mapper_written(sl_core_t *c, u8 addr, u8 len) {
+    while (len > 0) {
+        u8 avail;
+        u2 perm;
+        resultptr_t rp = sl_mapper_resolve(c->mapper, addr, &avail, &perm);
+        if (rp.err) return;
+        if (avail > len) avail = len;
+        sl_cache_host_written(&c->icache, (uptr)rp.value, (uptr)rp.value + avail);
+        addr += avail;
+        len -= avail;
+    }
 }
 
 int sl_core_mem_write(sl_core_t *c, u8 addr, u4 size, u4 count, void *buf) {
@@ -171,7 +296,10 @@ int sl_core_mem_write(sl_core_t *c, u8 addr, u4 size, u4 count, void *buf) {
     op.align = 1;
     op.buf = buf;
     op.agent = c;
-    return sl_mapper_io(c->mapper, &op);
+    const int err = core_mapper_io(c, &op);
+    if (err == 0) core_mapper_written(c, addr, (u8)size * count);
+    core_check_mappings(c);
+    return err;
 }
 
 int sl_core_mem_atomic(sl_core_t *c, u8 addr, u4 size, u1 aop, u8 arg0, u8 arg1, u8 *result, u1 ord, u1 ord_fail) {
@@ -185,7 +313,27 @@ int sl_core_mem_atomic(sl_core_t *c, u8 addr, u4 size, u1 aop, u8 arg0, u8 arg1,
     op.arg[0] = arg0;
     op.arg[1] = arg1;
     op.agent = c;
-    int err = sl_mapper_io(c->mapper, &op);
+
+    // Atomics on writable RAM are done with host atomics on the data cache
+    // page, resetting any decoded code they land on as stores do. The rest,
+    // MMIO in particular, go through the mapper.
+    int err;
+    if ((addr & (size - 1)) == 0) {
+        sl_cache_t *dc = &c->dcache;
+        sl_cache_page_t *pg = sl_cache_find_page(dc, addr >> dc->page_shift);
+        if ((pg == NULL) && (fill_cache_for_addr(c, addr) == 0))
+            pg = sl_cache_find_page(dc, addr >> dc->page_shift);
+        if ((pg != NULL) && ((pg->wbuf != NULL) || pg->code)) {
+            const u8 offset = addr & ((1u << dc->page_shift) - 1);
+            if ((err = sl_io_for_data(pg->buf + offset, &op)))
+                return err;
+            if (pg->wbuf == NULL) sl_cache_code_written(dc, pg, offset, size);
+            *result = op.arg[0];
+            return 0;
+        }
+    }
+    err = core_mapper_io(c, &op);
+    core_check_mappings(c);
     if (err) return err;
     *result = op.arg[0];
     return 0;
@@ -201,59 +349,491 @@ u8 sl_core_get_reg(sl_core_t *c, u4 reg) {
 
 int sl_core_set_mapper(sl_core_t *c, sl_dev_t *d) {
     sl_mapper_t *m = sl_device_get_mapper(d);
-    m->next = c->mapper;
-    c->mapper = m;
+    // a mapper already in a chain is shared with sl_core_share_mapper
+    if (m->next != NULL) return SL_ERR_BUSY;
 
     u4 id;
     int err = sl_worker_add_event_endpoint(c->engine.worker, &d->event_ep, &id);
     if (err) return err;
     sl_device_set_worker(d, c->engine.worker, id);
+    m->next = c->mapper;
+    c->mapper = m;
+    c->map_gen = mapper_chain_gen(m);
     return id;
 }
 
-static int slac_dispatch(sl_core_t *c, sl_slac_inst_t *si) {
-    u1 len = si->len;
-    if (len == SLAC_IN_LEN_MODE) len = c->mode;
-    switch (len) {
-    case SLAC_IN_LEN_4:     return slac4_dispatch(c, si);
-    case SLAC_IN_LEN_8:     return slac8_dispatch(c, si);
+int sl_core_share_mapper(sl_core_t *c, sl_dev_t *d) {
+    sl_mapper_t *m = sl_device_get_mapper(d);
+    // the mapper leads to whatever it was set in front of
+    if (m->next != c->mapper) return SL_ERR_ARG;
+    c->mapper = m;
+    c->map_gen = mapper_chain_gen(m);
+    return 0;
+}
+
+// Resolve the register length of a decoded instruction so the handler needs
+// no mode checks. The mode is baked into the decoded page, which is why the
+// icache is flushed on a mode change.
+static int slac_bind(sl_core_t *c, sl_slac_inst_t *si) {
+    if (si->len == SLAC_IN_LEN_MODE) si->len = c->mode;
+    switch (si->len) {
+    case SLAC_IN_LEN_4:     slac4_bind(si);     return 0;
+    case SLAC_IN_LEN_8:     slac8_bind(si);     return 0;
     default:                return SL_ERR_STATE;
     }
 }
 
-int sl_core_step(sl_core_t *c, u8 num) {
-    for (u8 i = 0; i < num; i++) {
+// Blocks are runs of straight-line instructions in a decoded icache page.
+// A block ends at a branch, a system op, the end of the page, or the first
+// instruction that cannot be decoded to slac. Every slot in a block records
+// the number of instructions left until the block ends, so a block can be
+// entered at any instruction and the page decode data is the block store.
+
+#define CORE_BLOCK_MAX  64  // at most 4 bytes each, see SL_CACHE_BLOCK_BYTES
+
+static bool slac_ends_block(sl_slac_inst_t *si) {
+    switch (si->type) {
+    case SLAC_TYPE_BR:
+        return true;
+
+    case SLAC_TYPE_SYS:
+        switch (si->func) {
+        case SLAC_FUNC_MOVR:
+        case SLAC_FUNC_MOVI:
+        case SLAC_FUNC_ADR4K:
+        case SLAC_FUNC_NOP:
+            return false;
+        default:
+            return true;
+        }
+
+    default:
+        return false;
+    }
+}
+
+#if !SLAC_TRACE
+
+// Common instruction pairs that build a single value are fused into one slac
+// op on the first instruction. The second instruction stays decoded in its
+// own slot so it can still be a branch target.
+//   lui + addi         -> movi
+//   auipc + addi       -> adr4k
+//   auipc + jalr       -> bl
+//   auipc + load       -> pc relative load
+//   slli + srli        -> zext
+// Both instructions must write the same register, which the second one reads.
+// Pairs whose combined immediate doesn't fit the slot's 32 bit imm stay apart.
+
+static inline bool slac_can_lead_fusion(sl_slac_inst_t *si) {
+    if (si->type == SLAC_TYPE_SYS)
+        return (si->func == SLAC_FUNC_MOVI) || (si->func == SLAC_FUNC_ADR4K);
+    return (si->type == SLAC_TYPE_ALU) && (si->func == SLAC_FUNC_SHL) && (si->arg == SLAC_IN_ARG_DRI);
+}
+
+// value written by an alu op with the register length of si
+static inline u8 slac_alu_result(sl_slac_inst_t *si, u8 v) {
+    if (si->len == SLAC_IN_LEN_8) return v;
+    return si->sx8 ? (u8)(i8)(i4)v : (u4)v;
+}
+
+// whether v survives being stored in the imm of si, which is sign extended to
+// the register length when read
+static inline bool slac_imm_fits(sl_slac_inst_t *si, u8 v) {
+    return (si->len != SLAC_IN_LEN_8) || (v == (u8)(i8)(i4)v);
+}
+
+static bool slac_fuse(sl_slac_inst_t *si, sl_slac_inst_t *next) {
+    const u1 rd = si->d0;
+    if (next->fused || (next->d0 != rd) || (next->r0 != rd) || (rd == SLAC_REG_DISCARD))
+        return false;
+
+    if (si->type == SLAC_TYPE_ALU) {
+        if ((next->type != SLAC_TYPE_ALU) || (next->func != SLAC_FUNC_SHR) || (next->arg != SLAC_IN_ARG_DRI))
+            return false;
+        if ((next->imm != si->imm) || (next->len != si->len) || si->sx8 || next->sx8)
+            return false;
+        const u1 bits = (si->len == SLAC_IN_LEN_8) ? 64 : 32;
+        if ((u4)si->imm >= bits) return false;
+        si->func = SLAC_FUNC_ZEXT;
+        return true;
+    }
+
+    const bool adr = (si->func == SLAC_FUNC_ADR4K);
+    u8 v = (u8)(i8)si->imm + (u8)(i8)next->imm;
+    switch (next->type) {
+    case SLAC_TYPE_ALU:
+        if ((next->func != SLAC_FUNC_ADD) || (next->arg != SLAC_IN_ARG_DRI)) return false;
+        if (!adr) v = slac_alu_result(next, v);
+        else if ((next->len != si->len) || next->sx8) return false;
+        if (!slac_imm_fits(si, v)) return false;
+        si->imm = (i4)v;
+        return true;
+
+    case SLAC_TYPE_BR:
+        if (!adr || (next->func != SLAC_FUNC_BL) || (next->arg != SLAC_IN_ARG_DRI)) return false;
+        if (!slac_imm_fits(si, v)) return false;
+        si->type = SLAC_TYPE_BR;
+        si->func = SLAC_FUNC_BL;
+        si->imm = (i4)v;
+        si->r2 = slac_inst_len(si) + next->r2;
+        return true;
+
+    case SLAC_TYPE_LD:
+        if (!adr || (next->func > SLAC_FUNC_LD8)) return false;
+        if (!slac_imm_fits(si, v)) return false;
+        si->type = SLAC_TYPE_LD;
+        si->func = next->func;
+        si->arg = next->arg;
+        si->len = next->len;
+        si->r0 = SLAC_REG_PC;
+        si->imm = (i4)v;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+#endif // !SLAC_TRACE
+
+// Decode and bind the instruction at pc, in slot of pg. On failure the slot is
+// left for the slow path to handle when it is reached.
+static int core_decode_slot(sl_core_t *c, sl_cache_page_t *pg, u4 slot, u8 pc) {
+    sl_slac_inst_t *si = &pg->decoded[slot];
+    int err;
+    c->pc = pc;
+#if SLAC_TRACE
+    c->trace_desc = sl_cache_desc(&c->icache, si);
+#endif
+    if ((err = c->decode(c, si, sl_cache_machine_op(&c->icache, pg, slot))) || (err = slac_bind(c, si)))
+        si->raw = SLAC_IN_INVALID;
+    return err;
+}
+
+u4 sl_core_machine_op(sl_core_t *c) {
+    const u1 shift = c->icache.page_shift;
+    sl_cache_page_t *pg = sl_cache_find_page(&c->icache, c->pc >> shift);
+    if (pg == NULL) return 0;
+    return sl_cache_machine_op(&c->icache, pg, (c->pc & ((1u << shift) - 1)) / 2);
+}
+
+// Decode forward from the instruction at c->pc in page pg and mark the block.
+// Returns the decode error if the first instruction can't be decoded.
+static int core_build_block(sl_core_t *c, sl_cache_page_t *pg, sl_slac_inst_t *si) {
+    const u8 pc = c->pc;
+    const u4 page_mask = (1u << c->icache.page_shift) - 1;
+    const u4 page_slots = (page_mask + 1) / 2;
+    u4 slot = (pc & page_mask) / 2;
+    sl_slac_inst_t *p;
+    u4 n = 0;
+    int err = 0;
+
+    while ((n < CORE_BLOCK_MAX) && (slot < page_slots)) {
+        p = sl_cache_get_slot(&c->icache, pg, slot);
+        if (p->raw == SLAC_IN_INVALID) {
+            const u8 ipc = pc + (slot * 2) - (pc & page_mask);
+            if ((err = core_decode_slot(c, pg, slot, ipc))) break;
+#if !SLAC_TRACE
+            // traces show every guest instruction, so nothing is fused
+            const u1 slots = slac_inst_len(p) / 2;
+            if (slac_can_lead_fusion(p) && (slot + slots < page_slots)) {
+                sl_slac_inst_t *q = sl_cache_get_slot(&c->icache, pg, slot + slots);
+                sl_slac_inst_t f = *p;
+                if (((q->raw != SLAC_IN_INVALID) || !core_decode_slot(c, pg, slot + slots, ipc + slots * 2)) &&
+                    slac_fuse(&f, q)) {
+                    f.fused = slac_inst_len(q) / 2;
+                    slac_bind(c, &f);
+                    *p = f;
+                }
+            }
+#endif
+        }
+        // a fused op retires two, leave it to the next block if it doesn't fit
+        if (n + slac_inst_count(p) > CORE_BLOCK_MAX) break;
+        n += slac_inst_count(p);
+        if (slac_ends_block(p)) break;
+        slot += slac_inst_len(p) / 2;
+    }
+    c->pc = pc;
+    if (n == 0) return err;
+
+    p = si;
+    for (u4 left = n; left > 0; left -= slac_inst_count(p), p += slac_inst_len(p) / 2) {
+        p->blen = left;
+#if WITH_JIT
+        p->heat = 0;
+        if (c->jit != NULL)
+            sl_jit_forget(c->jit, p);
+#endif
+    }
+    return 0;
+}
+
+// Run a fused pair at pc, which retires as two instructions. When only one
+// more instruction may retire, or the fused op can't complete as a whole, the
+// first instruction is decoded again from its machine op and run on its own.
+// The second one is still decoded in the next slot. len is set to the bytes run.
+static int core_exec_fused(sl_core_t *c, sl_slac_inst_t *si, u8 pc, u8 left, u1 *len) {
+    int err;
+    if ((left > 1) && ((err = slac_exec(c, si)) != SL_ERR_SLAC_SPLIT)) {
+        *len = slac_inst_len(si);
+        return err;
+    }
+
+    sl_slac_inst_t u = {};
+    c->pc = pc;
+    if ((err = c->decode(c, &u, sl_core_machine_op(c))) || (err = slac_bind(c, &u)))
+        return err;
+    *len = slac_inst_len(&u);
+    return slac_exec(c, &u);
+}
+
+// Execute up to max instructions of the block starting at si.
+// c->pc is only kept current for instructions that can observe it.
+static int core_exec_block(sl_core_t *c, sl_slac_inst_t *si, u8 max, u8 *count) {
+    u8 n = si->blen;
+    if (n > max) n = max;
+    u8 pc = c->pc;
+    int err = 0;
+    u8 i = 0;
+
+#if WITH_JIT
+    if ((n == si->blen) && (c->jit != NULL)) {
+        if ((si->heat < JIT_HOT_COUNT) && (++si->heat == JIT_HOT_COUNT))
+            sl_jit_compile(c->jit, c, si);
+        if (si->heat == JIT_HOT_COUNT) {
+            sl_jit_block_t code = sl_jit_lookup(c->jit, si);
+            if (code == NULL) {
+                // the code was dropped, count up to compiling it again
+                si->heat = 0;
+            } else {
+                err = code(c, &i);
+                if (err != SL_ERR_SLAC_SPLIT) {
+                    if (c->branch_taken) c->prev_len = 4;
+                    goto out;
+                }
+                // finish the block here from the fused instruction
+                si += (c->pc - pc) / 2;
+                pc = c->pc;
+            }
+        }
+    }
+#endif
+
+    for ( ; i < n; i++) {
+        if (si->type != SLAC_TYPE_ALU) c->pc = pc;
+        if (unlikely(si->fused)) {
+            u1 len;
+            if ((err = core_exec_fused(c, si, pc, n - i, &len))) {
+                c->pc = pc;
+                goto out;
+            }
+            if (len != (si->sh ? 2 : 4)) i++;
+            pc += len;
+            si += len / 2;
+        } else {
+            if ((err = slac_exec(c, si))) {
+                c->pc = pc;
+                goto out;
+            }
+            // Branch on the encoding size instead of computing the step, so
+            // the next instruction doesn't wait on this one being loaded.
+            if (si->sh) {
+                pc += 2;
+                si += 1;
+            } else {
+                pc += 4;
+                si += 2;
+            }
+        }
+        if (c->branch_taken) {
+            // branch or synchronous exception
+            c->prev_len = 4;
+            i++;
+            goto out;
+        }
+    }
+    c->pc = pc;
+
+out:
+    c->ticks += i;
+    *count = i;
+    return err;
+}
+
+// Find the page to run c->pc from after the block at pc in page pg, without
+// going through the icache. Targets in the same page stay in pg, others come
+// from the branch target cache. The page may have been refilled since, and
+// events may move c->pc, so core_chained_slot checks both before use.
+static sl_cache_page_t *core_chain(sl_core_t *c, sl_cache_page_t *pg, u8 pc) {
+    const u8 next = c->pc;
+    const u1 shift = c->icache.page_shift;
+    if ((next >> shift) == (pc >> shift)) return pg;
+
+    sl_btc_entry_t *e = &c->btc[(next >> 1) & (CORE_BTC_ENTS - 1)];
+    if (e->pc == next) return e->pg;
+    return NULL;
+}
+
+// Decoded instruction at c->pc in chained page pg, NULL if pg no longer holds
+// the page of c->pc or pc is misaligned. Only the page's own tag is checked,
+// so filling other pages doesn't break the chain, and its slots are reset
+// through their fill tag if the page was refilled.
+static inline sl_slac_inst_t *core_chained_slot(sl_core_t *c, sl_cache_page_t *pg) {
+    const u1 shift = c->icache.page_shift;
+    if ((c->pc & 1) || (pg->base != (c->pc >> shift))) return NULL;
+    return sl_cache_get_slot(&c->icache, pg, (c->pc & ((1u << shift) - 1)) / 2);
+}
+
+void sl_core_fp_flags_sync(sl_core_t *c) {
+    const int raised = fetestexcept(FE_ALL_EXCEPT);
+    if (raised) {
+        c->fexc |= raised;
+        feclearexcept(raised);
+    }
+}
+
+// Ties to max magnitude has no host mode. Arithmetic in it rounds ties to
+// even, conversions to integers round ties away from zero.
+void sl_core_fp_set_round(sl_core_t *c, u1 rm) {
+    static const int host_mode[] = { FE_TONEAREST, FE_TOWARDZERO, FE_DOWNWARD, FE_UPWARD, FE_TONEAREST };
+    fesetround(host_mode[rm]);
+    c->host_rm = rm;
+}
+
+// hand the host fp environment back to other code
+static inline void core_fp_leave(sl_core_t *c) {
+    sl_core_fp_flags_sync(c);
+    if (c->host_rm != SLAC_RM_NEAREST)
+        sl_core_fp_set_round(c, SLAC_RM_NEAREST);
+}
+
+// Read the machine op at c->pc straight from the memory backing it, for code
+// in a page that can't be cached.
+static int core_fetch_uncached(sl_core_t *c, u4 *op) {
+    u8 len;
+    u2 perm;
+    resultptr_t rp = sl_mapper_resolve(c->mapper, c->pc, &len, &perm);
+    if (rp.err)
+        return rp.err;
+    if ((perm & SL_MAP_PERM_EXEC) == 0)
+        return SL_ERR_IO_PERM;
+    if (len < 2)
+        return SL_ERR_IO_NOMAP;
+    const u2 *inst = rp.value;
+    *op = inst[0];
+    if (len >= 4)
+        *op |= (u4)inst[1] << 16;
+    return 0;
+}
+
+// Run one instruction through the dispatch path, outside of any block.
+static int core_dispatch_one(sl_core_t *c, u4 op) {
+    c->branch_taken = false;
+    const int err = c->dispatch(c, op);
+    if (err) return err;
+    c->ticks++;
+    if (c->branch_taken)
+        c->prev_len = 4;
+    else
+        sl_core_next_pc(c);
+    return 0;
+}
+
+// Decode and run the instruction at c->pc in a slot of the core, for code in
+// a page that can't be cached.
+static int core_exec_uncached(sl_core_t *c, u4 op) {
+    sl_slac_inst_t *si = &c->uncached;
+    *si = (sl_slac_inst_t){};
+#if SLAC_TRACE
+    c->trace_desc = &c->uncached_desc;
+#endif
+    int err;
+    if ((err = c->decode(c, si, op)) || (err = slac_bind(c, si))) {
+        if (err == SL_ERR_SLAC_UNDECODED)
+            return core_dispatch_one(c, op);
+        return err;
+    }
+    c->branch_taken = false;
+    if ((err = slac_exec(c, si)))
+        return err;
+    c->ticks++;
+    if (c->branch_taken)
+        c->prev_len = 4;
+    else
+        c->pc += slac_inst_len(si);
+    return 0;
+}
+
+static int core_step(sl_core_t *c, u8 num) {
+    sl_cache_page_t *next = NULL;
+    u8 i = 0;
+    u8 poll_at = 0;
+    while (i < num) {
         int err;
-        if ((err = sl_worker_handle_events(c->engine.worker)))
-            return err;
+        // Events are checked at block boundaries once the poll budget has run
+        // out, or right away when the core has stopped itself (wfi).
+        if ((i >= poll_at) || CORE_IS_WFI(c->engine.state)) {
+            core_fp_leave(c);
+            err = sl_worker_handle_events(c->engine.worker);
+            core_fp_flags_discard();
+            if (err) return err;
+            core_check_mappings(c);
+            poll_at = i + c->poll_budget;
+        }
 
-        sl_slac_inst_t *si;
-        if ((err = sl_core_load_pc(c, &si)))
-            return sl_core_synchronous_exception(c, EX_ABORT_INST, c->pc, err);
+        sl_cache_page_t *pg = next;
+        sl_slac_inst_t *si = (pg != NULL) ? core_chained_slot(c, pg) : NULL;
+        if (si == NULL) {
+            if ((err = sl_core_load_pc(c, &si, &pg))) {
+                if (err != SL_ERR_IO_NOCACHE)
+                    return sl_core_synchronous_exception(c, EX_ABORT_INST, c->pc, err);
+                // code in memory too small to cache runs an instruction at a time
+                u4 op;
+                if ((err = core_fetch_uncached(c, &op)))
+                    return sl_core_synchronous_exception(c, EX_ABORT_INST, c->pc, err);
+                if ((err = core_exec_uncached(c, op)))
+                    return err;
+                i++;
+                continue;
+            }
+            sl_btc_entry_t *e = &c->btc[(c->pc >> 1) & (CORE_BTC_ENTS - 1)];
+            e->pc = c->pc;
+            e->pg = pg;
+        }
         c->branch_taken = false;
+        next = NULL;
 
-        if (si->raw == SLAC_IN_INVALID) {
-            if ((err = c->decode(c, si))) {
+        if (si->blen == 0) {
+            if ((err = core_build_block(c, pg, si))) {
                 // temporary until all instructions can be decoded
                 if (err != SL_ERR_SLAC_UNDECODED)
                     return err;
-                if ((err = c->dispatch(c, si->desc.machine_op)))
+                if ((err = core_dispatch_one(c, sl_core_machine_op(c))))
                     return err;
-                goto dispatch_done;
+                i++;
+                continue;
             }
         }
-        if ((err = slac_dispatch(c, si))) return err;
 
-dispatch_done:
-        c->ticks++;
-        if (c->branch_taken)
-            c->prev_len = 4;
-        else
-            sl_core_next_pc(c);
+        u8 count;
+        const u8 pc = c->pc;
+        err = core_exec_block(c, si, num - i, &count);
+        i += count;
+        if (err) return err;
+        next = core_chain(c, pg, pc);
     }
     return 0;
 }
 
+int sl_core_step(sl_core_t *c, u8 num) {
+    core_fp_flags_discard();
+    const int err = core_step(c, num);
+    core_fp_leave(c);
+    return err;
+}
+
 int sl_core_run(sl_core_t *c) {
     for ( ; ; ) {
         int err = sl_core_step(c, 0x80000000);
@@ -262,7 +842,9 @@ int sl_core_run(sl_core_t *c) {
 }
 
 void sl_core_set_mode(sl_core_t *c, u1 mode) {
+    if (c->mode == mode) return;
     c->mode = mode;
+    sl_cache_invalidate_all(&c->icache);
 }
 
 u4 sl_core_get_reg_count(sl_core_t *c, int type) {
@@ -297,10 +879,10 @@ void sl_core_next_pc(sl_core_t *c) {
     c->prev_len = 4;       // todo: fix me in decoder
 }
 
-int sl_core_load_pc(sl_core_t * restrict c, sl_slac_inst_t ** restrict inst_out) {
+int sl_core_load_pc(sl_core_t * restrict c, sl_slac_inst_t ** restrict inst_out, sl_cache_page_t ** restrict pg_out) {
     // todo extras: check alignment of pc
 
-    int err = sl_cache_get_instruction(&c->icache, c->pc, inst_out);
+    int err = sl_cache_get_instruction(&c->icache, c->pc, inst_out, pg_out);
     if (err != SL_ERR_NOT_FOUND)
         return err;
 
@@ -308,16 +890,21 @@ int sl_core_load_pc(sl_core_t * restrict c, sl_slac_inst_t ** restrict inst_out)
     const u1 shift = c->icache.page_shift;
     const u8 base = (miss_addr >> shift) << shift;
 
+    // code in a page that isn't wholly backed by host memory can't be cached
     u8 len;
-    resultptr_t result = sl_mapper_resolve(c->mapper, base, &len);
-    if (result.err)
-        return result.err;
+    u2 perm;
+    resultptr_t result = sl_mapper_resolve(c->mapper, base, &len, &perm);
+    if (result.err || (len < (1u << shift)))
+        return SL_ERR_IO_NOCACHE;
+    if ((perm & SL_MAP_PERM_EXEC) == 0)
+        return SL_ERR_IO_PERM;
     bool overread = false;
     if (len >= (1u << shift) + 2)
         overread = true;
-    sl_cache_set_instruction_page(&c->icache, base, result.value, overread);
+    if ((err = sl_cache_set_instruction_page(&c->icache, base, result.value, overread)))
+        return err;
 
-    if ((err = sl_cache_get_instruction(&c->icache, c->pc, inst_out)))
+    if ((err = sl_cache_get_instruction(&c->icache, c->pc, inst_out, pg_out)))
         return SL_ERR_STATE;    // this shouldn't happen if fill_cache_page did its job
     return 0;
 }
@@ -341,13 +928,25 @@ int sl_core_init(sl_core_t *c, sl_core_params_t *p, sl_mapper_t *m) {
     c->mode = SL_CORE_MODE_4;
     c->prev_len = 0;
     c->monitor_status = MONITOR_UNARMED;
+    for (int i = 0; i < CORE_BTC_ENTS; i++)
+        c->btc[i].pc = ~((u8)0);
     config_set_internal(c, p);
-    if ((err = sl_cache_init(&c->icache, SL_CACHE_TYPE_INSTRUCTION)))
+    if ((err = sl_cache_init(&c->icache, SL_CACHE_TYPE_INSTRUCTION, &p->icache, p->decode_budget)))
         return err;
-    if ((err = sl_cache_init(&c->dcache, SL_CACHE_TYPE_DATA))) {
+    if ((err = sl_cache_init(&c->dcache, SL_CACHE_TYPE_DATA, &p->dcache, 0))) {
         sl_cache_shutdown(&c->icache);
         return err;
     }
+    c->map_gen = mapper_chain_gen(c->mapper);
+    c->write_seq = mapper_write_seq(bus_get_mapper(c->bus));
+    // stores through the dcache reset the decoded code they overwrite
+    c->icache.peer = &c->dcache;
+    c->dcache.peer = &c->icache;
+#if WITH_JIT
+    // the jit is optional, run interpreted if it can't be set up
+    if (sl_jit_create(&c->jit, JIT_ARENA_SIZE))
+        c->jit = NULL;
+#endif
     sl_engine_init(&c->engine, "core_eng", NULL);
     c->engine.ops.step = eng_op_step;
     c->engine.ops.run = eng_op_run;
@@ -360,6 +959,10 @@ void sl_core_shutdown(sl_core_t *c) {
     sl_engine_shutdown(&c->engine);
     sl_cache_shutdown(&c->icache);
     sl_cache_shutdown(&c->dcache);
+#if WITH_JIT
+    if (c->jit != NULL)
+        sl_jit_destroy(c->jit);
+#endif
 #if WITH_SYMBOLS
     sl_sym_list_t *n = NULL;
     for (sl_sym_list_t *s = c->symbols; s != NULL; s = n) {
@@ -378,7 +981,18 @@ void sl_core_print_bus_topology(sl_core_t *c) {
 }
 
 void sl_core_print_cache_stats(sl_core_t *c) {
-    printf("dcache\n  hash_hit:  %" PRIu64 "\n  hash_miss: %" PRIu64 "\n", c->dcache.hash_hit, c->dcache.hash_miss);
+    printf("dcache (%u sets, %u ways, %u byte pages)\n", c->dcache.set_mask + 1, c->dcache.ways, 1u << c->dcache.page_shift);
+    printf("  hash_miss: %" PRIu64 "\n", c->dcache.hash_miss);
+    printf("icache (%u sets, %u ways, %u byte pages)\n", c->icache.set_mask + 1, c->icache.ways, 1u << c->icache.page_shift);
+    printf("  decode_hit:  %" PRIu64 "\n  decode_miss: %" PRIu64 "\n", c->icache.decode_hit, c->icache.decode_miss);
+    printf("  code_write:  %" PRIu64 "\n", c->icache.code_write);
+#if WITH_JIT
+    if (c->jit != NULL) {
+        sl_jit_stats_t js;
+        sl_jit_get_stats(c->jit, &js);
+        printf("jit\n  compiled: %" PRIu64 "\n  flushes:  %" PRIu64 "\n", js.compiled, js.flushes);
+    }
+#endif
 }
 
 void sl_core_dump_state(sl_core_t *c) {
@@ -236,6 +236,10 @@ void sl_elf_close(sl_elf_obj_t *obj) {
     free(obj);
 }
 
+int sl_elf_get_fd(sl_elf_obj_t *obj) {
+    return obj->fd;
+}
+
 int sl_elf_arch(sl_elf_obj_t *obj) {
     return obj->arch;
 }
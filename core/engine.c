@@ -38,7 +38,7 @@ static int engine_irq_transition_async(sl_irq_ep_t *ep, u4 num, bool high) {
     return 0;
 }
 
-static void engine_set_wfi(sl_engine_t *e, bool enable) {
+void sl_engine_set_wfi(sl_engine_t *e, bool enable) {
     if (enable) e->state |= SL_CORE_STATE_WFI;
     else e->state &= ~SL_CORE_STATE_WFI;
     sl_worker_set_engine_runnable(e->worker, !enable);
@@ -71,7 +71,7 @@ int sl_engine_async_command(sl_engine_t *e, u4 cmd, bool wait) {
 int sl_engine_wait_for_interrupt(sl_engine_t *e) {
     sl_irq_ep_t *ep = &e->irq_ep;
     if (ep->asserted) return 0;
-    engine_set_wfi(e, true);
+    sl_engine_set_wfi(e, true);
     return 0;
 }
 
@@ -87,18 +87,15 @@ void sl_engine_interrupt_set(sl_engine_t *e, bool enable) {
 static int engine_handle_runmode_event(sl_engine_t *e, sl_event_t *ev) {
     int err = 0;
     switch(ev->option) {
-    case SL_CORE_CMD_RUN:   engine_set_wfi(e, false); break;
-    case SL_CORE_CMD_HALT:  engine_set_wfi(e, true);  break;
+    case SL_CORE_CMD_RUN:   sl_engine_set_wfi(e, false); break;
+    case SL_CORE_CMD_HALT:  sl_engine_set_wfi(e, true);  break;
     case SL_CORE_CMD_EXIT:  err = SL_ERR_EXITED;    break;
     default:
         printf("unknown engine cmd option %u\n", ev->option);
         err = SL_ERR_ARG;
         break;
     }
-    if (ev->flags & SL_EV_FLAG_SIGNAL) {
-        sl_sem_t *sem = (sl_sem_t *)ev->signal;
-        sl_sem_post(sem);
-    }
+    // the worker signals the sender once the event is handled
     return err;
 }
 
@@ -124,7 +121,7 @@ static int engine_event_handle(sl_event_ep_t *ep, sl_event_t *ev) {
 int sl_engine_handle_interrupts(sl_engine_t *e) {
     sl_irq_ep_t *ep = &e->irq_ep;
     if (ep->asserted == 0) return 0;
-    engine_set_wfi(e, false);
+    sl_engine_set_wfi(e, false);
     return e->ops.interrupt(e);
 }
 
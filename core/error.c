@@ -43,6 +43,7 @@ static const char *err_str[] = {
     ESTR(SL_ERR_IO_NOCACHE),
     ESTR(SL_ERR_SLAC_UNDECODED),
     ESTR(SL_ERR_SLAC_INVALID),
+    ESTR(SL_ERR_SLAC_SPLIT),
 };
 
 const char *st_err(int err) {
@@ -18,6 +18,10 @@ int sl_core_synchronous_exception(sl_core_t *c, u8 ex, u8 value, u4 status) {
         if (c->options & SL_CORE_OPT_TRAP_SYSCALL) return SL_ERR_SYSCALL;
         return c->exception_enter(c, ex, value);
 
+    case EX_BREAKPOINT:
+        if (c->options & SL_CORE_OPT_TRAP_BREAKPOINT) return SL_ERR_BREAKPOINT;
+        return c->exception_enter(c, ex, value);
+
     case EX_UNDEFINDED:
         if (c->options & SL_CORE_OPT_TRAP_UNDEF) {
             inst = (u4)value;
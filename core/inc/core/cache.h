@@ -5,38 +5,159 @@
 
 #include <core/types.h>
 #include <sled/list.h>
+#include <sled/slac.h>
 
 #define SL_CACHE_TYPE_INSTRUCTION   0
 #define SL_CACHE_TYPE_DATA          1
 
-#define SL_CACHE_ENTS   64
+// default geometry, used for any field of sl_cache_geometry_t left zero
+#define SL_CACHE_DEFAULT_SETS   64
+#define SL_CACHE_DEFAULT_WAYS   1
+#define SL_CACHE_DEFAULT_SHIFT  12  // 4096
+
+#define SL_CACHE_MAX_WAYS       8
+#define SL_CACHE_MIN_SHIFT      8
+#define SL_CACHE_MAX_SHIFT      20
+
+// Bytes of decode results an instruction cache keeps, including those of pages
+// that are no longer in the cache. The store holds as many pages as fit in
+// the budget, which must leave room for at least one page more than the cache
+// holds. The default grows to that for caches too large for it. Pages are
+// allocated when first filled, so a core only pays for the code it runs.
+#define SL_CACHE_DEFAULT_DECODE_BUDGET  (8u << 20)
+#define SL_CACHE_MAX_DECODE_PAGES       (1u << 24)
+
+// Most bytes of code a decoded block covers. A write to code invalidates the
+// blocks that start this far before it.
+#define SL_CACHE_BLOCK_BYTES    256
+
+typedef struct sl_cache_dpage sl_cache_dpage_t;
+
+// Decode results for one page, kept in a store so a page that is evicted and
+// filled again doesn't have to be decoded again. Pages are keyed by address
+// and by the host memory backing them.
+struct sl_cache_dpage {
+    u8 base;                    // page number, ~0 if unused
+    void *buf;                  // memory the page was filled from
+    sl_slac_inst_t *decoded;    // NULL until the entry is first taken
+    sl_cache_dpage_t *next;     // hash chain by page number
+    sl_cache_dpage_t *bnext;    // hash chain by memory
+    u1 fill;                    // tag of decoded slots that belong to this page
+    bool held;                  // in use by a cache entry
+    bool ref;                   // reused since last considered for eviction
+};
 
 struct sl_cache_page {
     u8 base;
     void *buf;
+    void *wbuf;     // buf if stores can be done directly, NULL if they need the slow path
     sl_slac_inst_t *decoded;
+    u1 fill;        // tag of decoded slots that belong to the current contents
+    bool overread;  // buf extends beyond the page
+    bool code;      // writable data page overlapping decoded code, writes to it are checked
+    u1 plru;        // pseudo-LRU bits of the set, only used in its first way
+    sl_cache_dpage_t *dpage;
 };
 
 struct sl_cache {
     u1 page_shift;
     u1 type;
+    u1 ways;        // pages per set
+    u4 set_mask;    // sets - 1
     u8 miss_addr;
-    u8 hash_hit;
     u8 hash_miss;
-    sl_cache_page_t page[SL_CACHE_ENTS];
+    sl_cache_page_t *page;  // the ways of a set are adjacent
+    sl_cache_t *peer;       // the other cache of the core, which tracks writes to code
+
+    // decoded page store, instruction caches only
+    sl_cache_dpage_t *dpage;
+    sl_cache_dpage_t **dhash;
+    sl_cache_dpage_t **bhash;
+    u8 decode_budget;
+#if SLAC_TRACE
+    // A page's decoded instructions are followed by their descriptions, in an
+    // allocation aligned to its size rounded up to a power of 2 so the
+    // description of a decoded instruction can be found from its address.
+    usize desc_ext;     // bytes from the decoded instructions of a page to their descriptions
+    uptr dalign_mask;   // alignment of the decode arrays of a page - 1
+#endif
+    usize dpage_bytes;  // bytes of the decode arrays of a page
+    u4 dpage_num;   // store entries
+    u4 dhash_mask;  // buckets of dhash and bhash - 1
+    u4 dclock;      // next store entry to consider for eviction
+    u8 decode_hit;
+    u8 decode_miss;
+    u8 code_write;  // writes that invalidated decoded slots
 };
 
-int sl_cache_init(sl_cache_t *c, u1 type);
+int sl_cache_init(sl_cache_t *c, u1 type, const sl_cache_geometry_t *g, u8 decode_budget);
+void sl_cache_get_geometry(sl_cache_t *c, sl_cache_geometry_t *g);
 void sl_cache_shutdown(sl_cache_t *c);
 
 int sl_cache_rw_single(sl_cache_t *c, u8 addr, usize size, void *buf, bool read);
 int sl_cache_read(sl_cache_t *c, u8 addr, usize size, void *buf);
 int sl_cache_write(sl_cache_t *c, u8 addr, usize size, void *buf);
 
-int sl_cache_get_instruction(sl_cache_t *c, u8 addr, sl_slac_inst_t **inst_out);
+// Find the decoded instruction at addr and the page holding it.
+int sl_cache_get_instruction(sl_cache_t *c, u8 addr, sl_slac_inst_t **inst_out, sl_cache_page_t **pg_out);
 
-void sl_cache_set_data_page(sl_cache_t *c, u8 base, void *buf);
-void sl_cache_set_instruction_page(sl_cache_t *c, u8 addr, void *buf, bool overread);
+void sl_cache_set_data_page(sl_cache_t *c, u8 base, void *buf, bool writable);
+// Reset the decoded code overlapping a write made to pg->buf of a code page.
+void sl_cache_code_written(sl_cache_t *c, sl_cache_page_t *pg, u8 offset, usize size);
+// Reset the decoded code of instruction cache c overlapping host memory in
+// [lo, hi), written without going through the data cache.
+void sl_cache_host_written(sl_cache_t *c, uptr lo, uptr hi);
+int sl_cache_set_instruction_page(sl_cache_t *c, u8 addr, void *buf, bool overread);
 
 void sl_cache_invalidate_page(sl_cache_t *c, u8 addr);
 void sl_cache_invalidate_all(sl_cache_t *c);
+// Drop the cached pages but keep the decoded page store.
+void sl_cache_drop_pages(sl_cache_t *c);
+
+void sl_cache_reset_slot(sl_cache_t *c, sl_cache_page_t *pg, u4 slot);
+// Native encoding of the instruction in a slot of pg, read from the memory the
+// page was filled from.
+u4 sl_cache_machine_op(sl_cache_t *c, sl_cache_page_t *pg, u4 slot);
+
+// Tree pseudo-LRU over the ways of a set. Bit n - 1 holds node n of the tree,
+// with node 1 at the root, and points to the half to replace next.
+static inline u1 sl_cache_plru_touch(u1 bits, u1 ways, u1 way) {
+    u1 node = 1;
+    for (u1 half = ways >> 1; half != 0; half >>= 1) {
+        const u1 right = (way & half) ? 1 : 0;
+        if (right) bits &= ~(1u << (node - 1));
+        else       bits |= 1u << (node - 1);
+        node = (node * 2) + right;
+    }
+    return bits;
+}
+
+// Find the cache page holding page number base, NULL if it isn't cached.
+static inline sl_cache_page_t *sl_cache_find_page(sl_cache_t *c, u8 base) {
+    sl_cache_page_t *set = &c->page[(base & c->set_mask) * c->ways];
+    for (u1 w = 0; w < c->ways; w++) {
+        if (set[w].base == base) {
+            if (c->ways > 1)
+                set->plru = sl_cache_plru_touch(set->plru, c->ways, w);
+            return &set[w];
+        }
+    }
+    return NULL;
+}
+
+#if SLAC_TRACE
+// Trace description of a decoded instruction in a page of instruction cache c.
+static inline sl_slac_desc_t *sl_cache_desc(sl_cache_t *c, const sl_slac_inst_t *si) {
+    const uptr off = (uptr)si & c->dalign_mask;
+    return (sl_slac_desc_t *)((uptr)si - off + c->desc_ext) + (off / sizeof(sl_slac_inst_t));
+}
+#endif
+
+// Filling an instruction page doesn't touch its decoded slots. A slot is reset
+// the first time it is used after a fill, which its fill tag tells apart.
+static inline sl_slac_inst_t *sl_cache_get_slot(sl_cache_t *c, sl_cache_page_t *pg, u4 slot) {
+    sl_slac_inst_t *si = &pg->decoded[slot];
+    if (si->fill != pg->fill)
+        sl_cache_reset_slot(c, pg, slot);
+    return si;
+}
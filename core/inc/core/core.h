@@ -7,6 +7,7 @@
 
 #include <core/arch.h>
 #include <core/cache.h>
+#include <core/common.h>
 #include <core/irq.h>
 #include <core/itrace.h>
 #include <core/engine.h>
@@ -33,6 +34,18 @@
 #define CORE_EV_IRQ     1
 #define CORE_EV_RUNMODE 2
 
+#define CORE_BTC_ENTS   64
+
+// Default number of instructions the dispatch loop may run before checking for
+// events. This bounds interrupt latency, rounded up to the end of a block.
+#define CORE_POLL_BUDGET    1024
+
+// branch target cache entry
+typedef struct {
+    u8 pc;
+    sl_cache_page_t *pg;    // icache page pc was found in, used while it still holds pc
+} sl_btc_entry_t;
+
 typedef union {
     u4 u4;
     float f;
@@ -45,9 +58,10 @@ struct sl_core {
     // ----------------------------------------------------------------------------
     // synchronous functions
     // ----------------------------------------------------------------------------
-    int (*decode)(sl_core_t *c, sl_slac_inst_t *inst);
+    int (*decode)(sl_core_t *c, sl_slac_inst_t *inst, u4 op);
     int (*dispatch)(sl_core_t *c, u4 inst);
     int (*exception_enter)(sl_core_t *c, u8 ex, u8 value);
+    int (*exception_return)(sl_core_t *c, sl_slac_inst_t *inst);
     int (*breakpoint)(sl_core_t *c);
     int (*csr)(sl_core_t *c, sl_slac_inst_t *inst);
     void (*set_reg)(sl_core_t *c, u4 reg, u8 value);
@@ -65,8 +79,9 @@ struct sl_core {
     u8 pc;
     u8 r[32];
 
-    fexcept_t fexc; // host cumulative fp exception flags
-    u1 frm;         // floating point rounding mode
+    fexcept_t fexc; // host cumulative fp exception flags, see sl_core_fp_flags_sync
+    u1 frm;         // floating point rounding mode, SLAC_RM_*
+    u1 host_rm;     // rounding mode the host fp environment is set to
     sl_fp_reg_t f[32];
 
     u8 monitor_addr;
@@ -78,17 +93,32 @@ struct sl_core {
     sl_bus_t *bus;
     sl_cache_t icache;      // instruction cache
     sl_cache_t dcache;      // data cache
+    u4 map_gen;             // mapper_chain_gen() the caches were filled under
+    u4 write_seq;           // writes logged on the bus mapper that were seen
+    sl_btc_entry_t btc[CORE_BTC_ENTS];  // decoded targets of jumps out of a page
+    sl_slac_inst_t uncached;    // instruction run from memory that can't be cached
+#if WITH_JIT
+    sl_jit_t *jit;
+#endif
+#if SLAC_TRACE
+    sl_slac_desc_t *trace_desc; // description written by decode
+    sl_slac_desc_t uncached_desc;
+#endif
 
     sl_engine_t engine;
 
     itrace_t *trace;
     const arch_ops_t *arch_ops;
 
+    void *arch_state;       // architectural state of the derived core, for snapshots
+    u4 arch_state_len;
+
     u1 arch;
     u1 subarch;
     u1 id;             // numerical id of this core instance
     u4 options;
     u4 arch_options;
+    u4 poll_budget;    // max instructions between event checks
     const char *name;
 #if WITH_SYMBOLS
     sl_sym_list_t *symbols;
@@ -107,6 +137,32 @@ void sl_core_shutdown(sl_core_t *c);
 void sl_core_destroy(sl_core_t *c);
 
 void sl_core_config_get(sl_core_t *c, sl_core_params_t *p);
+
+// Architectural state of a core, including the derived core's arch_state.
+typedef struct {
+    u1 el;
+    u1 mode;
+    u4 state;
+    u8 pc;
+    u8 r[32];
+    fexcept_t fexc;
+    u1 frm;
+    sl_fp_reg_t f[32];
+    u8 monitor_addr;
+    u8 monitor_value;
+    u1 monitor_status;
+    u8 ticks;
+    u4 engine_state;        // interrupt enable and wfi
+    u4 irq_asserted;        // interrupt lines into the core
+    u4 irq_retained;
+    u4 arch_state_len;
+    u1 arch_state[];
+} sl_core_state_t;
+
+// Save allocates the state, which is freed with free(). Restore drops all
+// cached and decoded memory, since memory is usually restored along with it.
+int sl_core_save_state(sl_core_t *c, sl_core_state_t **state_out);
+int sl_core_restore_state(sl_core_t *c, const sl_core_state_t *s);
 int sl_core_config_set(sl_core_t *c, sl_core_params_t *p);
 
 void sl_core_add_symbols(sl_core_t *c, sl_sym_list_t *list);
@@ -134,11 +190,76 @@ int sl_core_endian_set(sl_core_t *c, bool big);
 void sl_core_instruction_barrier(sl_core_t *c);
 void sl_core_memory_barrier(sl_core_t *c, u4 type);
 
+// FP instructions leave the exception flags they raise set in the host fp
+// environment. They are merged into fexc when fexc is read or written, and
+// whenever the dispatch loop hands the host thread to other code.
+void sl_core_fp_flags_sync(sl_core_t *c);
+
+// Rounding modes are set on the host when an op needs a different one than
+// the active mode, which is round to nearest whenever the core isn't running.
+void sl_core_fp_set_round(sl_core_t *c, u1 rm);
+
 void sl_core_next_pc(sl_core_t *c);
-int sl_core_load_pc(sl_core_t *c, sl_slac_inst_t **inst_out);
+// Find the decoded instruction at pc and its icache page, filling the
+// instruction cache if needed. Returns SL_ERR_IO_NOCACHE if the page holding
+// pc can't be cached.
+int sl_core_load_pc(sl_core_t *c, sl_slac_inst_t **inst_out, sl_cache_page_t **pg_out);
+// Native encoding of the instruction at pc, for exceptions that report it.
+u4 sl_core_machine_op(sl_core_t *c);
 
 int sl_core_synchronous_exception(sl_core_t *c, u8 ex, u8 value, u4 status);
 
+#if SLAC_TRACE
+// Trace description of an instruction decoded by core c.
+static inline sl_slac_desc_t *sl_core_desc(sl_core_t *c, const sl_slac_inst_t *si) {
+    if (si == &c->uncached) return &c->uncached_desc;
+    return sl_cache_desc(&c->icache, si);
+}
+#endif
+
+// Loads and stores that hit the data cache are done inline with a host load
+// or store of the access size. Anything else, including stores to pages that
+// can't be written directly, goes through sl_core_mem_read_single and
+// sl_core_mem_write_single. Guest memory is accessed at every width, so the
+// host pointers are may_alias.
+u2 typedef __attribute__((may_alias)) sl_core_mem_u2_t;
+u4 typedef __attribute__((may_alias)) sl_core_mem_u4_t;
+u8 typedef __attribute__((may_alias)) sl_core_mem_u8_t;
+u1 typedef sl_core_mem_u1_t;
+
+#define SL_CORE_MEM_ACCESS(n) \
+static inline result ## n ## _t sl_core_mem_load ## n(sl_core_t *c, u8 addr) { \
+    sl_cache_t *dc = &c->dcache; \
+    result ## n ## _t r = {}; \
+    if (likely((addr & (n - 1)) == 0)) { \
+        sl_cache_page_t *pg = sl_cache_find_page(dc, addr >> dc->page_shift); \
+        if (likely(pg != NULL)) { \
+            r.value = *(const sl_core_mem_u ## n ## _t *)(pg->buf + (addr & ((1u << dc->page_shift) - 1))); \
+            return r; \
+        } \
+    } \
+    r.err = sl_core_mem_read_single(c, addr, n, &r.value); \
+    return r; \
+} \
+static inline int sl_core_mem_store ## n(sl_core_t *c, u8 addr, u ## n val) { \
+    sl_cache_t *dc = &c->dcache; \
+    if (likely((addr & (n - 1)) == 0)) { \
+        sl_cache_page_t *pg = sl_cache_find_page(dc, addr >> dc->page_shift); \
+        if (likely((pg != NULL) && (pg->wbuf != NULL))) { \
+            *(sl_core_mem_u ## n ## _t *)(pg->wbuf + (addr & ((1u << dc->page_shift) - 1))) = val; \
+            return 0; \
+        } \
+    } \
+    return sl_core_mem_write_single(c, addr, n, &val); \
+}
+
+SL_CORE_MEM_ACCESS(1)
+SL_CORE_MEM_ACCESS(2)
+SL_CORE_MEM_ACCESS(4)
+SL_CORE_MEM_ACCESS(8)
+
+#undef SL_CORE_MEM_ACCESS
+
 // ----------------------------------------------------------------------------
 // Misc
 // ----------------------------------------------------------------------------
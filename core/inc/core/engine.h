@@ -24,3 +24,5 @@ void sl_engine_shutdown(sl_engine_t *e);
 
 int sl_engine_handle_interrupts(sl_engine_t *e);
 int sl_engine_wait_for_interrupt(sl_engine_t *e);
+// Stop or resume dispatch until an interrupt, updating the worker to match.
+void sl_engine_set_wfi(sl_engine_t *e, bool enable);
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2026 Shac Ron and The Sled Project
+
+#pragma once
+
+#include <core/types.h>
+
+// Optional host code generator for hot slac blocks, enabled with JIT=1.
+
+// Blocks are compiled after they have been run this many times
+#define JIT_HOT_COUNT       32
+
+#define JIT_ARENA_SIZE      (16u * 1024 * 1024)
+#define JIT_BLOCK_RESERVE   (32u * 1024)    // worst case code size of one block
+
+typedef int (*sl_jit_block_t)(sl_core_t *c, u8 *count);
+
+typedef struct {
+    u8 compiled;    // blocks compiled
+    u8 flushes;     // times the arena filled up and all code was dropped
+} sl_jit_stats_t;
+
+// Create a jit with an arena of size bytes, at least JIT_BLOCK_RESERVE.
+int sl_jit_create(sl_jit_t **j_out, usize size);
+void sl_jit_destroy(sl_jit_t *j);
+void sl_jit_get_stats(sl_jit_t *j, sl_jit_stats_t *s);
+
+// Compile the decoded block starting at si, which is at c->pc. The code is
+// found by sl_jit_lookup until the block is built again.
+int sl_jit_compile(sl_jit_t *j, sl_core_t *c, sl_slac_inst_t *si);
+
+// Compiled code of the block starting at si, NULL if there is none. Code may
+// be dropped to make room for other blocks, and is compiled again when needed.
+sl_jit_block_t sl_jit_lookup(sl_jit_t *j, const sl_slac_inst_t *si);
+
+// Drop the code of a block starting at si, which is being built again.
+void sl_jit_forget(sl_jit_t *j, const sl_slac_inst_t *si);
@@ -3,22 +3,53 @@
 
 #pragma once
 
+#include <stdatomic.h>
+
+#include <core/lock.h>
 #include <core/types.h>
 #include <sled/mapper.h>
 
 typedef struct map_ent map_ent_t;
+typedef struct map_table map_table_t;
+
+// writes a mapper logs before cores that haven't seen them drop all decoded code
+#define MAPPER_WRITE_LOG    16
 
 struct sl_mapper {
-    int mode;
-    u4 num_ents;
-    map_ent_t **list;
+    _Atomic(map_table_t *) table;   // current table, NULL if blocked
+    sl_lock_t lock;                 // serializes updates and logged writes
+    atomic_uint gen;                // bumped whenever the table is replaced
+    atomic_uint write_seq;          // writes logged by sl_mapper_log_write
+    struct { uptr lo, hi; } write_log[MAPPER_WRITE_LOG];
     sl_mapper_t *next;
     sl_map_ep_t ep;
 };
 
+// Generation of a chain of mappers, which changes whenever the table of any
+// mapper in it is replaced. Cores cache host pointers to memory resolved
+// through their chain and drop them when this changes.
+static inline u4 mapper_chain_gen(sl_mapper_t *m) {
+    u4 gen = 0;
+    for ( ; m != NULL; m = m->next)
+        gen += atomic_load_explicit(&m->gen, memory_order_acquire);
+    return gen;
+}
+
+// Number of writes logged on m, which changes whenever one is.
+static inline u4 mapper_write_seq(sl_mapper_t *m) {
+    return atomic_load_explicit(&m->write_seq, memory_order_acquire);
+}
+
+// Call fn with the host memory of each write logged on m after the first *seq,
+// then set *seq to the number logged. Returns false if some of those writes
+// were already dropped from the log.
+bool mapper_logged_writes(sl_mapper_t *m, u4 *seq, void (*fn)(void *ctx, uptr lo, uptr hi), void *ctx);
+
 void mapper_init(sl_mapper_t *m);
 void mapper_shutdown(sl_mapper_t *m);
 
 int mapper_update(sl_mapper_t *m, sl_event_t *ev);
+// tables of m replaced but not yet freed
+u4 mapper_retired_count(sl_mapper_t *m);
 
 void mapper_print_mappings(sl_mapper_t *m);
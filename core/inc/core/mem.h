@@ -6,13 +6,37 @@
 #include <sled/mapper.h>
 #include <sled/list.h>
 
+typedef struct mem_file_map mem_file_map_t;
+
+// File pages mapped into a region, which hold data before they are touched
+struct mem_file_map {
+    mem_file_map_t *next;
+    u8 offset;          // in the region
+    u8 len;
+    u8 file_offset;
+    int fd;             // owned by the region
+};
+
 typedef struct {
     sl_list_node_t node;
     u8 base;
     u8 length;
     sl_map_ep_t ep;
-    u1 data[];
+    u1 *data;           // mapped anonymous memory, page aligned
+    usize map_len;
+    mem_file_map_t *files;
 } mem_region_t;
 
 int mem_region_create(u8 base, u8 length, mem_region_t **m_out);
 void mem_region_destroy(mem_region_t *m);
+
+usize mem_page_size(void);
+
+// Map file pages privately into the region, offsets and length are page aligned.
+int mem_region_map_file(mem_region_t *m, u8 offset, u8 len, int fd, u8 file_offset);
+int mem_region_zero(mem_region_t *m, u8 offset, u8 len);
+
+// Copy the region to a new file and map the region copy-on-write from it.
+int mem_region_snapshot(mem_region_t *m, int *fd_out);
+// Discard changes made since the snapshot in fd was taken.
+int mem_region_restore(mem_region_t *m, int fd);
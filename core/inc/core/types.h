@@ -13,3 +13,4 @@ typedef struct sl_sem sl_sem_t;
 
 typedef struct sl_cache sl_cache_t;
 typedef struct sl_cache_page sl_cache_page_t;
+typedef struct sl_jit sl_jit_t;
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <stdatomic.h>
+
 #include <sled/worker.h>
 
 #define SL_WORKER_MAX_EPS   64
@@ -13,6 +15,7 @@ struct sl_worker {
     sl_lock_t lock;
     sl_cond_t has_event;
     sl_list_t ev_list;
+    atomic_uint attention;  // set when the engine loop needs to look at events or state
 
     u4 state;
     sl_engine_t *engine;
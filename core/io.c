@@ -32,7 +32,7 @@
             stype cur = *(stype *)data; \
             const stype max = MAX((stype)v, cur); \
             success = ATOMIC_CAS((_Atomic stype *)data, cur, max, op->order, memory_order_relaxed); \
-            result = max; \
+            result = cur; \
         } \
         break; \
     case IO_OP_ATOMIC_SMIN: \
@@ -40,7 +40,7 @@
             stype cur = *(stype *)data; \
             const stype min = MIN((stype)v, cur); \
             success = ATOMIC_CAS(sd, cur, min, op->order, memory_order_relaxed); \
-            result = min; \
+            result = cur; \
         } \
         break; \
     case IO_OP_ATOMIC_UMAX: \
@@ -48,7 +48,7 @@
             utype cur = *(utype *)data; \
             const utype max = MAX(v, cur); \
             success = ATOMIC_CAS(d, cur, max, op->order, memory_order_relaxed); \
-            result = max; \
+            result = cur; \
         } \
         break; \
     case IO_OP_ATOMIC_UMIN: \
@@ -56,7 +56,7 @@
             utype cur = *(utype *)data; \
             const utype min = MIN(v, cur); \
             success = ATOMIC_CAS(d, cur, min, op->order, memory_order_relaxed); \
-            result = min; \
+            result = cur; \
         } \
         break; \
     default: \
@@ -0,0 +1,940 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2026 Shac Ron and The Sled Project
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <core/cache.h>
+#include <core/core.h>
+#include <core/jit.h>
+#include <sled/error.h>
+#include <sled/slac.h>
+
+#if !__x86_64__
+#error "the jit backend requires an x86-64 host"
+#endif
+
+// x86-64 code generator for decoded slac blocks.
+//
+// A compiled block is a host function that runs every instruction of the
+// block and returns the number retired. ALU ops, moves and branches are
+// emitted inline. Loads and stores are inlined for dcache hits and call the
+// slac handler on a miss. Everything else calls the instruction's handler.
+//
+// The most used guest registers of a block are kept in callee-saved host
+// registers. They are written back to sl_core_t.r[] before any handler is
+// called and reloaded after it returns.
+//
+// The arena is never writable and executable at once. The pages a block is
+// emitted to are made writable for the compile, then executable when done.
+
+#define JIT_NUM_HOST_REGS   5
+#define JIT_TABLE_SIZE      8192            // compiled blocks found by decoded instruction
+
+// Compiled blocks are kept in a direct mapped table rather than with the slot
+// data of every decoded instruction, as few instructions start a hot block.
+typedef struct {
+    const sl_slac_inst_t *si;
+    sl_jit_block_t code;
+} jit_entry_t;
+
+struct sl_jit {
+    u1 *base;
+    usize size;
+    usize used;
+    usize page_mask;    // host page size - 1
+    sl_jit_stats_t stats;
+    jit_entry_t table[JIT_TABLE_SIZE];
+};
+
+// host registers
+#define RAX     0
+#define RCX     1
+#define RDX     2
+#define RBX     3
+#define RSP     4
+#define RBP     5
+#define RSI     6
+#define RDI     7
+#define R12     12
+#define R13     13
+#define R14     14
+#define R15     15
+
+// condition codes
+#define CC_B    0x2
+#define CC_AE   0x3
+#define CC_E    0x4
+#define CC_NE   0x5
+#define CC_L    0xc
+#define CC_GE   0xd
+
+// group 1 alu extensions
+#define ALU_ADD 0
+#define ALU_OR  1
+#define ALU_AND 4
+#define ALU_SUB 5
+#define ALU_XOR 6
+#define ALU_CMP 7
+
+// shift extensions
+#define SH_SHL  4
+#define SH_SHR  5
+#define SH_SAR  7
+
+#define OFF_PC      ((i4)offsetof(sl_core_t, pc))
+#define OFF_BT      ((i4)offsetof(sl_core_t, branch_taken))
+#define OFF_PAGE    ((i4)(offsetof(sl_core_t, dcache) + offsetof(sl_cache_t, page)))
+
+static const u1 host_regs[JIT_NUM_HOST_REGS] = { RBX, R12, R13, R14, R15 };
+
+typedef struct {
+    u1 *p;
+    sl_core_t *core;
+    u1 loc[32];     // host register holding a guest register, 0 if in memory
+    u4 cached;      // guest registers held in host registers
+    u4 dirty;       // cached registers modified since the last write back
+} jit_ctx_t;
+
+// instruction classes
+#define JK_CALL     0   // call the slac handler
+#define JK_ALU_DRI  1
+#define JK_ALU_DRR  2
+#define JK_MOVR     3
+#define JK_MOVI     4   // constant result
+#define JK_NOP      5
+#define JK_LD       6
+#define JK_ST       7
+#define JK_BR       8
+
+// register length was resolved when the instruction was bound
+static inline bool is_wide(sl_slac_inst_t *si) {
+    return si->len == SLAC_IN_LEN_8;
+}
+
+static inline u8 trunc_rlen(bool w, u8 v) {
+    return w ? v : (u4)v;
+}
+
+static inline bool fits_i4(i8 v) {
+    return v == (i4)v;
+}
+
+static inline bool fits_i1(i4 v) {
+    return v == (i1)v;
+}
+
+static inline bool guest_reg(u1 r) {
+    return r < 32;
+}
+
+static u1 classify(sl_core_t *c, sl_slac_inst_t *si) {
+    const bool w = is_wide(si);
+    switch (si->type) {
+    case SLAC_TYPE_ALU:
+        if (!guest_reg(si->d0) || !guest_reg(si->r0)) return JK_CALL;
+        if (si->arg == SLAC_IN_ARG_DRI) {
+            switch (si->func) {
+            case SLAC_FUNC_NOT:
+                return JK_MOVI;
+            case SLAC_FUNC_SHL:
+            case SLAC_FUNC_SHR:
+            case SLAC_FUNC_SHRS:
+            case SLAC_FUNC_ZEXT:
+                if ((u4)si->imm >= (w ? 64 : 32)) return JK_CALL;
+                return JK_ALU_DRI;
+            case SLAC_FUNC_ADD:
+            case SLAC_FUNC_SUB:
+            case SLAC_FUNC_RSUB:
+            case SLAC_FUNC_AND:
+            case SLAC_FUNC_OR:
+            case SLAC_FUNC_XOR:
+            case SLAC_FUNC_CSELS:
+            case SLAC_FUNC_CSEL:
+                return JK_ALU_DRI;
+            default:
+                return JK_CALL;
+            }
+        }
+        if (si->arg == SLAC_IN_ARG_DRR) {
+            if (!guest_reg(si->r1)) return JK_CALL;
+            switch (si->func) {
+            case SLAC_FUNC_ADD:
+            case SLAC_FUNC_SUB:
+            case SLAC_FUNC_RSUB:
+            case SLAC_FUNC_AND:
+            case SLAC_FUNC_OR:
+            case SLAC_FUNC_XOR:
+            case SLAC_FUNC_SHL:
+            case SLAC_FUNC_SHRS:
+            case SLAC_FUNC_SHR:
+            case SLAC_FUNC_CSELS:
+            case SLAC_FUNC_CSEL:
+            case SLAC_FUNC_MUL:
+            case SLAC_FUNC_MULHSS:
+            case SLAC_FUNC_MULHSU:
+            case SLAC_FUNC_MULHUU:
+                return JK_ALU_DRR;
+            default:
+                // division is left to the handler
+                return JK_CALL;
+            }
+        }
+        return JK_CALL;
+
+    case SLAC_TYPE_LD:
+        if (!guest_reg(si->r0)) return JK_CALL;
+        if (!guest_reg(si->d0) && (si->d0 != SLAC_REG_DISCARD)) return JK_CALL;
+        if (si->func > SLAC_FUNC_LD8) return JK_CALL;
+        return JK_LD;
+
+    case SLAC_TYPE_ST:
+        if (!guest_reg(si->r0) || !guest_reg(si->d0)) return JK_CALL;
+        if ((si->func < SLAC_FUNC_ST1) || (si->func > SLAC_FUNC_ST8)) return JK_CALL;
+        return JK_ST;
+
+    case SLAC_TYPE_SYS:
+        switch (si->func) {
+        case SLAC_FUNC_MOVR:
+            if (!guest_reg(si->d0) || !guest_reg(si->r0)) return JK_CALL;
+            return JK_MOVR;
+        case SLAC_FUNC_MOVI:
+        case SLAC_FUNC_ADR4K:
+            if (!guest_reg(si->d0)) return JK_CALL;
+            return JK_MOVI;
+        case SLAC_FUNC_NOP:
+            return JK_NOP;
+        default:
+            return JK_CALL;
+        }
+
+    case SLAC_TYPE_BR:
+        switch (si->func) {
+        case SLAC_FUNC_B:
+            if ((si->arg & SLAC_IN_ARG_R1) && !guest_reg(si->r0)) return JK_CALL;
+            return JK_BR;
+        case SLAC_FUNC_BL:
+            if (!guest_reg(si->d0)) return JK_CALL;
+            if ((si->arg & SLAC_IN_ARG_R1) && !guest_reg(si->r0)) return JK_CALL;
+            return JK_BR;
+        case SLAC_FUNC_CBEQ:
+        case SLAC_FUNC_CBNE:
+        case SLAC_FUNC_CBLTU:
+        case SLAC_FUNC_CBLTS:
+        case SLAC_FUNC_CBGEU:
+        case SLAC_FUNC_CBGES:
+            if (!guest_reg(si->r0) || !guest_reg(si->r1)) return JK_CALL;
+            return JK_BR;
+        default:
+            return JK_CALL;
+        }
+
+    default:
+        return JK_CALL;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// instruction encoding
+// ----------------------------------------------------------------------------
+
+static inline void emit1(jit_ctx_t *j, u1 b) {
+    *j->p++ = b;
+}
+
+static inline void emit4(jit_ctx_t *j, u4 v) {
+    memcpy(j->p, &v, 4);
+    j->p += 4;
+}
+
+static inline void emit8(jit_ctx_t *j, u8 v) {
+    memcpy(j->p, &v, 8);
+    j->p += 8;
+}
+
+static void emit_bytes(jit_ctx_t *j, const u1 *b, usize n) {
+    memcpy(j->p, b, n);
+    j->p += n;
+}
+
+static inline void emit_rex(jit_ctx_t *j, bool w, u1 reg, u1 index, u1 base) {
+    const u1 rex = 0x40 | (w << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+    if (rex != 0x40) emit1(j, rex);
+}
+
+// one or two byte (0f xx) opcode
+static inline void emit_op(jit_ctx_t *j, u4 op) {
+    if (op > 0xff) emit1(j, op >> 8);
+    emit1(j, op);
+}
+
+static inline u1 modrm(u1 mod, u1 reg, u1 rm) {
+    return (mod << 6) | ((reg & 7) << 3) | (rm & 7);
+}
+
+// op reg, rm (register direct)
+static void emit_rr(jit_ctx_t *j, bool w, u4 op, u1 reg, u1 rm) {
+    emit_rex(j, w, reg, 0, rm);
+    emit_op(j, op);
+    emit1(j, modrm(3, reg, rm));
+}
+
+// op reg, [base + index + disp], index is RSP for none
+static void emit_rm(jit_ctx_t *j, bool w, u4 op, u1 reg, u1 base, u1 index, i4 disp) {
+    const bool sib = (index != RSP) || ((base & 7) == RSP);
+    emit_rex(j, w, reg, sib ? index : 0, base);
+    emit_op(j, op);
+    u1 mod;
+    if ((disp == 0) && ((base & 7) != RBP)) mod = 0;
+    else if (fits_i1(disp)) mod = 1;
+    else mod = 2;
+    if (sib) {
+        emit1(j, modrm(mod, reg, RSP));
+        emit1(j, ((index & 7) << 3) | (base & 7));
+    } else {
+        emit1(j, modrm(mod, reg, base));
+    }
+    if (mod == 1) emit1(j, disp);
+    else if (mod == 2) emit4(j, disp);
+}
+
+static inline void emit_core(jit_ctx_t *j, bool w, u4 op, u1 reg, i4 disp) {
+    emit_rm(j, w, op, reg, RBP, RSP, disp);
+}
+
+static void emit_mov_imm(jit_ctx_t *j, u1 reg, u8 v) {
+    if (v <= 0xffffffff) {
+        // zero extends
+        emit_rex(j, false, 0, 0, reg);
+        emit1(j, 0xb8 + (reg & 7));
+        emit4(j, v);
+    } else if (fits_i4(v)) {
+        emit_rr(j, true, 0xc7, 0, reg);
+        emit4(j, v);
+    } else {
+        emit_rex(j, true, 0, 0, reg);
+        emit1(j, 0xb8 + (reg & 7));
+        emit8(j, v);
+    }
+}
+
+// store a 64 bit constant to the core struct, may use RSI
+static void emit_store_imm(jit_ctx_t *j, i4 disp, u8 v) {
+    if (fits_i4(v)) {
+        emit_core(j, true, 0xc7, 0, disp);
+        emit4(j, v);
+    } else {
+        emit_mov_imm(j, RSI, v);
+        emit_core(j, true, 0x89, RSI, disp);
+    }
+}
+
+// alu reg, imm for group 1 ops, may use RCX
+static void emit_alu_imm(jit_ctx_t *j, bool w, u1 ext, u1 reg, u8 v) {
+    static const u1 reg_op[8] = { 0x03, 0x0b, 0, 0, 0x23, 0x2b, 0x33, 0x3b };
+    const i8 imm = w ? (i8)v : (i4)v;
+    if (!fits_i4(imm)) {
+        emit_mov_imm(j, RCX, v);
+        emit_rr(j, w, reg_op[ext], reg, RCX);
+    } else if (fits_i1(imm)) {
+        emit_rr(j, w, 0x83, ext, reg);
+        emit1(j, imm);
+    } else {
+        emit_rr(j, w, 0x81, ext, reg);
+        emit4(j, imm);
+    }
+}
+
+static void emit_setcc_rax(jit_ctx_t *j, u1 cc) {
+    emit_rr(j, false, 0x0f90 + cc, 0, RAX);     // setcc al
+    emit_rr(j, false, 0x0fb6, RAX, RAX);        // movzx eax, al
+}
+
+// forward jumps, patched with jit_patch
+static u1 *emit_jcc(jit_ctx_t *j, u1 cc) {
+    emit1(j, 0x0f);
+    emit1(j, 0x80 + cc);
+    emit4(j, 0);
+    return j->p;
+}
+
+static u1 *emit_jmp(jit_ctx_t *j) {
+    emit1(j, 0xe9);
+    emit4(j, 0);
+    return j->p;
+}
+
+static void jit_patch(jit_ctx_t *j, u1 *after) {
+    const i4 rel = j->p - after;
+    memcpy(after - 4, &rel, 4);
+}
+
+// ----------------------------------------------------------------------------
+// guest registers
+// ----------------------------------------------------------------------------
+
+static inline i4 reg_disp(u1 g) {
+    return offsetof(sl_core_t, r) + (g * sizeof(u8));
+}
+
+static void load_guest(jit_ctx_t *j, u1 h, u1 g) {
+    if (j->loc[g]) emit_rr(j, true, 0x8b, h, j->loc[g]);
+    else           emit_core(j, true, 0x8b, h, reg_disp(g));
+}
+
+static void store_guest(jit_ctx_t *j, u1 g, u1 h) {
+    if (j->loc[g]) {
+        emit_rr(j, true, 0x8b, j->loc[g], h);
+        j->dirty |= (1u << g);
+    } else {
+        emit_core(j, true, 0x89, h, reg_disp(g));
+    }
+}
+
+static void store_guest_imm(jit_ctx_t *j, u1 g, u8 v) {
+    if (j->loc[g]) {
+        emit_mov_imm(j, j->loc[g], v);
+        j->dirty |= (1u << g);
+    } else {
+        emit_store_imm(j, reg_disp(g), v);
+    }
+}
+
+// op h, guest
+static void op_guest(jit_ctx_t *j, bool w, u4 op, u1 h, u1 g) {
+    if (j->loc[g]) emit_rr(j, w, op, h, j->loc[g]);
+    else           emit_core(j, w, op, h, reg_disp(g));
+}
+
+static void write_back(jit_ctx_t *j) {
+    for (u1 g = 0; g < 32; g++) {
+        if (j->dirty & (1u << g))
+            emit_core(j, true, 0x89, j->loc[g], reg_disp(g));
+    }
+    j->dirty = 0;
+}
+
+static void reload(jit_ctx_t *j) {
+    for (u1 g = 0; g < 32; g++) {
+        if (j->cached & (1u << g))
+            emit_core(j, true, 0x8b, j->loc[g], reg_disp(g));
+    }
+}
+
+static void count_use(u4 *uses, u1 r) {
+    if (guest_reg(r)) uses[r]++;
+}
+
+// keep the most used registers of the block in host registers
+static void alloc_regs(jit_ctx_t *j, sl_slac_inst_t *si, u4 n) {
+    u4 uses[32] = {};
+    for (u4 i = 0; i < n; ) {
+        switch (classify(j->core, si)) {
+        case JK_ALU_DRR:
+        case JK_BR:
+            count_use(uses, si->r1);
+            // fall through
+        case JK_ALU_DRI:
+        case JK_MOVR:
+        case JK_LD:
+        case JK_ST:
+            count_use(uses, si->r0);
+            // fall through
+        case JK_MOVI:
+            count_use(uses, si->d0);
+            break;
+        }
+        i += slac_inst_count(si);
+        si += slac_inst_len(si) / 2;
+    }
+    uses[0] = 0;    // the zero register is never written
+
+    memset(j->loc, 0, sizeof(j->loc));
+    j->cached = 0;
+    j->dirty = 0;
+    for (u4 h = 0; h < JIT_NUM_HOST_REGS; h++) {
+        u1 best = 0;
+        for (u1 g = 1; g < 32; g++) {
+            if (uses[g] > uses[best]) best = g;
+        }
+        if (uses[best] < 2) break;
+        j->loc[best] = host_regs[h];
+        j->cached |= (1u << best);
+        uses[best] = 0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// block structure
+// ----------------------------------------------------------------------------
+
+static void emit_prologue(jit_ctx_t *j) {
+    static const u1 code[] = {
+        0x55,                       // push rbp
+        0x53,                       // push rbx
+        0x41, 0x54,                 // push r12
+        0x41, 0x55,                 // push r13
+        0x41, 0x56,                 // push r14
+        0x41, 0x57,                 // push r15
+        0x48, 0x83, 0xec, 0x08,     // sub rsp, 8
+        0x48, 0x89, 0x34, 0x24,     // mov [rsp], rsi
+        0x48, 0x89, 0xfd,           // mov rbp, rdi
+    };
+    emit_bytes(j, code, sizeof(code));
+    reload(j);
+}
+
+// return eax, with the count of retired instructions
+static void emit_epilogue(jit_ctx_t *j, u4 retired) {
+    static const u1 code[] = {
+        0x48, 0x8b, 0x14, 0x24,     // mov rdx, [rsp]
+        0x48, 0x89, 0x0a,           // mov [rdx], rcx
+        0x48, 0x83, 0xc4, 0x08,     // add rsp, 8
+        0x41, 0x5f,                 // pop r15
+        0x41, 0x5e,                 // pop r14
+        0x41, 0x5d,                 // pop r13
+        0x41, 0x5c,                 // pop r12
+        0x5b,                       // pop rbx
+        0x5d,                       // pop rbp
+        0xc3,                       // ret
+    };
+    emit_mov_imm(j, RCX, retired);
+    emit_bytes(j, code, sizeof(code));
+}
+
+// Run the slac handler for the instruction after k retired instructions. Leave
+// the block if it fails or takes a branch (including synchronous exceptions).
+static void emit_call(jit_ctx_t *j, sl_slac_inst_t *si, u8 pc, u4 k) {
+    write_back(j);
+    emit_store_imm(j, OFF_PC, pc);
+    emit_rr(j, true, 0x8b, RDI, RBP);           // mov rdi, rbp
+    emit_mov_imm(j, RSI, (u8)si);
+    emit_mov_imm(j, RAX, (u8)slac_exec_table[si->exec]);
+    emit_rr(j, false, 0xff, 2, RAX);            // call rax
+
+    emit_rr(j, false, 0x85, RAX, RAX);          // test eax, eax
+    u1 *ok = emit_jcc(j, CC_E);
+    emit_epilogue(j, k);
+    jit_patch(j, ok);
+
+    emit_core(j, false, 0x80, ALU_CMP, OFF_BT); // cmp byte [branch_taken], 0
+    emit1(j, 0);
+    u1 *cont = emit_jcc(j, CC_E);
+    emit_rr(j, false, 0x33, RAX, RAX);          // xor eax, eax
+    emit_epilogue(j, k + slac_inst_count(si));
+    jit_patch(j, cont);
+
+    reload(j);
+}
+
+// ----------------------------------------------------------------------------
+// instructions
+// ----------------------------------------------------------------------------
+
+static void emit_alu_dri(jit_ctx_t *j, sl_slac_inst_t *si, bool w) {
+    const u8 imm = trunc_rlen(w, si->imm);
+    load_guest(j, RAX, si->r0);
+    switch (si->func) {
+    case SLAC_FUNC_ADD:     emit_alu_imm(j, w, ALU_ADD, RAX, imm);  break;
+    case SLAC_FUNC_SUB:     emit_alu_imm(j, w, ALU_SUB, RAX, imm);  break;
+    case SLAC_FUNC_AND:     emit_alu_imm(j, w, ALU_AND, RAX, imm);  break;
+    case SLAC_FUNC_OR:      emit_alu_imm(j, w, ALU_OR,  RAX, imm);  break;
+    case SLAC_FUNC_XOR:     emit_alu_imm(j, w, ALU_XOR, RAX, imm);  break;
+
+    case SLAC_FUNC_RSUB:
+        emit_mov_imm(j, RCX, imm);
+        emit_rr(j, w, 0x2b, RCX, RAX);          // sub rcx, rax
+        emit_rr(j, true, 0x8b, RAX, RCX);
+        break;
+
+    case SLAC_FUNC_SHL:
+    case SLAC_FUNC_SHR:
+    case SLAC_FUNC_SHRS: {
+        const u1 ext = (si->func == SLAC_FUNC_SHL) ? SH_SHL : (si->func == SLAC_FUNC_SHR) ? SH_SHR : SH_SAR;
+        emit_rr(j, w, 0xc1, ext, RAX);
+        emit1(j, imm);
+        break;
+    }
+
+    case SLAC_FUNC_ZEXT:
+        emit_rr(j, w, 0xc1, SH_SHL, RAX);
+        emit1(j, imm);
+        emit_rr(j, w, 0xc1, SH_SHR, RAX);
+        emit1(j, imm);
+        break;
+
+    case SLAC_FUNC_CSELS:
+    case SLAC_FUNC_CSEL:
+        emit_alu_imm(j, w, ALU_CMP, RAX, imm);
+        emit_setcc_rax(j, (si->func == SLAC_FUNC_CSELS) ? CC_L : CC_B);
+        break;
+    }
+    if (!w && si->sx8) emit_rr(j, true, 0x63, RAX, RAX);   // movsxd rax, eax
+    store_guest(j, si->d0, RAX);
+}
+
+static void emit_alu_drr(jit_ctx_t *j, sl_slac_inst_t *si, bool w) {
+    load_guest(j, RAX, si->r0);
+    switch (si->func) {
+    case SLAC_FUNC_ADD:     op_guest(j, w, 0x03, RAX, si->r1);      break;
+    case SLAC_FUNC_SUB:     op_guest(j, w, 0x2b, RAX, si->r1);      break;
+    case SLAC_FUNC_AND:     op_guest(j, w, 0x23, RAX, si->r1);      break;
+    case SLAC_FUNC_OR:      op_guest(j, w, 0x0b, RAX, si->r1);      break;
+    case SLAC_FUNC_XOR:     op_guest(j, w, 0x33, RAX, si->r1);      break;
+    case SLAC_FUNC_MUL:     op_guest(j, w, 0x0faf, RAX, si->r1);    break;
+
+    case SLAC_FUNC_RSUB:
+        load_guest(j, RCX, si->r1);
+        emit_rr(j, w, 0x2b, RCX, RAX);
+        emit_rr(j, true, 0x8b, RAX, RCX);
+        break;
+
+    case SLAC_FUNC_SHL:
+    case SLAC_FUNC_SHR:
+    case SLAC_FUNC_SHRS: {
+        // the host masks the shift count the same way
+        const u1 ext = (si->func == SLAC_FUNC_SHL) ? SH_SHL : (si->func == SLAC_FUNC_SHR) ? SH_SHR : SH_SAR;
+        load_guest(j, RCX, si->r1);
+        emit_rr(j, w, 0xd3, ext, RAX);
+        break;
+    }
+
+    case SLAC_FUNC_CSELS:
+    case SLAC_FUNC_CSEL:
+        op_guest(j, w, 0x3b, RAX, si->r1);
+        emit_setcc_rax(j, (si->func == SLAC_FUNC_CSELS) ? CC_L : CC_B);
+        break;
+
+    case SLAC_FUNC_MULHUU:
+    case SLAC_FUNC_MULHSS:
+        load_guest(j, RCX, si->r1);
+        emit_rr(j, w, 0xf7, (si->func == SLAC_FUNC_MULHUU) ? 4 : 5, RCX);
+        emit_rr(j, true, 0x8b, RAX, RDX);
+        break;
+
+    case SLAC_FUNC_MULHSU:
+        // high(signed a * unsigned b) = high(a * b) - (a < 0 ? b : 0)
+        load_guest(j, RCX, si->r1);
+        emit_rr(j, w, 0xf7, 4, RCX);            // mul rcx
+        load_guest(j, RAX, si->r0);
+        emit_rr(j, w, 0xc1, SH_SAR, RAX);
+        emit1(j, w ? 63 : 31);
+        emit_rr(j, w, 0x23, RAX, RCX);          // and rax, rcx
+        emit_rr(j, w, 0x2b, RDX, RAX);          // sub rdx, rax
+        emit_rr(j, true, 0x8b, RAX, RDX);
+        break;
+    }
+    if (!w && si->sx8) emit_rr(j, true, 0x63, RAX, RAX);
+    store_guest(j, si->d0, RAX);
+}
+
+static void emit_movi(jit_ctx_t *j, sl_slac_inst_t *si, u8 pc, bool w) {
+    u8 v;
+    if (si->type == SLAC_TYPE_ALU) {
+        v = trunc_rlen(w, ~si->imm);   // not
+        if (!w && si->sx8) v = (u8)(i8)(i4)v;
+    } else if (si->func == SLAC_FUNC_ADR4K) {
+        v = trunc_rlen(w, pc + si->imm);
+    } else {
+        v = trunc_rlen(w, si->imm);     // movi
+        if (!w && si->sx8) v = (u8)(i8)(i4)v;
+    }
+    store_guest_imm(j, si->d0, v);
+}
+
+// Compute the address into RAX and find the dcache page. Leaves the page
+// buffer in RDX and the page offset in RAX. Unaligned accesses, misses and
+// stores to pages that can't be written directly jump to the labels in miss,
+// which are left for the caller to patch. Every way of the set is compared, and a hit updates the
+// pseudo-LRU bits.
+static void emit_dcache_lookup(jit_ctx_t *j, sl_slac_inst_t *si, bool w, u1 size, bool store, u1 **miss) {
+    const sl_cache_t *dc = &j->core->dcache;
+    const u1 shift = dc->page_shift;
+    const u1 ways = dc->ways;
+    const i4 page_size = sizeof(sl_cache_page_t);
+    const i4 off_plru = offsetof(sl_cache_page_t, plru);
+    load_guest(j, RAX, si->r0);
+    emit_alu_imm(j, w, ALU_ADD, RAX, trunc_rlen(w, si->imm));
+    miss[0] = NULL;
+    if (size > 1) {
+        emit1(j, 0xa8);                         // test al, imm8
+        emit1(j, size - 1);
+        miss[0] = emit_jcc(j, CC_NE);
+    }
+    emit_rr(j, true, 0x8b, RCX, RAX);
+    emit_rr(j, true, 0xc1, SH_SHR, RCX);        // rcx = page base
+    emit1(j, shift);
+    emit_rr(j, false, 0x8b, RDX, RCX);
+    emit_alu_imm(j, false, ALU_AND, RDX, dc->set_mask);
+    emit_rr(j, true, 0x69, RDX, RDX);           // imul rdx, rdx, imm32
+    emit4(j, ways * page_size);
+    emit_core(j, true, 0x03, RDX, OFF_PAGE);    // rdx = first way of the set
+
+    u1 *hit[SL_CACHE_MAX_WAYS];
+    for (u1 k = 0; k < ways - 1; k++) {
+        emit_rm(j, true, 0x3b, RCX, RDX, RSP, (k * page_size) + offsetof(sl_cache_page_t, base));
+        hit[k] = emit_jcc(j, CC_E);
+    }
+    emit_rm(j, true, 0x3b, RCX, RDX, RSP, ((ways - 1) * page_size) + offsetof(sl_cache_page_t, base));
+    miss[1] = emit_jcc(j, CC_NE);
+
+    // the last way falls through, the others jump here
+    u1 *found[SL_CACHE_MAX_WAYS];
+    for (int k = ways - 1; k >= 0; k--) {
+        if (k < ways - 1) jit_patch(j, hit[k]);
+        if (ways > 1) {
+            emit_rm(j, false, 0x80, ALU_AND, RDX, RSP, off_plru);
+            emit1(j, sl_cache_plru_touch(0xff, ways, k));
+            emit_rm(j, false, 0x80, ALU_OR, RDX, RSP, off_plru);
+            emit1(j, sl_cache_plru_touch(0, ways, k));
+        }
+        if (k > 0) {
+            emit_alu_imm(j, true, ALU_ADD, RDX, k * page_size);
+            found[k] = emit_jmp(j);
+        }
+    }
+    for (u1 k = 1; k < ways; k++)
+        jit_patch(j, found[k]);
+    // rdx = the page that hit
+    miss[2] = NULL;
+    if (store) {
+        emit_rm(j, true, 0x8b, RDX, RDX, RSP, offsetof(sl_cache_page_t, wbuf));
+        emit_rr(j, true, 0x85, RDX, RDX);       // test rdx, rdx
+        miss[2] = emit_jcc(j, CC_E);
+    } else {
+        emit_rm(j, true, 0x8b, RDX, RDX, RSP, offsetof(sl_cache_page_t, buf));
+    }
+    emit_alu_imm(j, false, ALU_AND, RAX, (1u << shift) - 1);
+}
+
+static void emit_mem(jit_ctx_t *j, sl_slac_inst_t *si, u8 pc, u4 k, bool w) {
+    static const u1 ld_size[] = { 1, 1, 2, 2, 4, 4, 8 };
+    const bool load = (si->type == SLAC_TYPE_LD);
+    const u1 size = load ? ld_size[si->func] : (1u << (si->func - SLAC_FUNC_ST1));
+
+    u1 *miss[3];
+    emit_dcache_lookup(j, si, w, size, !load, miss);
+    if (load) {
+        u4 op;
+        bool wide_op = false;
+        switch (si->func) {
+        case SLAC_FUNC_LD1:     op = 0x0fb6;                    break;  // movzx
+        case SLAC_FUNC_LD1S:    op = 0x0fbe;    wide_op = w;    break;  // movsx
+        case SLAC_FUNC_LD2:     op = 0x0fb7;                    break;
+        case SLAC_FUNC_LD2S:    op = 0x0fbf;    wide_op = w;    break;
+        case SLAC_FUNC_LD4:     op = 0x8b;                      break;
+        case SLAC_FUNC_LD4S:
+            if (w) { op = 0x63; wide_op = true; }               // movsxd
+            else   { op = 0x8b; }
+            break;
+        default:                op = 0x8b;      wide_op = true; break;
+        }
+        emit_rm(j, wide_op, op, RCX, RDX, RAX, 0);
+        if (si->d0 != SLAC_REG_DISCARD) store_guest(j, si->d0, RCX);
+    } else {
+        load_guest(j, RCX, si->d0);
+        switch (size) {
+        case 1: emit_rm(j, false, 0x88, RCX, RDX, RAX, 0);  break;
+        case 2: emit1(j, 0x66);
+                emit_rm(j, false, 0x89, RCX, RDX, RAX, 0);  break;
+        case 4: emit_rm(j, false, 0x89, RCX, RDX, RAX, 0);  break;
+        case 8: emit_rm(j, true,  0x89, RCX, RDX, RAX, 0);  break;
+        }
+    }
+    u1 *done = emit_jmp(j);
+
+    // the handler fills the dcache, writes code or raises the exception
+    if (miss[0] != NULL) jit_patch(j, miss[0]);
+    jit_patch(j, miss[1]);
+    if (miss[2] != NULL) jit_patch(j, miss[2]);
+    const u4 dirty = j->dirty;
+    emit_call(j, si, pc, k);
+    j->dirty = dirty;
+    jit_patch(j, done);
+}
+
+// last instruction of a block, all registers have been written back
+static void emit_branch(jit_ctx_t *j, sl_slac_inst_t *si, u8 pc, u8 next, bool w) {
+    const u8 target = trunc_rlen(w, pc + si->imm);
+    const bool reg = si->arg & SLAC_IN_ARG_R1;
+    u1 cc;
+
+    switch (si->func) {
+    case SLAC_FUNC_B:
+    case SLAC_FUNC_BL:
+        if (reg) {
+            // read the target before the link is written
+            load_guest(j, RAX, si->r0);
+            emit_alu_imm(j, w, ALU_ADD, RAX, trunc_rlen(w, si->imm));
+        }
+        if (si->func == SLAC_FUNC_BL)
+            emit_store_imm(j, reg_disp(si->d0), trunc_rlen(w, pc + si->r2));
+        if (reg) emit_core(j, true, 0x89, RAX, OFF_PC);
+        else     emit_store_imm(j, OFF_PC, target);
+        emit_core(j, false, 0xc6, 0, OFF_BT);   // mov byte [branch_taken], 1
+        emit1(j, 1);
+        return;
+
+    case SLAC_FUNC_CBEQ:    cc = CC_E;  break;
+    case SLAC_FUNC_CBNE:    cc = CC_NE; break;
+    case SLAC_FUNC_CBLTU:   cc = CC_B;  break;
+    case SLAC_FUNC_CBLTS:   cc = CC_L;  break;
+    case SLAC_FUNC_CBGEU:   cc = CC_AE; break;
+    default:                cc = CC_GE; break;
+    }
+
+    load_guest(j, RAX, si->r0);
+    op_guest(j, w, 0x3b, RAX, si->r1);
+    u1 *taken = emit_jcc(j, cc);
+    emit_store_imm(j, OFF_PC, next);
+    u1 *done = emit_jmp(j);
+    jit_patch(j, taken);
+    emit_store_imm(j, OFF_PC, target);
+    emit_core(j, false, 0xc6, 0, OFF_BT);
+    emit1(j, 1);
+    jit_patch(j, done);
+}
+
+// ----------------------------------------------------------------------------
+// interface
+// ----------------------------------------------------------------------------
+
+static inline jit_entry_t *jit_entry(sl_jit_t *jit, const sl_slac_inst_t *si) {
+    const u8 h = ((uptr)si / sizeof(sl_slac_inst_t)) * 0x9e3779b97f4a7c15ull;
+    return &jit->table[h >> (64 - __builtin_ctz(JIT_TABLE_SIZE))];
+}
+
+sl_jit_block_t sl_jit_lookup(sl_jit_t *jit, const sl_slac_inst_t *si) {
+    const jit_entry_t *e = jit_entry(jit, si);
+    return (e->si == si) ? e->code : NULL;
+}
+
+void sl_jit_forget(sl_jit_t *jit, const sl_slac_inst_t *si) {
+    jit_entry_t *e = jit_entry(jit, si);
+    if (e->si == si) e->si = NULL;
+}
+
+// Change the protection of the arena pages overlapping [start, end).
+static int jit_protect(sl_jit_t *jit, u1 *start, u1 *end, int prot) {
+    const uptr lo = (uptr)start & ~jit->page_mask;
+    const uptr hi = ((uptr)end + jit->page_mask) & ~jit->page_mask;
+    return mprotect((void *)lo, hi - lo, prot) ? SL_ERR_MEM : 0;
+}
+
+// Drop all compiled code. Blocks look for their code again the next time they
+// run, and are compiled again once they are hot.
+static void jit_flush(sl_jit_t *jit) {
+    memset(jit->table, 0, sizeof(jit->table));
+    jit->used = 0;
+    jit->stats.flushes++;
+}
+
+int sl_jit_compile(sl_jit_t *jit, sl_core_t *c, sl_slac_inst_t *si) {
+    if (jit->used + JIT_BLOCK_RESERVE > jit->size)
+        jit_flush(jit);
+
+    jit_ctx_t j;
+    j.core = c;
+    j.p = jit->base + jit->used;
+    u1 *start = j.p;
+    // The pages may hold the end of the previous block, which isn't running.
+    // If they can't be changed, it may no longer run either.
+    if (jit_protect(jit, start, start + JIT_BLOCK_RESERVE, PROT_READ | PROT_WRITE)) {
+        jit_flush(jit);
+        return SL_ERR_MEM;
+    }
+
+    const u4 n = si->blen;
+    alloc_regs(&j, si, n);
+    emit_prologue(&j);
+
+    sl_slac_inst_t *p = si;
+    u8 pc = c->pc;
+    bool branched = false;
+    for (u4 k = 0; k < n; ) {
+        const bool w = is_wide(p);
+        const u1 len = slac_inst_len(p);
+        const u8 next = trunc_rlen(w, pc + len);
+
+        switch (classify(c, p)) {
+        case JK_ALU_DRI:    emit_alu_dri(&j, p, w);         break;
+        case JK_ALU_DRR:    emit_alu_drr(&j, p, w);         break;
+        case JK_MOVI:       emit_movi(&j, p, pc, w);        break;
+        case JK_NOP:                                        break;
+        case JK_LD:
+        case JK_ST:         emit_mem(&j, p, pc, k, w);      break;
+
+        case JK_MOVR:
+            load_guest(&j, RAX, p->r0);
+            store_guest(&j, p->d0, RAX);
+            break;
+
+        case JK_BR:
+            write_back(&j);
+            emit_branch(&j, p, pc, next, w);
+            branched = true;
+            break;
+
+        default:
+            emit_call(&j, p, pc, k);
+            break;
+        }
+        k += slac_inst_count(p);
+        pc = next;
+        p += len / 2;
+    }
+
+    if (!branched) {
+        write_back(&j);
+        emit_store_imm(&j, OFF_PC, pc);
+    }
+    emit_rr(&j, false, 0x33, RAX, RAX);
+    emit_epilogue(&j, n);
+
+    if (jit_protect(jit, start, j.p, PROT_READ | PROT_EXEC)) {
+        jit_flush(jit);
+        return SL_ERR_MEM;
+    }
+    jit->used += j.p - start;
+    jit->used = (jit->used + 15) & ~((usize)15);
+    jit->stats.compiled++;
+    jit_entry_t *e = jit_entry(jit, si);
+    e->si = si;
+    e->code = (sl_jit_block_t)start;
+    return 0;
+}
+
+int sl_jit_create(sl_jit_t **j_out, usize size) {
+#if SLAC_TRACE
+    // traced instructions are bound to the tracing dispatcher
+    return SL_ERR_UNSUPPORTED;
+#else
+    if (size < JIT_BLOCK_RESERVE) return SL_ERR_ARG;
+    sl_jit_t *j = calloc(1, sizeof(*j));
+    if (j == NULL) return SL_ERR_MEM;
+
+    j->page_mask = sysconf(_SC_PAGESIZE) - 1;
+    size = (size + j->page_mask) & ~j->page_mask;
+    void *m = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) {
+        free(j);
+        return SL_ERR_MEM;
+    }
+    j->base = m;
+    j->size = size;
+    *j_out = j;
+    return 0;
+#endif
+}
+
+void sl_jit_destroy(sl_jit_t *j) {
+    munmap(j->base, j->size);
+    free(j);
+}
+
+void sl_jit_get_stats(sl_jit_t *j, sl_jit_stats_t *s) {
+    *s = j->stats;
+}
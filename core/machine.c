@@ -5,14 +5,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <core/bus.h>
 #include <core/common.h>
+#include <core/lock.h>
 #include <core/core.h>
 #include <core/mem.h>
 #include <core/riscv.h>
 #include <core/sym.h>
 #include <core/worker.h>
+#include <device/sled/intc.h>
 #include <device/sled/sled.h>
 #include <sled/arch.h>
 #include <sled/elf.h>
@@ -20,12 +23,22 @@
 #include <sled/machine.h>
 #include <sled/chrono.h>
 
-#define MACHINE_MAX_CORES   4
+#define MACHINE_MAX_CORES   INTC_MAX_HARTS
+
+// irq number of the external interrupt on the cores
+#define MACHINE_CORE_EXT_IRQ    11  // todo: get proper irq number
 
 typedef struct {
+    sl_machine_t *machine;
     sl_core_t *core;
     sl_worker_t worker;
     u4 epid;
+
+    // worker thread started by sl_machine_start
+    pthread_t thread;
+    bool started;
+    bool stopped;
+    int status;
 } machine_core_t;
 
 struct sl_machine {
@@ -35,6 +48,10 @@ struct sl_machine {
     u4 core_count;
     sl_list_t dev_list;
     machine_core_t mc[MACHINE_MAX_CORES];
+
+    sl_lock_t run_lock;
+    sl_cond_t run_cond;     // signalled when a core thread stops
+    int first_stopped;      // id of the first core to stop, -1 if none
 };
 
 extern const void * dyn_dev_ops_list[];
@@ -43,6 +60,10 @@ sl_chrono_t * sl_machine_get_chrono(sl_machine_t *m) {
     return m->chrono;
 }
 
+sl_mapper_t * sl_machine_get_mapper(sl_machine_t *m) {
+    return bus_get_mapper(m->bus);
+}
+
 static const sl_dev_ops_t * get_ops_for_device(u4 type) {
     for (int i = 0; dyn_dev_ops_list[i] != NULL; i++) {
         const sl_dev_ops_t * const *p = dyn_dev_ops_list[i];
@@ -74,6 +95,9 @@ int sl_machine_create(sl_machine_t **m_out) {
     }
 
     sl_list_init(&m->dev_list);
+    sl_lock_init(&m->run_lock);
+    sl_cond_init(&m->run_cond);
+    m->first_stopped = -1;
     int err;
     sl_dev_config_t cfg;
     cfg.machine = m;
@@ -87,6 +111,8 @@ int sl_machine_create(sl_machine_t **m_out) {
 out_err:
     sl_chrono_destroy(m->chrono);
     sl_bus_destroy(m->bus);
+    sl_cond_destroy(&m->run_cond);
+    sl_lock_destroy(&m->run_lock);
     free(m);
     return err;
 }
@@ -136,11 +162,14 @@ int sl_machine_add_device_prefab(sl_machine_t *m, u8 base, sl_dev_t *d) {
     return err;
 }
 
-int sl_machine_add_core(sl_machine_t *m, sl_core_params_t *opts) {
+int sl_machine_add_core(sl_machine_t *m, const sl_core_params_t *opts) {
     if (m->core_count >= MACHINE_MAX_CORES) return SL_ERR_FULL;
+    // cores are added in hart id order, the id doubles as the intc target
+    if (opts->id != m->core_count) return SL_ERR_ARG;
 
     machine_core_t *mc = &m->mc[m->core_count];
     // mc->mapper = bus_get_mapper(m->bus);
+    mc->machine = m;
     mc->core = NULL;
 
     int err;
@@ -149,12 +178,13 @@ int sl_machine_add_core(sl_machine_t *m, sl_core_params_t *opts) {
         return err;
     }
 
-    opts->bus = m->bus;
-    if (opts->name == NULL) opts->name = "core";
+    sl_core_params_t params = *opts;
+    params.bus = m->bus;
+    if (params.name == NULL) params.name = "core";
 
-    switch (opts->arch) {
+    switch (params.arch) {
     case SL_ARCH_RISCV:
-        err = sl_riscv_core_create(opts, &mc->core);
+        err = sl_riscv_core_create(&params, &mc->core);
         break;
 
     default:
@@ -173,10 +203,11 @@ int sl_machine_add_core(sl_machine_t *m, sl_core_params_t *opts) {
         goto out_err;
     }
 
-    opts->id = m->core_count;
     if (m->intc != NULL) {
-        sl_irq_ep_t *ep = sled_intc_get_irq_ep(m->intc);
-        sl_irq_endpoint_set_client(ep, &mc->core->engine.irq_ep, 11); // todo: get proper irq number
+        if ((err = sled_intc_set_target(m->intc, params.id, &mc->core->engine.irq_ep, MACHINE_CORE_EXT_IRQ))) {
+            fprintf(stderr, "sled_intc_set_target failed: %s\n", st_err(err));
+            goto out_err;
+        }
     }
     m->core_count++;
     return 0;
@@ -204,10 +235,92 @@ sl_dev_t * sl_machine_get_device_for_name(sl_machine_t *m, const char *name) {
 int sl_machine_set_interrupt(sl_machine_t *m, u4 irq, bool high) {
     if (m->intc == NULL) return SL_ERR_IO_NODEV;
     sl_irq_ep_t *ep = sled_intc_get_irq_ep(m->intc);
-    return sl_irq_endpoint_assert(ep, irq, high);
+    // through the intc's handler so the change reaches the cores
+    return ep->assert(ep, irq, high);
+}
+
+static void * machine_core_thread(void *arg) {
+    machine_core_t *mc = arg;
+    sl_machine_t *m = mc->machine;
+    const int err = sl_worker_run(&mc->worker);
+
+    sl_lock_lock(&m->run_lock);
+    mc->status = err;
+    mc->stopped = true;
+    if (m->first_stopped < 0) m->first_stopped = mc - m->mc;
+    sl_cond_signal_all(&m->run_cond);
+    sl_lock_unlock(&m->run_lock);
+    return NULL;
+}
+
+int sl_machine_start(sl_machine_t *m) {
+    if (m->core_count == 0) return SL_ERR_STATE;
+    for (u4 i = 0; i < m->core_count; i++) {
+        if (m->mc[i].started) return SL_ERR_BUSY;
+    }
+    m->first_stopped = -1;
+
+    int err = 0;
+    for (u4 i = 0; i < m->core_count; i++) {
+        machine_core_t *mc = &m->mc[i];
+        mc->stopped = false;
+        mc->status = 0;
+        if (pthread_create(&mc->thread, NULL, machine_core_thread, mc)) {
+            err = SL_ERR_SYSTEM;
+            break;
+        }
+        mc->started = true;
+    }
+    if (err) {
+        sl_machine_stop(m);
+        sl_machine_join(m);
+        return err;
+    }
+    for (u4 i = 0; i < m->core_count; i++)
+        sl_core_async_command(m->mc[i].core, SL_CORE_CMD_RUN, false);
+    return 0;
+}
+
+int sl_machine_wait(sl_machine_t *m, u4 *id_out) {
+    sl_lock_lock(&m->run_lock);
+    bool started = false;
+    for (u4 i = 0; i < m->core_count; i++) started |= m->mc[i].started;
+    if (!started) {
+        sl_lock_unlock(&m->run_lock);
+        return SL_ERR_STATE;
+    }
+    while (m->first_stopped < 0) sl_cond_wait(&m->run_cond, &m->run_lock);
+    const u4 id = m->first_stopped;
+    const int err = m->mc[id].status;
+    sl_lock_unlock(&m->run_lock);
+    *id_out = id;
+    return err;
+}
+
+void sl_machine_stop(sl_machine_t *m) {
+    for (u4 i = 0; i < m->core_count; i++) {
+        machine_core_t *mc = &m->mc[i];
+        sl_lock_lock(&m->run_lock);
+        const bool running = mc->started && !mc->stopped;
+        sl_lock_unlock(&m->run_lock);
+        if (running) sl_core_async_command(mc->core, SL_CORE_CMD_EXIT, false);
+    }
+}
+
+int sl_machine_join(sl_machine_t *m) {
+    int err = 0;
+    for (u4 i = 0; i < m->core_count; i++) {
+        machine_core_t *mc = &m->mc[i];
+        if (!mc->started) continue;
+        if (pthread_join(mc->thread, NULL)) err = SL_ERR_SYSTEM;
+        mc->started = false;
+    }
+    return err;
 }
 
 void sl_machine_destroy(sl_machine_t *m) {
+    sl_machine_stop(m);
+    sl_machine_join(m);
     for (int i = 0; i < m->core_count; i++) {
         sl_core_destroy(m->mc[i].core);
         sl_worker_shutdown(&m->mc[i].worker);
@@ -219,9 +332,113 @@ void sl_machine_destroy(sl_machine_t *m) {
     }
     sl_chrono_destroy(m->chrono);
     sl_bus_destroy(m->bus);
+    sl_cond_destroy(&m->run_cond);
+    sl_lock_destroy(&m->run_lock);
     free(m);
 }
 
+// Returns the RAM region holding the page at guest address addr, and the
+// offset of addr in it, if len bytes from addr are in the same region.
+static mem_region_t * region_for_range(sl_machine_t *m, sl_core_t *c, u8 addr, u8 len, u8 *offset_out) {
+    u8 avail;
+    u2 perm;
+    resultptr_t rp = sl_mapper_resolve(c->mapper, addr, &avail, &perm);
+    if (rp.err || (avail < len)) return NULL;
+    for (sl_list_node_t *n = sl_list_peek_first(&m->bus->mem_list); n != NULL; n = n->next) {
+        mem_region_t *r = containerof(n, mem_region_t, node);
+        if (((u1 *)rp.value >= r->data) && ((u1 *)rp.value < r->data + r->length)) {
+            *offset_out = (u1 *)rp.value - r->data;
+            return r;
+        }
+    }
+    return NULL;
+}
+
+// Whole pages of the file are mapped into RAM when the segment's file offset
+// and address agree modulo the page size, so the image is shared with the
+// page cache and loaded lazily. The partial pages at either end are copied
+// and the rest of the segment is cleared.
+static int load_segment(sl_machine_t *m, sl_core_t *c, sl_elf_obj_t *o, u8 vaddr, u8 offset, u8 filesz, u8 memsz) {
+    const u8 page = mem_page_size();
+    u8 head = filesz;
+    u8 mapped = 0;
+    if (((vaddr - offset) & (page - 1)) == 0) {
+        head = ((page - (vaddr & (page - 1))) & (page - 1));
+        if (head > filesz) head = filesz;
+        mapped = (filesz - head) & ~(page - 1);
+    }
+
+    int err;
+    if (mapped) {
+        u8 roff;
+        mem_region_t *r = region_for_range(m, c, vaddr + head, mapped, &roff);
+        if ((r == NULL) || mem_region_map_file(r, roff, mapped, sl_elf_get_fd(o), offset + head)) {
+            head = filesz;
+            mapped = 0;
+        }
+    }
+    if ((err = sl_core_mem_write(c, vaddr, 1, head, sl_elf_pointer_for_offset(o, offset))))
+        return err;
+    const u8 tail = filesz - head - mapped;
+    if (tail && (err = sl_core_mem_write(c, vaddr + head + mapped, 1, tail, sl_elf_pointer_for_offset(o, offset + head + mapped))))
+        return err;
+    if (memsz <= filesz) return 0;
+
+    u8 roff;
+    const u8 bss = memsz - filesz;
+    mem_region_t *r = region_for_range(m, c, vaddr + filesz, bss, &roff);
+    if (r != NULL) return mem_region_zero(r, roff, bss);
+    static const u1 zero[256];
+    for (u8 done = 0; done < bss; ) {
+        const u8 n = (bss - done < sizeof(zero)) ? bss - done : sizeof(zero);
+        if ((err = sl_core_mem_write(c, vaddr + filesz + done, 1, n, (void *)zero))) return err;
+        done += n;
+    }
+    return 0;
+}
+
+static int machine_configure_core(sl_core_t *c, sl_elf_obj_t *o) {
+    int err;
+    sl_core_params_t params = {};
+    sl_core_config_get(c, &params);
+
+    if (params.arch != sl_elf_arch(o)) {
+        fprintf(stderr, "elf architecture does not match core\n");
+        return SL_ERR_ARG;
+    }
+    params.subarch = sl_elf_subarch(o);
+    u4 arch_options = sl_elf_arch_options(o);
+    if (params.arch_options == 0) {
+        params.arch_options = arch_options;
+    } else if (arch_options & ~params.arch_options) {
+        fprintf(stderr, "core does not support elf arch options\n");
+        return SL_ERR_UNSUPPORTED;
+    }
+
+    if ((err = sl_core_config_set(c, &params))) {
+        fprintf(stderr, "sl_core_config_set failed: %s\n", st_err(err));
+        return err;
+    }
+
+    u8 entry = sl_elf_get_entry(o);
+    if (entry == 0) {
+        fprintf(stderr, "no entry address for binary\n");
+        return SL_ERR_ARG;
+    }
+    if (sl_elf_is_64bit(o)) sl_core_set_mode(c, SL_CORE_MODE_8);
+    sl_core_set_reg(c, SL_CORE_REG_PC, entry);
+    return 0;
+}
+
+int sl_machine_configure_core(sl_machine_t *m, u4 id, sl_elf_obj_t *o) {
+    sl_core_t *c = sl_machine_get_core(m, id);
+    if (c == NULL) {
+        fprintf(stderr, "invalid core id: %u\n", id);
+        return SL_ERR_ARG;
+    }
+    return machine_configure_core(c, o);
+}
+
 int sl_machine_load_core(sl_machine_t *m, u4 id, sl_elf_obj_t *o, bool configure) {
     sl_core_t *c = sl_machine_get_core(m, id);
     if (c == NULL) {
@@ -262,13 +479,15 @@ int sl_machine_load_core(sl_machine_t *m, u4 id, sl_elf_obj_t *o, bool configure
         // load PT_LOAD with X|W|R flags
         if (type != PT_LOAD) continue;
         if (memsz == 0) continue;
-        void *p = sl_elf_pointer_for_offset(o, offset);
-        if ((err = sl_core_mem_write(c, vaddr, 1, filesz, p))) {
+        if ((err = load_segment(m, c, o, vaddr, offset, filesz, memsz))) {
             fprintf(stderr, "failed to load core memory: %s\n", st_err(err));
             fprintf(stderr, "  vaddr=%#" PRIx64 ", filesz=%#" PRIx64 "\n", vaddr, filesz);
             goto out_err;
         }
     }
+    // the loaded memory changed underneath the caches
+    sl_cache_invalidate_all(&c->icache);
+    sl_cache_invalidate_all(&c->dcache);
 
 #if WITH_SYMBOLS
     sl = calloc(1, sizeof(*sl));
@@ -287,38 +506,7 @@ int sl_machine_load_core(sl_machine_t *m, u4 id, sl_elf_obj_t *o, bool configure
     err = 0;
     if (!configure) goto out_err;
 
-    sl_core_params_t params = {};
-    sl_core_config_get(c, &params);
-
-    if (params.arch != sl_elf_arch(o)) {
-        fprintf(stderr, "elf architecture does not match core\n");
-        err = SL_ERR_ARG;
-        goto out_err;
-    }
-    params.subarch = sl_elf_subarch(o);
-    u4 arch_options = sl_elf_arch_options(o);
-    if (params.arch_options == 0) {
-        params.arch_options = arch_options;
-    } else if (arch_options & ~params.arch_options) {
-        fprintf(stderr, "core does not support elf arch options\n");
-        err = SL_ERR_UNSUPPORTED;
-        goto out_err;
-    }
-
-    if ((err = sl_core_config_set(c, &params))) {
-        fprintf(stderr, "sl_core_config_set failed: %s\n", st_err(err));
-        goto out_err;
-    }
-
-    u8 entry = sl_elf_get_entry(o);
-    if (entry == 0) {
-        fprintf(stderr, "no entry address for binary\n");
-        err = SL_ERR_ARG;
-        goto out_err;
-    }
-    if (is64) sl_core_set_mode(c, SL_CORE_MODE_8);
-    sl_core_set_reg(c, SL_CORE_REG_PC, entry);
-    err = 0;
+    err = machine_configure_core(c, o);
 
 out_err:
 #if WITH_SYMBOLS
@@ -341,3 +529,144 @@ int sl_machine_load_core_raw(sl_machine_t *m, u4 id, u8 addr, void *buf, u8 size
     return err;
 }
 
+
+typedef struct {
+    const sl_dev_ops_t *ops;
+    void *state;
+    usize len;
+} snapshot_dev_t;
+
+struct sl_snapshot {
+    u4 mem_count;
+    int *mem_fd;
+    u8 *mem_len;
+    u4 core_count;
+    sl_core_state_t *core[MACHINE_MAX_CORES];
+    u4 dev_count;
+    snapshot_dev_t *dev;
+};
+
+void sl_snapshot_destroy(sl_snapshot_t *s) {
+    if (s == NULL) return;
+    for (u4 i = 0; i < s->mem_count; i++) {
+        if (s->mem_fd[i] >= 0) close(s->mem_fd[i]);
+    }
+    for (u4 i = 0; i < s->core_count; i++)
+        free(s->core[i]);
+    for (u4 i = 0; i < s->dev_count; i++)
+        free(s->dev[i].state);
+    free(s->mem_fd);
+    free(s->mem_len);
+    free(s->dev);
+    free(s);
+}
+
+// A core thread is running from sl_machine_start until its worker exits.
+static bool machine_running(sl_machine_t *m) {
+    bool running = false;
+    sl_lock_lock(&m->run_lock);
+    for (u4 i = 0; i < m->core_count; i++)
+        running |= m->mc[i].started && !m->mc[i].stopped;
+    sl_lock_unlock(&m->run_lock);
+    return running;
+}
+
+// Devices that master the bus are paused while memory and device state are
+// saved or restored, so the two agree.
+static void machine_pause_devices(sl_machine_t *m, bool pause) {
+    for (sl_list_node_t *n = sl_list_peek_first(&m->dev_list); n != NULL; n = n->next) {
+        sl_dev_t *d = containerof(n, sl_dev_t, node);
+        if (pause && (d->ops->pause != NULL)) d->ops->pause(d);
+        if (!pause && (d->ops->resume != NULL)) d->ops->resume(d);
+    }
+}
+
+int sl_machine_snapshot(sl_machine_t *m, sl_snapshot_t **snap_out) {
+    if (machine_running(m)) return SL_ERR_BUSY;
+    sl_snapshot_t *s = calloc(1, sizeof(*s));
+    if (s == NULL) return SL_ERR_MEM;
+
+    u4 mem_count = 0;
+    for (sl_list_node_t *n = sl_list_peek_first(&m->bus->mem_list); n != NULL; n = n->next)
+        mem_count++;
+    u4 dev_count = 0;
+    for (sl_list_node_t *n = sl_list_peek_first(&m->dev_list); n != NULL; n = n->next)
+        dev_count++;
+
+    int err = SL_ERR_MEM;
+    s->mem_fd = calloc(mem_count, sizeof(int));
+    s->mem_len = calloc(mem_count, sizeof(u8));
+    s->dev = calloc(dev_count, sizeof(snapshot_dev_t));
+    if ((mem_count && ((s->mem_fd == NULL) || (s->mem_len == NULL))) || (dev_count && (s->dev == NULL)))
+        goto out_err;
+
+    machine_pause_devices(m, true);
+    for (sl_list_node_t *n = sl_list_peek_first(&m->bus->mem_list); n != NULL; n = n->next) {
+        mem_region_t *r = containerof(n, mem_region_t, node);
+        s->mem_fd[s->mem_count] = -1;
+        s->mem_len[s->mem_count] = r->length;
+        s->mem_count++;
+        if ((err = mem_region_snapshot(r, &s->mem_fd[s->mem_count - 1]))) goto out_resume;
+    }
+    for ( ; s->core_count < m->core_count; s->core_count++) {
+        if ((err = sl_core_save_state(m->mc[s->core_count].core, &s->core[s->core_count]))) goto out_resume;
+    }
+    for (sl_list_node_t *n = sl_list_peek_first(&m->dev_list); n != NULL; n = n->next) {
+        sl_dev_t *d = containerof(n, sl_dev_t, node);
+        snapshot_dev_t *sd = &s->dev[s->dev_count++];
+        sd->ops = d->ops;
+        if ((d->ops->save != NULL) && (err = d->ops->save(d, &sd->state, &sd->len))) goto out_resume;
+    }
+    machine_pause_devices(m, false);
+    *snap_out = s;
+    return 0;
+
+out_resume:
+    machine_pause_devices(m, false);
+out_err:
+    sl_snapshot_destroy(s);
+    return err;
+}
+
+int sl_machine_restore(sl_machine_t *m, sl_snapshot_t *s) {
+    if (machine_running(m)) return SL_ERR_BUSY;
+
+    // The machine has to be laid out like the one the snapshot was taken of.
+    // Everything that can be checked is checked before any state is replaced.
+    u4 i = 0;
+    for (sl_list_node_t *n = sl_list_peek_first(&m->bus->mem_list); n != NULL; n = n->next, i++) {
+        mem_region_t *r = containerof(n, mem_region_t, node);
+        if ((i >= s->mem_count) || (s->mem_len[i] != r->length)) return SL_ERR_ARG;
+    }
+    if ((i != s->mem_count) || (s->core_count != m->core_count)) return SL_ERR_ARG;
+    for (i = 0; i < m->core_count; i++) {
+        if (s->core[i]->arch_state_len != m->mc[i].core->arch_state_len) return SL_ERR_ARG;
+    }
+    i = 0;
+    for (sl_list_node_t *n = sl_list_peek_first(&m->dev_list); n != NULL; n = n->next, i++) {
+        sl_dev_t *d = containerof(n, sl_dev_t, node);
+        if ((i >= s->dev_count) || (s->dev[i].ops != d->ops)) return SL_ERR_ARG;
+    }
+    if (i != s->dev_count) return SL_ERR_ARG;
+
+    int err;
+    machine_pause_devices(m, true);
+    i = 0;
+    for (sl_list_node_t *n = sl_list_peek_first(&m->bus->mem_list); n != NULL; n = n->next, i++) {
+        mem_region_t *r = containerof(n, mem_region_t, node);
+        if ((err = mem_region_restore(r, s->mem_fd[i]))) goto out;
+    }
+    for (i = 0; i < m->core_count; i++) {
+        if ((err = sl_core_restore_state(m->mc[i].core, s->core[i]))) goto out;
+    }
+    i = 0;
+    for (sl_list_node_t *n = sl_list_peek_first(&m->dev_list); n != NULL; n = n->next, i++) {
+        sl_dev_t *d = containerof(n, sl_dev_t, node);
+        if ((d->ops->restore != NULL) && (err = d->ops->restore(d, s->dev[i].state, s->dev[i].len))) goto out;
+    }
+    err = 0;
+
+out:
+    machine_pause_devices(m, false);
+    return err;
+}
@@ -2,6 +2,7 @@
 // Copyright (c) 2023 Shac Ron and The Sled Project
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,12 +10,21 @@
 #include <core/common.h>
 #include <core/device.h>
 #include <core/event.h>
+#include <core/lock.h>
 #include <core/mapper.h>
 #include <sled/error.h>
 #include <sled/io.h>
 #include <sled/regview.h>
 
-#define MAP_ALLOC_INCREMENT 256
+// Maps that span at most MAP_SLOT_MAX slots get a table indexed by address
+// slot, holding the only entry in the slot or one of these.
+#define MAP_SLOT_SHIFT      16
+#define MAP_SLOT_MAX        4096
+#define MAP_SLOT_NONE       0xffffffffu
+#define MAP_SLOT_MULTI      0xfffffffeu
+
+// most recently hit entries kept by each thread, by table
+#define MAP_HINTS           4
 
 struct map_ent {
     u8 va_base;
@@ -26,17 +36,57 @@ struct map_ent {
     sl_map_ep_t *ep;
 };
 
+// A table is never modified once it is published. Updates build a new one
+// and swap it in, and the old one is freed once no lookup can be using it.
+struct map_table {
+    int mode;
+    u4 num_ents;
+    u4 slot_len;                // 0 if the map is too sparse for slots
+    u8 slot_base;
+    u4 *slots;
+    sl_mapper_t *owner;         // set once retired
+    u8 retire_epoch;
+    map_table_t *retired_next;
+    map_ent_t list[];           // sorted by address
+};
+
+// Lookups take no locks and write nothing shared. Each thread doing lookups
+// has a reader of its own, which holds the map epoch it entered at, or 0
+// outside of any mapper. A replaced table is retired at the current epoch
+// and the epoch is advanced, so it can be freed once no reader is still in
+// an epoch at or before it. Readers leaving while tables wait to be freed
+// check for that, as do updates.
+typedef struct map_reader map_reader_t;
+struct map_reader {
+    _Alignas(64) _Atomic u8 epoch;
+    u4 depth;                   // nested lookups through chained mappers
+    atomic_bool in_use;
+    map_reader_t *next;
+    struct {
+        const map_table_t *table;
+        u4 index;
+    } hint[MAP_HINTS];
+};
+
+static _Atomic u8 map_epoch = 1;
+static _Atomic(map_reader_t *) map_readers;     // never freed, reused once a thread exits
+static _Thread_local map_reader_t *map_self;
+static pthread_key_t map_reader_key;
+static pthread_once_t map_reader_once = PTHREAD_ONCE_INIT;
+
+static sl_lock_t map_retire_lock = { PTHREAD_MUTEX_INITIALIZER };
+static map_table_t *map_retired;                // under map_retire_lock
+static _Atomic u8 map_retired_first = UINT64_MAX;  // oldest retire epoch waiting
+
 static int ent_compare(const void *v0, const void *v1) {
-    map_ent_t *a = *(map_ent_t **)v0;
-    map_ent_t *b = *(map_ent_t **)v1;
+    const map_ent_t *a = v0;
+    const map_ent_t *b = v1;
     if (a->va_base < b->va_base) return -1;
     if (a->va_base > b->va_base) return 1;
     return 0;
 }
 
-static map_ent_t * create_map_ent(sl_mapping_t *m) {
-    map_ent_t *n = malloc(sizeof(*n));
-    if (n == NULL) return NULL;
+static void init_map_ent(map_ent_t *n, sl_mapping_t *m) {
     n->va_base = m->input_base;
     n->va_end = m->input_base + m->length;
     n->pa_base = m->output_base;
@@ -44,46 +94,232 @@ static map_ent_t * create_map_ent(sl_mapping_t *m) {
     n->permissions = m->permissions;
     n->type = m->type;
     n->ep = m->ep;
-    return n;
 }
 
-static void finalize_mappings(sl_mapper_t *m) {
-    qsort(m->list, m->num_ents, sizeof(map_ent_t *), ent_compare);
+static map_table_t * table_alloc(int mode, u4 num_ents) {
+    map_table_t *t = calloc(1, sizeof(*t) + num_ents * sizeof(map_ent_t));
+    if (t == NULL) return NULL;
+    t->mode = mode;
+    t->num_ents = num_ents;
+    return t;
 }
 
-int sl_mappper_add_mapping(sl_mapper_t *m, sl_mapping_t *ent) {
-    map_ent_t *n = create_map_ent(ent);
-    if (n == NULL) return SL_ERR_MEM;
-
-    if ((m->num_ents % MAP_ALLOC_INCREMENT) == 0) {
-        void * p = realloc(m->list, (m->num_ents + MAP_ALLOC_INCREMENT) * sizeof(void *));
-        if (p == NULL) {
-            free(n);
-            return SL_ERR_MEM;
+static void table_free(map_table_t *t) {
+    free(t->slots);
+    free(t);
+}
+
+// The slots are only a shortcut, so a table that doesn't get them still works.
+static void table_build_slots(map_table_t *t) {
+    if (t->num_ents == 0) return;
+
+    const u8 base = t->list[0].va_base >> MAP_SLOT_SHIFT;
+    u8 end = 0;
+    for (u4 i = 0; i < t->num_ents; i++) {
+        if (t->list[i].va_end > end) end = t->list[i].va_end;
+    }
+    const u8 len = ((end - 1) >> MAP_SLOT_SHIFT) - base + 1;
+    if (len > MAP_SLOT_MAX) return;
+
+    u4 *slots = malloc(len * sizeof(u4));
+    if (slots == NULL) return;
+    for (u8 i = 0; i < len; i++)
+        slots[i] = MAP_SLOT_NONE;
+    for (u4 i = 0; i < t->num_ents; i++) {
+        const map_ent_t *e = &t->list[i];
+        if (e->va_end == e->va_base) continue;
+        const u8 first = (e->va_base >> MAP_SLOT_SHIFT) - base;
+        const u8 last = ((e->va_end - 1) >> MAP_SLOT_SHIFT) - base;
+        for (u8 j = first; j <= last; j++)
+            slots[j] = (slots[j] == MAP_SLOT_NONE) ? i : MAP_SLOT_MULTI;
+    }
+    t->slots = slots;
+    t->slot_len = len;
+    t->slot_base = base << MAP_SLOT_SHIFT;
+}
+
+static void table_finalize(map_table_t *t) {
+    qsort(t->list, t->num_ents, sizeof(map_ent_t), ent_compare);
+    table_build_slots(t);
+}
+
+static void map_reader_detach(void *arg) {
+    map_reader_t *r = arg;
+    atomic_store(&r->epoch, 0);
+    r->depth = 0;
+    memset(r->hint, 0, sizeof(r->hint));
+    atomic_store_explicit(&r->in_use, false, memory_order_release);
+}
+
+static void map_reader_key_init(void) {
+    pthread_key_create(&map_reader_key, map_reader_detach);
+}
+
+// Take over the reader of an exited thread, or add one.
+static map_reader_t * map_reader_attach(void) {
+    pthread_once(&map_reader_once, map_reader_key_init);
+    map_reader_t *r;
+    for (r = atomic_load(&map_readers); r != NULL; r = r->next) {
+        bool idle = false;
+        if (atomic_compare_exchange_strong(&r->in_use, &idle, true)) break;
+    }
+    if (r == NULL) {
+        if ((r = aligned_alloc(_Alignof(map_reader_t), sizeof(*r))) == NULL) return NULL;
+        memset(r, 0, sizeof(*r));
+        atomic_init(&r->in_use, true);
+        r->next = atomic_load(&map_readers);
+        while (!atomic_compare_exchange_weak(&map_readers, &r->next, r)) ;
+    }
+    pthread_setspecific(map_reader_key, r);
+    map_self = r;
+    return r;
+}
+
+static inline map_reader_t * map_reader(void) {
+    map_reader_t *r = map_self;
+    if (likely(r != NULL)) return r;
+    return map_reader_attach();
+}
+
+// Free the retired tables of 'owner', or of any mapper if NULL, that no
+// reader in an epoch before 'oldest' can still be using.
+static void map_retired_free(sl_mapper_t *owner, u8 oldest) {
+    u8 first = UINT64_MAX;
+    sl_lock_lock(&map_retire_lock);
+    map_table_t **link = &map_retired;
+    map_table_t *t;
+    while ((t = *link) != NULL) {
+        if ((t->retire_epoch < oldest) && ((owner == NULL) || (t->owner == owner))) {
+            *link = t->retired_next;
+            table_free(t);
+            continue;
         }
-        m->list = p;
+        if (t->retire_epoch < first) first = t->retire_epoch;
+        link = &t->retired_next;
     }
+    atomic_store_explicit(&map_retired_first, first, memory_order_relaxed);
+    sl_lock_unlock(&map_retire_lock);
+}
+
+u4 mapper_retired_count(sl_mapper_t *m) {
+    u4 count = 0;
+    sl_lock_lock(&map_retire_lock);
+    for (map_table_t *t = map_retired; t != NULL; t = t->retired_next)
+        if (t->owner == m) count++;
+    sl_lock_unlock(&map_retire_lock);
+    return count;
+}
+
+static void map_reclaim(void) {
+    // Tables retired before the current epoch were swapped out before the
+    // readers are scanned, so any reader still using one is seen.
+    u8 oldest = atomic_load(&map_epoch);
+    for (map_reader_t *r = atomic_load(&map_readers); r != NULL; r = r->next) {
+        const u8 e = atomic_load(&r->epoch);
+        if ((e != 0) && (e < oldest)) oldest = e;
+    }
+    if (oldest > atomic_load_explicit(&map_retired_first, memory_order_relaxed))
+        map_retired_free(NULL, oldest);
+}
+
+// The epoch is published before the table is loaded. A reader that loaded
+// a table before it was swapped out is in an epoch at or before the one the
+// table was retired at.
+static inline map_table_t * map_read_enter(map_reader_t *r, sl_mapper_t *m) {
+    if (r->depth++ == 0)
+        atomic_store(&r->epoch, atomic_load_explicit(&map_epoch, memory_order_acquire));
+    return atomic_load(&m->table);
+}
+
+static inline void map_read_exit(map_reader_t *r) {
+    if (--r->depth) return;
+    atomic_store_explicit(&r->epoch, 0, memory_order_release);
+    if (unlikely(atomic_load_explicit(&map_retired_first, memory_order_relaxed) != UINT64_MAX))
+        map_reclaim();
+}
 
-    m->list[m->num_ents] = n;
-    m->num_ents++;
-    finalize_mappings(m);
+// called with the mapper lock held
+static void mapper_publish(sl_mapper_t *m, map_table_t *t) {
+    map_table_t *old = atomic_exchange(&m->table, t);
+    atomic_fetch_add_explicit(&m->gen, 1, memory_order_release);
+    if (old == NULL) return;
+
+    old->owner = m;
+    old->retire_epoch = atomic_fetch_add(&map_epoch, 1);
+    sl_lock_lock(&map_retire_lock);
+    old->retired_next = map_retired;
+    map_retired = old;
+    if (old->retire_epoch < atomic_load_explicit(&map_retired_first, memory_order_relaxed))
+        atomic_store_explicit(&map_retired_first, old->retire_epoch, memory_order_relaxed);
+    sl_lock_unlock(&map_retire_lock);
+    map_reclaim();
+}
+
+static int mapper_update_locked(sl_mapper_t *m, u4 ops, u4 count, sl_mapping_t *ent_list) {
+    const map_table_t *cur = atomic_load(&m->table);
+    const int mode = ops & SL_MAP_OP_MODE_MASK;
+    map_table_t *t;
+    if (ops & SL_MAP_OP_REPLACE) {
+        if ((t = table_alloc(mode, count)) == NULL) return SL_ERR_MEM;
+        for (u4 i = 0; i < count; i++)
+            init_map_ent(&t->list[i], ent_list + i);
+    } else {
+        const u4 num = (cur == NULL) ? 0 : cur->num_ents;
+        if ((t = table_alloc(mode, num + count)) == NULL) return SL_ERR_MEM;
+        if (num) memcpy(t->list, cur->list, num * sizeof(map_ent_t));
+        for (u4 i = 0; i < count; i++)
+            init_map_ent(&t->list[num + i], ent_list + i);
+    }
+    table_finalize(t);
+    mapper_publish(m, t);
     return 0;
 }
 
-static map_ent_t * ent_for_address(sl_mapper_t *m, u8 addr) {
-    if (m->num_ents == 0) return NULL;
+int sl_mapper_update(sl_mapper_t *m, u4 ops, u4 count, sl_mapping_t *ent_list) {
+    sl_lock_lock(&m->lock);
+    int err = mapper_update_locked(m, ops, count, ent_list);
+    sl_lock_unlock(&m->lock);
+    return err;
+}
+
+int sl_mappper_add_mapping(sl_mapper_t *m, sl_mapping_t *ent) {
+    sl_lock_lock(&m->lock);
+    const map_table_t *cur = atomic_load(&m->table);
+    const int mode = (cur == NULL) ? SL_MAP_OP_MODE_BLOCK : cur->mode;
+    int err = mapper_update_locked(m, mode, 1, ent);
+    sl_lock_unlock(&m->lock);
+    return err;
+}
+
+int sl_mapper_set_mode(sl_mapper_t *m, int mode) {
+    return sl_mapper_update(m, mode & SL_MAP_OP_MODE_MASK, 0, NULL);
+}
+
+static inline bool ent_contains(const map_ent_t *e, u8 addr) {
+    return (e->va_base <= addr) && (e->va_end > addr);
+}
 
+static inline void ent_hint_set(map_reader_t *r, const map_table_t *t, u4 index) {
+    const u4 h = ((uptr)t >> 6) & (MAP_HINTS - 1);
+    r->hint[h].table = t;
+    r->hint[h].index = index;
+}
+
+static map_ent_t * ent_search(map_reader_t *r, map_table_t *t, u8 addr) {
     u4 start, end, cur;
     start = 0;
-    end = m->num_ents;
+    end = t->num_ents;
 
     do {
         cur = (start + end) / 2;
-        map_ent_t *ent = m->list[cur];
+        map_ent_t *ent = &t->list[cur];
         if (ent->va_base > addr) {
             end = cur;
         } else {
-            if (ent->va_end > addr) return ent; // found
+            if (ent->va_end > addr) {
+                ent_hint_set(r, t, cur);
+                return ent; // found
+            }
             if (start == cur) break;
             start = cur;
         }
@@ -91,29 +327,57 @@ static map_ent_t * ent_for_address(sl_mapper_t *m, u8 addr) {
     return NULL;
 }
 
-void sl_mapper_set_mode(sl_mapper_t *m, int mode) { m->mode = mode; }
-sl_mapper_t * sl_mapper_get_next(sl_mapper_t *m) { return m->next; }
-sl_map_ep_t * sl_mapper_get_ep(sl_mapper_t *m) { return &m->ep; }
+// Devices polled in a loop hit the same entry over and over, so the thread's
+// last hit in the table is checked before the slots and the search. A table
+// freed and allocated again at the same address can leave a stale hint, so
+// it is bounds checked.
+static map_ent_t * ent_for_address(map_reader_t *r, map_table_t *t, u8 addr) {
+    if (t->num_ents == 0) return NULL;
+
+    const u4 h = ((uptr)t >> 6) & (MAP_HINTS - 1);
+    if (likely(r->hint[h].table == t) && likely(r->hint[h].index < t->num_ents)) {
+        map_ent_t *e = &t->list[r->hint[h].index];
+        if (likely(ent_contains(e, addr))) return e;
+    }
 
-static int mapper_ep_io(sl_map_ep_t *ep, sl_io_op_t *op) {
-    sl_mapper_t *m = containerof(ep, sl_mapper_t, ep);
-    for ( ; ; ) {
-        if (m->mode == SL_MAP_OP_MODE_BLOCK)
-            return SL_ERR_IO_NOMAP;
-        if (m->mode != SL_MAP_OP_MODE_PASSTHROUGH)
-            break;
-        m = m->next;
+    if (t->slots != NULL) {
+        const u8 slot = (addr - t->slot_base) >> MAP_SLOT_SHIFT;
+        if ((addr < t->slot_base) || (slot >= t->slot_len)) return NULL;
+        const u4 i = t->slots[slot];
+        if (i == MAP_SLOT_NONE) return NULL;
+        if (i != MAP_SLOT_MULTI) {
+            map_ent_t *e = &t->list[i];
+            if (!ent_contains(e, addr)) return NULL;
+            ent_hint_set(r, t, i);
+            return e;
+        }
     }
+    return ent_search(r, t, addr);
+}
+
+sl_mapper_t * sl_mapper_get_next(sl_mapper_t *m) { return m->next; }
+sl_map_ep_t * sl_mapper_get_ep(sl_mapper_t *m) { return &m->ep; }
 
+static int mapper_table_io(map_reader_t *r, map_table_t *t, sl_io_op_t *op) {
     if ((op->op == IO_OP_RESOLVE) || IO_IS_ATOMIC(op->op)) {
-        map_ent_t *e = ent_for_address(m, op->addr);
+        map_ent_t *e = ent_for_address(r, t, op->addr);
         if (e == NULL)
             return SL_ERR_IO_NOMAP;
+        if (op->op == IO_OP_RESOLVE)
+            op->arg[2] &= e->permissions;
+        else if ((e->permissions & (SL_MAP_PERM_READ | SL_MAP_PERM_WRITE)) != (SL_MAP_PERM_READ | SL_MAP_PERM_WRITE))
+            return SL_ERR_IO_PERM;
         const u8 offset = op->addr - e->va_base;
         op->addr = e->pa_base + offset;
-        return e->ep->io(e->ep, op);
+        const int err = e->ep->io(e->ep, op);
+        // memory resolved through a mapping ends where the mapping does
+        const u8 avail = e->va_end - e->va_base - offset;
+        if ((err == 0) && (op->op == IO_OP_RESOLVE) && (op->arg[1] > avail))
+            op->arg[1] = avail;
+        return err;
     }
 
+    const u2 need = (op->op == IO_OP_IN) ? SL_MAP_PERM_READ : SL_MAP_PERM_WRITE;
     int err = 0;
     u8 addr = op->addr;
     const u2 size = op->size;
@@ -122,9 +386,11 @@ static int mapper_ep_io(sl_map_ep_t *ep, sl_io_op_t *op) {
     while (len) {
         // todo: check alignment
 
-        map_ent_t *e = ent_for_address(m, addr);
+        map_ent_t *e = ent_for_address(r, t, addr);
         if (e == NULL)
             return SL_ERR_IO_NOMAP;
+        if ((e->permissions & need) == 0)
+            return SL_ERR_IO_PERM;
 
         u8 offset = addr - e->va_base;
         u8 avail = e->va_end - e->va_base - offset;
@@ -144,12 +410,32 @@ static int mapper_ep_io(sl_map_ep_t *ep, sl_io_op_t *op) {
     return 0;
 }
 
+static int mapper_ep_io(sl_map_ep_t *ep, sl_io_op_t *op) {
+    sl_mapper_t *m = containerof(ep, sl_mapper_t, ep);
+    map_reader_t *r = map_reader();
+    if (r == NULL) return SL_ERR_MEM;
+    for ( ; ; ) {
+        map_table_t *t = map_read_enter(r, m);
+        const int mode = (t == NULL) ? SL_MAP_OP_MODE_BLOCK : t->mode;
+        if (mode == SL_MAP_OP_MODE_PASSTHROUGH) {
+            map_read_exit(r);
+            m = m->next;
+            continue;
+        }
+        int err = SL_ERR_IO_NOMAP;
+        if (mode != SL_MAP_OP_MODE_BLOCK)
+            err = mapper_table_io(r, t, op);
+        map_read_exit(r);
+        return err;
+    }
+}
+
 int sl_mapper_io(void *ctx, sl_io_op_t *op) {
     sl_mapper_t *m = ctx;
     return mapper_ep_io(&m->ep, op);
 }
 
-resultptr_t sl_mapper_resolve(sl_mapper_t *m, u8 addr, u8 *len_out) {
+resultptr_t sl_mapper_resolve(sl_mapper_t *m, u8 addr, u8 *len_out, u2 *perm_out) {
     resultptr_t res;
     sl_io_op_t op;
 
@@ -158,74 +444,67 @@ resultptr_t sl_mapper_resolve(sl_mapper_t *m, u8 addr, u8 *len_out) {
     op.op = IO_OP_RESOLVE;
     op.align = 1;
     op.count = 1;
+    op.arg[2] = SL_MAP_PERM_ALL;
     res.err = mapper_ep_io(&m->ep, &op);
     if (res.err == 0) {
         *len_out = op.arg[1];
+        *perm_out = op.arg[2];
         res.value = (void *)op.arg[0];
     }
     return res;
 }
 
-int mapper_update(sl_mapper_t *m, sl_event_t *ev) {
-    if (ev->type != SL_MAP_EV_TYPE_UPDATE) return SL_ERR_ARG;
-    int err = 0;
-
-    u4 op = ev->arg[0];
-    if (op & SL_MAP_OP_REPLACE) {
-        u4 count = ev->arg[1];
-        sl_mapping_t *ent_list = (sl_mapping_t *)(ev->arg[2]);
-
-        u4 size = ((count + MAP_ALLOC_INCREMENT - 1) / MAP_ALLOC_INCREMENT) * MAP_ALLOC_INCREMENT;
-        map_ent_t **list = calloc(size, sizeof(map_ent_t *));
-        if (list == NULL) return SL_ERR_MEM;
-
-        for (u4 i = 0; i < count; i++) {
-            list[i] = create_map_ent(ent_list + i);
-            if (list[i] == NULL) {
-                err = SL_ERR_MEM;
-                break;
-            }
-        }
-
-        u4 fnum = m->num_ents;
-        map_ent_t **flist = m->list;
-        if (err) {
-            fnum = count;
-            flist = list;
-        }
-        for (u4 i = 0; i < fnum; i++) {
-            if (flist[i] != NULL) free(flist[i]);
-        }
-        free(flist);
-        free(ent_list);
-        if (err) return err;
+void sl_mapper_log_write(sl_mapper_t *m, void *buf, u8 len) {
+    sl_lock_lock(&m->lock);
+    const u4 seq = atomic_load_explicit(&m->write_seq, memory_order_relaxed);
+    m->write_log[seq % MAPPER_WRITE_LOG].lo = (uptr)buf;
+    m->write_log[seq % MAPPER_WRITE_LOG].hi = (uptr)buf + len;
+    atomic_store_explicit(&m->write_seq, seq + 1, memory_order_release);
+    sl_lock_unlock(&m->lock);
+}
 
-        m->num_ents = count;
-        m->list = list;
-        finalize_mappings(m);
+bool mapper_logged_writes(sl_mapper_t *m, u4 *seq, void (*fn)(void *ctx, uptr lo, uptr hi), void *ctx) {
+    sl_lock_lock(&m->lock);
+    const u4 end = atomic_load_explicit(&m->write_seq, memory_order_relaxed);
+    const bool kept = (end - *seq) <= MAPPER_WRITE_LOG;
+    if (kept) {
+        for (u4 i = *seq; i != end; i++)
+            fn(ctx, m->write_log[i % MAPPER_WRITE_LOG].lo, m->write_log[i % MAPPER_WRITE_LOG].hi);
     }
-    m->mode = op & SL_MAP_OP_MODE_MASK;
-    return 0;
+    *seq = end;
+    sl_lock_unlock(&m->lock);
+    return kept;
+}
+
+int mapper_update(sl_mapper_t *m, sl_event_t *ev) {
+    if (ev->type != SL_MAP_EV_TYPE_UPDATE) return SL_ERR_ARG;
+    sl_mapping_t *ent_list = (sl_mapping_t *)(ev->arg[2]);
+    int err = sl_mapper_update(m, ev->arg[0], ev->arg[1], ent_list);
+    free(ent_list);
+    return err;
 }
 
 void mapper_init(sl_mapper_t *m) {
     memset(m, 0, sizeof(*m));
+    sl_lock_init(&m->lock);
     m->ep.io = mapper_ep_io;
 }
 
 int sl_mapper_create(sl_mapper_t **map_out) {
-    sl_mapper_t *m = calloc(1, sizeof(*m));
+    sl_mapper_t *m = malloc(sizeof(*m));
     if (m == NULL) return SL_ERR_MEM;
-    m->ep.io = mapper_ep_io;
+    mapper_init(m);
     *map_out = m;
     return 0;
 }
 
+// No lookups may be running at shutdown, so the tables it retired can go
+// without waiting for readers.
 void mapper_shutdown(sl_mapper_t *m) {
-    for (u4 i = 0; i < m->num_ents; i++) {
-        free(m->list[i]);
-    }
-    free(m->list);
+    map_table_t *t = atomic_exchange(&m->table, NULL);
+    if (t != NULL) table_free(t);
+    map_retired_free(m, UINT64_MAX);
+    sl_lock_destroy(&m->lock);
 }
 
 void sl_mapper_destroy(sl_mapper_t *m) {
@@ -237,7 +516,11 @@ void sl_mapper_destroy(sl_mapper_t *m) {
 void mapper_print_mappings(sl_mapper_t *m) {
     printf("mapper\n");
     bool has_next = false;
-    switch (m->mode) {
+    map_reader_t *r = map_reader();
+    if (r == NULL) return;
+    map_table_t *t = map_read_enter(r, m);
+    const int mode = (t == NULL) ? SL_MAP_OP_MODE_BLOCK : t->mode;
+    switch (mode) {
     case SL_MAP_OP_MODE_PASSTHROUGH:
         printf("  passthrough\n");
         has_next = true;
@@ -248,9 +531,9 @@ void mapper_print_mappings(sl_mapper_t *m) {
         break;
 
     case SL_MAP_OP_MODE_TRANSLATE:
-        for (u4 i = 0; i < m->num_ents; i++) {
+        for (u4 i = 0; i < t->num_ents; i++) {
             sl_dev_t *d;
-            map_ent_t *ent = m->list[i];
+            map_ent_t *ent = &t->list[i];
             printf("  %#20" PRIx64 " %#20" PRIx64 " %#20" PRIx64 "", ent->pa_base, ent->va_base, ent->va_end - ent->va_base);
 
             switch (ent->type) {
@@ -284,5 +567,6 @@ void mapper_print_mappings(sl_mapper_t *m) {
         break;
     }
 
+    map_read_exit(r);
     if (has_next) mapper_print_mappings(m->next);
 }
@@ -1,14 +1,27 @@
 // SPDX-License-Identifier: MIT License
 // Copyright (c) 2022-2025 Shac Ron and The Sled Project
 
+#if __linux__
+#define _GNU_SOURCE     // memfd_create
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include <core/common.h>
 #include <core/mem.h>
 #include <sled/error.h>
 #include <sled/io.h>
 
+// Regions at least this large are aligned to it so the host can back them
+// with huge pages.
+#define MEM_HUGE_SIZE   (2ull << 20)
+
 static int mem_io(sl_map_ep_t *ep, sl_io_op_t *op) {
     mem_region_t *m = containerof(ep, mem_region_t, ep);
     void *data = m->data + op->addr;
@@ -29,10 +42,44 @@ static int mem_io(sl_map_ep_t *ep, sl_io_op_t *op) {
     }
 }
 
+// Mapping over part of a region replaces the host's mapping there, and with
+// it the huge page advice, so it is given again for the new range.
+static void mem_advise_huge(mem_region_t *m, void *p, usize len) {
+#ifdef MADV_HUGEPAGE
+    if (m->length >= MEM_HUGE_SIZE) madvise(p, len, MADV_HUGEPAGE);
+#endif
+}
+
+// Anonymous memory is zero filled and only committed when touched, so large
+// sparse regions cost what the guest uses.
+static void * mem_map(u8 length, usize *len_out) {
+    const u8 page = mem_page_size();
+    const u8 align = (length >= MEM_HUGE_SIZE) ? MEM_HUGE_SIZE : page;
+    const u8 len = (length + align - 1) & ~(align - 1);
+    if ((len < length) || (len + align < len)) return NULL;
+
+    // reserve extra for alignment and trim it off both ends
+    u1 *p = mmap(NULL, len + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    u1 *data = (u1 *)(((uptr)p + align - 1) & ~(uptr)(align - 1));
+    if (data > p) munmap(p, data - p);
+    const usize tail = (p + len + align) - (data + len);
+    if (tail) munmap(data + len, tail);
+
+#ifdef MADV_HUGEPAGE
+    if (align == MEM_HUGE_SIZE) madvise(data, len, MADV_HUGEPAGE);
+#endif
+    *len_out = len;
+    return data;
+}
+
 int mem_region_create(u8 base, u8 length, mem_region_t **m_out) {
-    const usize size = length + sizeof(mem_region_t);
-    mem_region_t *m = calloc(1, size);
+    mem_region_t *m = calloc(1, sizeof(*m));
     if (m == NULL) return SL_ERR_MEM;
+    if ((m->data = mem_map(length, &m->map_len)) == NULL) {
+        free(m);
+        return SL_ERR_MEM;
+    }
 
     m->base = base;
     m->length = length;
@@ -41,7 +88,203 @@ int mem_region_create(u8 base, u8 length, mem_region_t **m_out) {
     return 0;
 }
 
+static int mem_track_file(mem_region_t *m, u8 offset, u8 len, int fd, u8 file_offset) {
+    mem_file_map_t *f = malloc(sizeof(*f));
+    if (f == NULL) return SL_ERR_MEM;
+    if ((f->fd = dup(fd)) < 0) {
+        free(f);
+        return SL_ERR_SYSTEM;
+    }
+    f->offset = offset;
+    f->len = len;
+    f->file_offset = file_offset;
+    f->next = m->files;
+    m->files = f;
+    return 0;
+}
+
+static void mem_untrack_files(mem_region_t *m) {
+    mem_file_map_t *next;
+    for (mem_file_map_t *f = m->files; f != NULL; f = next) {
+        next = f->next;
+        close(f->fd);
+        free(f);
+    }
+    m->files = NULL;
+}
+
 void mem_region_destroy(mem_region_t *m) {
+    mem_untrack_files(m);
+    munmap(m->data, m->map_len);
     free(m);
 }
 
+usize mem_page_size(void) {
+    return sysconf(_SC_PAGESIZE);
+}
+
+int mem_region_map_file(mem_region_t *m, u8 offset, u8 len, int fd, u8 file_offset) {
+    const usize page = mem_page_size();
+    if ((offset | len | file_offset) & (page - 1)) return SL_ERR_ARG;
+    if ((offset > m->map_len) || (len > m->map_len - offset)) return SL_ERR_RANGE;
+    void *p = mmap(m->data + offset, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, file_offset);
+    if (p == MAP_FAILED) return SL_ERR_MEM;
+    mem_advise_huge(m, p, len);
+    return mem_track_file(m, offset, len, fd, file_offset);
+}
+
+// Whole pages are replaced with fresh anonymous memory so they aren't
+// committed, the partial pages at the ends are cleared.
+int mem_region_zero(mem_region_t *m, u8 offset, u8 len) {
+    if ((offset > m->length) || (len > m->length - offset)) return SL_ERR_RANGE;
+    const usize page = mem_page_size();
+    const u8 start = (offset + page - 1) & ~(u8)(page - 1);
+    const u8 end = (offset + len) & ~(u8)(page - 1);
+    if (start >= end) {
+        memset(m->data + offset, 0, len);
+        return 0;
+    }
+    memset(m->data + offset, 0, start - offset);
+    memset(m->data + end, 0, offset + len - end);
+    void *p = mmap(m->data + start, end - start, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) return SL_ERR_MEM;
+    mem_advise_huge(m, p, end - start);
+    return 0;
+}
+
+// Snapshots are kept in an anonymous file. Restoring maps the file privately
+// over the region, so the region reads as the snapshot and only the pages
+// the guest writes afterwards are copied.
+static int mem_file_create(usize len) {
+#if __linux__
+    int fd = memfd_create("sled-mem", MFD_CLOEXEC);
+#else
+    char name[64];
+    snprintf(name, sizeof(name), "/sled-mem-%d-%lx", getpid(), (unsigned long)(uptr)&name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) shm_unlink(name);
+#endif
+    if (fd < 0) return -1;
+    if (ftruncate(fd, len)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool mem_page_is_zero(const u1 *p, usize len) {
+    const u8 *w = (const u8 *)p;
+    for (usize i = 0; i < len / sizeof(u8); i++) {
+        if (w[i]) return false;
+    }
+    return true;
+}
+
+// The file is tracked before the region is remapped, so the region is never
+// left mapped to a file it doesn't track.
+int mem_region_restore(mem_region_t *m, int fd) {
+    mem_file_map_t *old = m->files;
+    m->files = NULL;
+    int err = mem_track_file(m, 0, m->map_len, fd, 0);
+    if (err == 0) {
+        void *p = mmap(m->data, m->map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+        if (p != MAP_FAILED) {
+            mem_advise_huge(m, p, m->map_len);
+            mem_file_map_t *cur = m->files;
+            m->files = old;
+            mem_untrack_files(m);
+            m->files = cur;
+            return 0;
+        }
+        mem_untrack_files(m);
+        err = SL_ERR_MEM;
+    }
+    m->files = old;
+    return err;
+}
+
+static void mem_mark_range(u1 *mark, u8 lo, u8 hi, usize page) {
+    memset(mark + (lo / page), 1, ((hi + page - 1) / page) - (lo / page));
+}
+
+// Mark the pages of the region that can hold data, everything else reads as
+// zero. Pages the host has populated, resident or swapped, are found in the
+// page map. Untouched pages of files mapped into the region aren't populated
+// yet, so the data ranges of those files are added.
+static void mem_mark_populated(mem_region_t *m, u1 *mark, usize page) {
+    const usize num = m->map_len / page;
+#if __linux__
+    const u8 present = (1ull << 63) | (1ull << 62);
+    u8 ent[512];
+    int pm = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    for (usize i = 0; (pm >= 0) && (i < num); ) {
+        const usize want = (num - i < 512) ? num - i : 512;
+        const ssize_t n = pread(pm, ent, want * sizeof(u8), (((uptr)m->data / page) + i) * sizeof(u8));
+        if (n <= 0) {
+            close(pm);
+            pm = -1;
+            break;
+        }
+        for (usize j = 0; j < (usize)n / sizeof(u8); j++, i++)
+            mark[i] = (ent[j] & present) != 0;
+    }
+    if (pm >= 0) close(pm);
+    else memset(mark, 1, num);
+#else
+    memset(mark, 1, num);
+#endif
+
+    for (mem_file_map_t *f = m->files; f != NULL; f = f->next) {
+        const off_t end = f->file_offset + f->len;
+        for (off_t pos = f->file_offset; pos < end; ) {
+            off_t data = lseek(f->fd, pos, SEEK_DATA);
+            if (data < 0) {
+                // no more data, or no way to find it
+                if (errno != ENXIO) mem_mark_range(mark, f->offset + (pos - f->file_offset), f->offset + f->len, page);
+                break;
+            }
+            if (data >= end) break;
+            off_t hole = lseek(f->fd, data, SEEK_HOLE);
+            if ((hole < 0) || (hole > end)) hole = end;
+            mem_mark_range(mark, f->offset + (data - f->file_offset), f->offset + (hole - f->file_offset), page);
+            pos = hole;
+        }
+    }
+}
+
+int mem_region_snapshot(mem_region_t *m, int *fd_out) {
+    const usize page = mem_page_size();
+    u1 *mark = calloc(m->map_len / page, 1);
+    if (mark == NULL) return SL_ERR_MEM;
+    int fd = mem_file_create(m->map_len);
+    if (fd < 0) {
+        free(mark);
+        return SL_ERR_SYSTEM;
+    }
+
+    // runs of unpopulated and zero pages are left as holes in the file
+    mem_mark_populated(m, mark, page);
+    usize start = 0;
+    for (usize i = 0, off = 0; off <= m->map_len; i++, off += page) {
+        if ((off < m->map_len) && mark[i] && !mem_page_is_zero(m->data + off, page)) continue;
+        while (start < off) {
+            ssize_t n = pwrite(fd, m->data + start, off - start, start);
+            if (n <= 0) {
+                free(mark);
+                close(fd);
+                return SL_ERR_SYSTEM;
+            }
+            start += n;
+        }
+        start = off + page;
+    }
+    free(mark);
+
+    int err = mem_region_restore(m, fd);
+    if (err) {
+        close(fd);
+        return err;
+    }
+    *fd_out = fd;
+    return 0;
+}
@@ -174,13 +174,12 @@ static result8_t rv_csr_pmpcfg(rv_core_t *c, int op, u4 index, u8 value) {
 }
 
 static u4 rv_fflags_from_host_fexc(u4 fexc) {
-    int set = fetestexcept(fexc);
     u4 flags = 0;
-    if (set & FE_INEXACT)   flags |= RV_FCSR_NX;
-    if (set & FE_UNDERFLOW) flags |= RV_FCSR_UF;
-    if (set & FE_OVERFLOW)  flags |= RV_FCSR_OF;
-    if (set & FE_DIVBYZERO) flags |= RV_FCSR_DZ;
-    if (set & FE_INVALID)   flags |= RV_FCSR_NV;
+    if (fexc & FE_INEXACT)   flags |= RV_FCSR_NX;
+    if (fexc & FE_UNDERFLOW) flags |= RV_FCSR_UF;
+    if (fexc & FE_OVERFLOW)  flags |= RV_FCSR_OF;
+    if (fexc & FE_DIVBYZERO) flags |= RV_FCSR_DZ;
+    if (fexc & FE_INVALID)   flags |= RV_FCSR_NV;
     return flags;
 }
 
@@ -202,6 +201,9 @@ static void rv_set_fcsr(rv_core_t *c, u4 value) {
 static result8_t rv_csr_fflags(rv_core_t *c, int op, u8 value) {
     result8_t result = {};
 
+    // pick up flags raised since the last access, so a write replaces them
+    sl_core_fp_flags_sync(&c->core);
+
     if (op == RV_CSR_OP_WRITE) {
         c->core.fexc = rv_host_fexc_from_fflags(value);
         return result;
@@ -267,6 +269,8 @@ static result8_t rv_csr_frm(rv_core_t *c, int op, u8 value) {
 static result8_t rv_csr_fcsr(rv_core_t *c, int op, u8 value) {
     result8_t result = {};
 
+    sl_core_fp_flags_sync(&c->core);
+
     if (op == RV_CSR_OP_WRITE) {
         rv_set_fcsr(c, value);
         return result;
@@ -6,6 +6,7 @@
 #include <inttypes.h>
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -21,8 +22,9 @@
 #include <sled/riscv/csr.h>
 #include <sled/slac.h>
 
-int riscv_core_decode(sl_core_t *c, sl_slac_inst_t *si);
+int riscv_core_decode(sl_core_t *c, sl_slac_inst_t *si, u4 op);
 int riscv_core_exception_enter(sl_core_t *core, u8 cause, u8 addr);
+int riscv_core_exception_return(sl_core_t *core, sl_slac_inst_t *si);
 static void riscv_core_shutdown(sl_core_t *c);
 static void riscv_core_destroy(sl_core_t *c);
 
@@ -74,9 +76,9 @@ static u8 riscv_core_get_reg(sl_core_t *c, u4 reg) {
 }
 
 static int riscv_core_csr(sl_core_t *c, sl_slac_inst_t *si) {
-    const u4 csr_addr = si->uimm;
+    const u4 csr_addr = si->imm;
     u8 value = 0;
-    if (si->func != SLAC_OP_CSRRD) {
+    if (si->func != SLAC_FUNC_CSRRD) {
         if (si->arg & SLAC_IN_ARG_I)
             value = si->r0;     // immediate ops keep the immediate value in r0
         else
@@ -92,12 +94,12 @@ static int riscv_core_csr(sl_core_t *c, sl_slac_inst_t *si) {
     case SLAC_FUNC_CSROR:   op = RV_CSR_OP_READ_SET;    break;
     case SLAC_FUNC_CSRCLR:  op = RV_CSR_OP_READ_CLEAR;  break;
     default:
-        return sl_core_synchronous_exception(c, EX_UNDEFINDED, si->desc.machine_op, 0);
+        return sl_core_synchronous_exception(c, EX_UNDEFINDED, sl_core_machine_op(c), 0);
     }
 
     result8_t result = rv_csr_op((rv_core_t *)c, op, csr_addr, value);
     if (result.err == SL_ERR_UNDEF)
-        return sl_core_synchronous_exception(c, EX_UNDEFINDED, si->desc.machine_op, 0);
+        return sl_core_synchronous_exception(c, EX_UNDEFINDED, sl_core_machine_op(c), 0);
     if (result.err == SL_ERR_UNIMPLEMENTED) {
         printf("unimplemented CSR access %#x\n", csr_addr);
         assert(false);
@@ -147,6 +149,7 @@ int sl_riscv_core_create(sl_core_params_t *p, sl_core_t **core_out) {
     rc->core.decode = riscv_core_decode;
     rc->core.dispatch = rv_dispatch;
     rc->core.exception_enter = riscv_core_exception_enter;
+    rc->core.exception_return = riscv_core_exception_return;
     rc->core.csr = riscv_core_csr;
     rc->core.set_reg = riscv_core_set_reg;
     rc->core.get_reg = riscv_core_get_reg;
@@ -158,6 +161,9 @@ int sl_riscv_core_create(sl_core_params_t *p, sl_core_t **core_out) {
     rc->core.engine.ops.interrupt = riscv_interrupt;
     rc->mimpid = 'sled';
     rc->ext.name_for_sysreg = rv_name_for_sysreg;
+    // status through the counters, extension state isn't included
+    rc->core.arch_state = &rc->status;
+    rc->core.arch_state_len = offsetof(rv_core_t, ext) - offsetof(rv_core_t, status);
     return 0;
 }
 
@@ -9,6 +9,7 @@
 #include <core/riscv/inst.h>
 #include <core/riscv/rv.h>
 #include <sled/error.h>
+#include <sled/slac.h>
 
 rv_sr_pl_t* rv_get_pl_csrs(rv_core_t *c, u1 pl) {
     assert(c->core.el != 0);
@@ -21,10 +22,16 @@ int riscv_core_exception_enter(sl_core_t *core, u8 cause, u8 addr) {
     // todo: check medeleg / mideleg for priv level dispatching
 
     u4 rv_fault = 0;
+    if (cause & RV_CAUSE64_INT) {
+        // interrupts arrive with their riscv cause number
+        rv_fault = (u4)(cause & ~RV_CAUSE64_INT);
+        goto enter;
+    }
     switch ((u4)cause) {
     case EX_SYSCALL:
         rv_fault = RV_EX_CALL_FROM_U + c->core.el;
         break;
+    case EX_BREAKPOINT:         rv_fault = RV_EX_BREAK;         break;
     case EX_UNDEFINDED:         rv_fault = RV_EX_INST_ILLEGAL;  break;
     case EX_ABORT_LOAD:         rv_fault = RV_EX_LOAD_FAULT;    break;
     case EX_ABORT_LOAD_ALIGN:   rv_fault = RV_EX_LOAD_ALIGN;    break;
@@ -36,12 +43,15 @@ int riscv_core_exception_enter(sl_core_t *core, u8 cause, u8 addr) {
         assert(false);
         return SL_ERR_UNIMPLEMENTED;
     }
+
+enter:
     cause = (cause & RV_CAUSE64_INT) | rv_fault;
 
     rv_sr_pl_t *r = rv_get_pl_csrs(c, SL_CORE_EL_MONITOR);
     r->cause = cause;
     r->epc = c->core.pc;
-    r->tval = addr;
+    // interrupts leave tval alone
+    if ((cause & RV_CAUSE64_INT) == 0) r->tval = addr;
 
     // update status register
     csr_status_t s;
@@ -97,3 +107,10 @@ int rv_exception_return(rv_core_t *c, u1 op) {
     sl_core_interrupt_set(&c->core, int_enabled);
     return 0;
 }
+
+int riscv_core_exception_return(sl_core_t *core, sl_slac_inst_t *si) {
+    int err = rv_exception_return((rv_core_t *)core, si->imm);
+    if (err == SL_ERR_UNDEF)
+        return sl_core_synchronous_exception(core, EX_UNDEFINDED, sl_core_machine_op(core), 0);
+    return err;
+}
@@ -1,26 +1,93 @@
 // SPDX-License-Identifier: MIT License
 // Copyright (c) 2024-2026 Shac Ron and The Sled Project
 
+#include <fenv.h>
 #include <math.h>
 
+#include <core/common.h>
 #include <core/core.h>
 #include <core/ex.h>
 #include <sled/error.h>
 #include <sled/slac.h>
 
+#include "slac_exec.h"
+
 #define F32_SIGN_BIT    (1u << 31)
 #define F64_SIGN_BIT    (1ul << 63)
+#define F32_QUIET_BIT   (1u << 22)
+#define F64_QUIET_BIT   (1ul << 51)
+
+// Host fp exception flags are left set by these ops, and merged into the core
+// flags later by sl_core_fp_flags_sync. Ops that must not raise flags can't
+// compare or convert nans on the host.
+
+// ops whose result depends on the rounding mode
+#define FP_ROUNDED  ((1u << SLAC_FUNC_FADD) | (1u << SLAC_FUNC_FSUB) | (1u << SLAC_FUNC_FMUL) | \
+                     (1u << SLAC_FUNC_FDIV) | (1u << SLAC_FUNC_FSQRT) | \
+                     (1u << SLAC_FUNC_FCVT_S4_TO_F) | (1u << SLAC_FUNC_FCVT_U4_TO_F) | \
+                     (1u << SLAC_FUNC_FCVT_S8_TO_F) | (1u << SLAC_FUNC_FCVT_U8_TO_F) | \
+                     (1u << SLAC_FUNC_FCVT_F_TO_S4) | (1u << SLAC_FUNC_FCVT_F_TO_U4) | \
+                     (1u << SLAC_FUNC_FCVT_F_TO_S8) | (1u << SLAC_FUNC_FCVT_F_TO_U8) | \
+                     (1u << SLAC_FUNC_FCVT_F32_TO_F64) | (1u << SLAC_FUNC_FCVT_F64_TO_F32) | \
+                     (1u << SLAC_FUNC_FMADD) | (1u << SLAC_FUNC_FMSUB) | \
+                     (1u << SLAC_FUNC_FNMADD) | (1u << SLAC_FUNC_FNMSUB))
+
+// Set the host up for the rounding mode of si. The host mode is left as is
+// between ops, so it usually matches already.
+static inline int fp_round(sl_core_t *c, sl_slac_inst_t *si) {
+    u1 rm = si->rm;
+    if (rm == SLAC_RM_DYN) rm = c->frm;
+    if (likely(rm == c->host_rm)) return 0;
+    if (rm > SLAC_RM_MAX_MAG) return SL_ERR_UNDEF;
+    sl_core_fp_set_round(c, rm);
+    return 0;
+}
+
+// Round v to an integer in the host mode fp_round set, raising no flags. Ties
+// to max magnitude has no host mode, so round is used for it.
+static inline double fp_round_int(sl_core_t *c, double v) {
+    return (c->host_rm == SLAC_RM_MAX_MAG) ? round(v) : nearbyint(v);
+}
+
+// Conversions to integers saturate out of range values and nans, which raise
+// invalid. Other results raise inexact if rounded.
+static u8 fp_to_sint(sl_core_t *c, double v, u1 bits) {
+    const double r = fp_round_int(c, v);
+    const double lim = ldexp(1.0, bits - 1);
+    if (isnan(r) || (r >= lim) || (r < -lim)) {
+        feraiseexcept(FE_INVALID);
+        if (!isnan(r) && (r < 0)) return ~0ull << (bits - 1);
+        return ~0ull >> (65 - bits);
+    }
+    if (r != v) feraiseexcept(FE_INEXACT);
+    return (u8)(i8)r;
+}
+
+static u8 fp_to_uint(sl_core_t *c, double v, u1 bits) {
+    const double r = fp_round_int(c, v);
+    if (isnan(r) || (r >= ldexp(1.0, bits)) || (r < 0)) {
+        feraiseexcept(FE_INVALID);
+        if (!isnan(r) && (r < 0)) return 0;
+        return ~0ull >> (64 - bits);
+    }
+    if (r != v) feraiseexcept(FE_INEXACT);
+    return (u8)r;
+}
 
-#define FP_SET_RESULT   (1 << 0)
-#define FP_SET_FLAGS    (1 << 1)
+// Integer results of 32 bits are sign extended in 64-bit mode.
+static inline void fp_set_reg(sl_core_t *c, u1 rd, u8 v, u1 bits) {
+    if (rd == SLAC_REG_DISCARD) return;
+    if (bits == 32) v = (c->mode == SL_CORE_MODE_4) ? (u4)v : (u8)(i8)(i4)v;
+    c->r[rd] = v;
+}
 
 int slac_exec_fp32(sl_core_t *c, sl_slac_inst_t *si) {
     sl_fp_reg_t result = {};
-    fexcept_t flags;
-    u1 set_opts = FP_SET_RESULT | FP_SET_FLAGS;
+    bool set_result = true;
     bool comp;
 
-    feclearexcept(FE_ALL_EXCEPT);
+    if (((FP_ROUNDED >> si->func) & 1) && fp_round(c, si))
+        goto undef;
 
     switch (si->func) {
     case SLAC_FUNC_FADD:
@@ -57,46 +124,43 @@ int slac_exec_fp32(sl_core_t *c, sl_slac_inst_t *si) {
         break;
 
     case SLAC_FUNC_FEQ:
-        set_opts = FP_SET_FLAGS;
+        set_result = false;
         comp = c->f[si->r0].f == c->f[si->r1].f;
         if (si->d0 != SLAC_REG_DISCARD)
             c->r[si->d0] = comp;
         break;
 
     case SLAC_FUNC_FLT:
-        set_opts = FP_SET_FLAGS;
+        set_result = false;
         comp = isless(c->f[si->r0].f, c->f[si->r1].f);
         if (si->d0 != SLAC_REG_DISCARD)
             c->r[si->d0] = comp;
         break;
 
     case SLAC_FUNC_FLE:
-        set_opts = FP_SET_FLAGS;
+        set_result = false;
         comp = islessequal(c->f[si->r0].f, c->f[si->r1].f);
         if (si->d0 != SLAC_REG_DISCARD)
             c->r[si->d0] = comp;
         break;
 
     case SLAC_FUNC_FS:
-        set_opts = FP_SET_RESULT;
         result.u4 = c->f[si->r0].u4 & ~F32_SIGN_BIT;
         result.u4 |= (c->f[si->r1].u4 & F32_SIGN_BIT);
         break;
 
     case SLAC_FUNC_FSN:
-        set_opts = FP_SET_RESULT;
         result.u4 = c->f[si->r0].u4 & ~F32_SIGN_BIT;
         result.u4 |= ((~c->f[si->r1].u4) & F32_SIGN_BIT);
         break;
 
     case SLAC_FUNC_FSX:
-        set_opts = FP_SET_RESULT;
         result.u4 = c->f[si->r0].u4 & ~F32_SIGN_BIT;
         result.u4 |= ((c->f[si->r0].u4 ^ c->f[si->r1].u4) & F32_SIGN_BIT);
         break;
 
     case SLAC_FUNC_FMOV_F_TO_R:
-        set_opts = 0;
+        set_result = false;
         if (c->mode == SL_CORE_MODE_4)
             c->r[si->d0] = c->f[si->r0].u4;
         else
@@ -104,7 +168,6 @@ int slac_exec_fp32(sl_core_t *c, sl_slac_inst_t *si) {
         break;
 
     case SLAC_FUNC_FMOV_R_TO_F:
-        set_opts = FP_SET_RESULT;
         result.u4 = (u4)c->r[si->r0];
         break;
 
@@ -128,50 +191,52 @@ int slac_exec_fp32(sl_core_t *c, sl_slac_inst_t *si) {
         break;
 
     case SLAC_FUNC_FCVT_F_TO_S4:
-        result.u4 = (i4)c->f[si->r0].f;
+        set_result = false;
+        fp_set_reg(c, si->d0, fp_to_sint(c, c->f[si->r0].f, 32), 32);
         break;
 
     case SLAC_FUNC_FCVT_F_TO_U4:
-        result.u4 = (u4)c->f[si->r0].f;
+        set_result = false;
+        fp_set_reg(c, si->d0, fp_to_uint(c, c->f[si->r0].f, 32), 32);
         break;
 
     case SLAC_FUNC_FCVT_F_TO_S8:
         if (c->mode != SL_CORE_MODE_8) goto undef;
-        result.u8 = (u8)(i8)c->f[si->r0].f;
+        set_result = false;
+        fp_set_reg(c, si->d0, fp_to_sint(c, c->f[si->r0].f, 64), 64);
         break;
 
     case SLAC_FUNC_FCVT_F_TO_U8:
         if (c->mode != SL_CORE_MODE_8) goto undef;
-        result.u8 = (u8)c->f[si->r0].f;
+        set_result = false;
+        fp_set_reg(c, si->d0, fp_to_uint(c, c->f[si->r0].f, 64), 64);
         break;
 
     case SLAC_FUNC_FLD: {
-        set_opts = 0;
-        u8 target = c->r[si->r0] + si->simm;
+        set_result = false;
+        u8 target = c->r[si->r0] + si->imm;
         if (c->mode == SL_CORE_MODE_4)
             target &= 0xffffffff;
-        u4 val;
-        int err = sl_core_mem_read_single(c, target, 4, &val);
-        if (err)
-            return sl_core_synchronous_exception(c, EX_ABORT_LOAD, target, err);
-        c->f[si->d0].u4 = val;
+        result4_t r = sl_core_mem_load4(c, target);
+        if (r.err)
+            return sl_core_synchronous_exception(c, EX_ABORT_LOAD, target, r.err);
+        c->f[si->d0].u4 = r.value;
         break;
     }
 
     case SLAC_FUNC_FST: {
-        set_opts = 0;
-        u8 target = c->r[si->r0] + si->simm;
+        set_result = false;
+        u8 target = c->r[si->r0] + si->imm;
         if (c->mode == SL_CORE_MODE_4)
             target &= 0xffffffff;
-        u4 val = c->f[si->d0].u4;
-        int err = sl_core_mem_write_single(c, target, 4, &val);
+        int err = sl_core_mem_store4(c, target, c->f[si->d0].u4);
         if (err)
             return sl_core_synchronous_exception(c, EX_ABORT_STORE, target, err);
         break;
     }
 
     case SLAC_FUNC_FCLASS: {
-        set_opts = 0;
+        set_result = false;
         u1 type = 0;
         int cl = fpclassify(c->f[si->r0].f);
         switch (cl) {
@@ -179,7 +244,7 @@ int slac_exec_fp32(sl_core_t *c, sl_slac_inst_t *si) {
         case FP_NORMAL:     type = 1;   break;
         case FP_SUBNORMAL:  type = 2;   break;
         case FP_ZERO:       type = 3;   break;
-        case FP_NAN:        type = (c->f[si->r0].f == NAN) ? 9 : 8;   break;
+        case FP_NAN:        type = (c->f[si->r0].u4 & F32_QUIET_BIT) ? 9 : 8;   break;
         }
         if ((type < 8) && (signbit(c->f[si->r0].f) == 0))
             type = 7 - type;
@@ -207,26 +272,22 @@ int slac_exec_fp32(sl_core_t *c, sl_slac_inst_t *si) {
         return SL_ERR_UNIMPLEMENTED;
     }
 
-    if (set_opts & FP_SET_FLAGS) {
-        fegetexceptflag(&flags, FE_ALL_EXCEPT);
-        c->fexc |= flags;
-    }
-    if (set_opts & FP_SET_RESULT) {
+    if (set_result) {
         c->f[si->d0].u8 = result.u8;
     }
     return 0;
 
 undef:
-    return SL_ERR_UNDEF;
+    return sl_core_synchronous_exception(c, EX_UNDEFINDED, sl_core_machine_op(c), 0);
 }
 
 int slac_exec_fp64(sl_core_t *c, sl_slac_inst_t *si) {
     sl_fp_reg_t result = {};
-    fexcept_t flags;
-    u1 set_opts = FP_SET_RESULT | FP_SET_FLAGS;
+    bool set_result = true;
     bool comp;
 
-    feclearexcept(FE_ALL_EXCEPT);
+    if (((FP_ROUNDED >> si->func) & 1) && fp_round(c, si))
+        goto undef;
 
     switch (si->func) {
     case SLAC_FUNC_FADD:
@@ -263,46 +324,43 @@ int slac_exec_fp64(sl_core_t *c, sl_slac_inst_t *si) {
         break;
 
     case SLAC_FUNC_FEQ:
-        set_opts = FP_SET_FLAGS;
+        set_result = false;
         comp = c->f[si->r0].d == c->f[si->r1].d;
         if (si->d0 != SLAC_REG_DISCARD)
             c->r[si->d0] = comp;
         break;
 
     case SLAC_FUNC_FLT:
-        set_opts = FP_SET_FLAGS;
+        set_result = false;
         comp = isless(c->f[si->r0].d, c->f[si->r1].d);
         if (si->d0 != SLAC_REG_DISCARD)
             c->r[si->d0] = comp;
         break;
 
     case SLAC_FUNC_FLE:
-        set_opts = FP_SET_FLAGS;
+        set_result = false;
         comp = islessequal(c->f[si->r0].d, c->f[si->r1].d);
         if (si->d0 != SLAC_REG_DISCARD)
             c->r[si->d0] = comp;
         break;
 
     case SLAC_FUNC_FS:
-        set_opts = FP_SET_RESULT;
         result.u8 = c->f[si->r0].u8 & ~F64_SIGN_BIT;
         result.u8 |= (c->f[si->r1].u8 & F64_SIGN_BIT);
         break;
 
     case SLAC_FUNC_FSN:
-        set_opts = FP_SET_RESULT;
         result.u8 = c->f[si->r0].u8 & ~F64_SIGN_BIT;
         result.u8 |= ((~c->f[si->r1].u8) & F64_SIGN_BIT);
         break;
 
     case SLAC_FUNC_FSX:
-        set_opts = FP_SET_RESULT;
         result.u8 = c->f[si->r0].u8 & ~F64_SIGN_BIT;
         result.u8 |= ((c->f[si->r0].u8 ^ c->f[si->r1].u8) & F64_SIGN_BIT);
         break;
 
     case SLAC_FUNC_FMOV_F_TO_R:
-        set_opts = 0;
+        set_result = false;
         if (c->mode == SL_CORE_MODE_4)
             c->r[si->d0] = c->f[si->r0].u4;
         else
@@ -310,7 +368,6 @@ int slac_exec_fp64(sl_core_t *c, sl_slac_inst_t *si) {
         break;
 
     case SLAC_FUNC_FMOV_R_TO_F:
-        set_opts = FP_SET_RESULT;
         result.u8 = c->r[si->r0];
         break;
 
@@ -334,25 +391,25 @@ int slac_exec_fp64(sl_core_t *c, sl_slac_inst_t *si) {
         break;
 
     case SLAC_FUNC_FCVT_F_TO_S4:
-        set_opts = FP_SET_FLAGS;
-        c->r[si->d0] = (i4)c->f[si->r0].d;
+        set_result = false;
+        fp_set_reg(c, si->d0, fp_to_sint(c, c->f[si->r0].d, 32), 32);
         break;
 
     case SLAC_FUNC_FCVT_F_TO_U4:
-        set_opts = FP_SET_FLAGS;
-        c->r[si->d0] = (u4)c->f[si->r0].d;
+        set_result = false;
+        fp_set_reg(c, si->d0, fp_to_uint(c, c->f[si->r0].d, 32), 32);
         break;
 
     case SLAC_FUNC_FCVT_F_TO_S8:
         if (c->mode != SL_CORE_MODE_8) goto undef;
-        set_opts = FP_SET_FLAGS;
-        c->r[si->d0] = (i8)c->f[si->r0].d;
+        set_result = false;
+        fp_set_reg(c, si->d0, fp_to_sint(c, c->f[si->r0].d, 64), 64);
         break;
 
     case SLAC_FUNC_FCVT_F_TO_U8:
         if (c->mode != SL_CORE_MODE_8) goto undef;
-        set_opts = FP_SET_FLAGS;
-        c->r[si->d0] = (u8)c->f[si->r0].d;
+        set_result = false;
+        fp_set_reg(c, si->d0, fp_to_uint(c, c->f[si->r0].d, 64), 64);
         break;
 
     case SLAC_FUNC_FCVT_F64_TO_F32:
@@ -366,32 +423,30 @@ int slac_exec_fp64(sl_core_t *c, sl_slac_inst_t *si) {
         break;
 
     case SLAC_FUNC_FLD: {
-        set_opts = 0;
-        u8 target = c->r[si->r0] + si->simm;
+        set_result = false;
+        u8 target = c->r[si->r0] + si->imm;
         if (c->mode == SL_CORE_MODE_4)
             target &= 0xffffffff;
-        u8 val;
-        int err = sl_core_mem_read_single(c, target, 8, &val);
-        if (err)
-            return sl_core_synchronous_exception(c, EX_ABORT_LOAD, target, err);
-        c->f[si->d0].u8 = val;
+        result8_t r = sl_core_mem_load8(c, target);
+        if (r.err)
+            return sl_core_synchronous_exception(c, EX_ABORT_LOAD, target, r.err);
+        c->f[si->d0].u8 = r.value;
         break;
     }
 
     case SLAC_FUNC_FST: {
-        set_opts = 0;
-        u8 target = c->r[si->r0] + si->simm;
+        set_result = false;
+        u8 target = c->r[si->r0] + si->imm;
         if (c->mode == SL_CORE_MODE_4)
             target &= 0xffffffff;
-        u8 val = c->f[si->d0].u8;
-        int err = sl_core_mem_write_single(c, target, 8, &val);
+        int err = sl_core_mem_store8(c, target, c->f[si->d0].u8);
         if (err)
             return sl_core_synchronous_exception(c, EX_ABORT_STORE, target, err);
         break;
     }
 
     case SLAC_FUNC_FCLASS: {
-        set_opts = 0;
+        set_result = false;
         u1 type = 0;
         int cl = fpclassify(c->f[si->r0].d);
         switch (cl) {
@@ -399,7 +454,7 @@ int slac_exec_fp64(sl_core_t *c, sl_slac_inst_t *si) {
         case FP_NORMAL:     type = 1;   break;
         case FP_SUBNORMAL:  type = 2;   break;
         case FP_ZERO:       type = 3;   break;
-        case FP_NAN:        type = (c->f[si->r0].d == NAN) ? 9 : 8;   break;
+        case FP_NAN:        type = (c->f[si->r0].u8 & F64_QUIET_BIT) ? 9 : 8;   break;
         }
         if ((type < 8) && (signbit(c->f[si->r0].d) == 0))
             type = 7 - type;
@@ -427,16 +482,30 @@ int slac_exec_fp64(sl_core_t *c, sl_slac_inst_t *si) {
         return SL_ERR_UNIMPLEMENTED;
     }
 
-    if (set_opts & FP_SET_FLAGS) {
-        fegetexceptflag(&flags, FE_ALL_EXCEPT);
-        c->fexc |= flags;
-    }
-    if (set_opts & FP_SET_RESULT) {
+    if (set_result) {
         c->f[si->d0].u8 = result.u8;
     }
     return 0;
 
 undef:
-    return SL_ERR_UNDEF;
+    return sl_core_synchronous_exception(c, EX_UNDEFINDED, sl_core_machine_op(c), 0);
 }
 
+
+#define SLAC_EXEC_DECL(name) \
+    int slac4_ ## name(sl_core_t *c, sl_slac_inst_t *si); \
+    int slac8_ ## name(sl_core_t *c, sl_slac_inst_t *si);
+SLAC_RLEN_HANDLERS(SLAC_EXEC_DECL)
+#undef SLAC_EXEC_DECL
+
+#define SLAC_EXEC4(name) slac4_ ## name,
+#define SLAC_EXEC8(name) slac8_ ## name,
+
+const sl_slac_exec_t slac_exec_table[SLAC_EXEC_NUM] = {
+    SLAC_RLEN_HANDLERS(SLAC_EXEC4)
+    SLAC_RLEN_HANDLERS(SLAC_EXEC8)
+    slac_exec_fp32,
+    slac_exec_fp64,
+};
+
+_Static_assert(SLAC_EXEC_NUM <= 256, "handler indices must fit in sl_slac_inst_t.exec");
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2026 Shac Ron and The Sled Project
+
+#pragma once
+
+// Handlers of decoded instructions are found by a one byte index into
+// slac_exec_table. Each register length built from slac_rlen.h has the handlers
+// listed here, in this order, followed by the fp handlers they share.
+
+#define SLAC_RLEN_HANDLERS(X) \
+    X(exec_invalid) X(dispatch) \
+    X(alu_add_dri) X(alu_sub_dri) X(alu_rsub_dri) X(alu_and_dri) X(alu_or_dri) \
+    X(alu_xor_dri) X(alu_not_dri) X(alu_shl_dri) X(alu_shrs_dri) X(alu_shr_dri) \
+    X(alu_csels_dri) X(alu_csel_dri) X(alu_zext_dri) \
+    X(alu_add_drr) X(alu_sub_drr) X(alu_rsub_drr) X(alu_and_drr) X(alu_or_drr) \
+    X(alu_xor_drr) X(alu_shl_drr) X(alu_shrs_drr) X(alu_shr_drr) X(alu_csels_drr) \
+    X(alu_csel_drr) X(alu_mul_drr) X(alu_mulhss_drr) X(alu_mulhsu_drr) \
+    X(alu_mulhuu_drr) X(alu_divs_drr) X(alu_div_drr) X(alu_mods_drr) X(alu_mod_drr) \
+    X(ld1) X(ld1s) X(ld2) X(ld2s) X(ld4) X(ld4s) X(ld8) \
+    X(ld1_pc) X(ld1s_pc) X(ld2_pc) X(ld2s_pc) X(ld4_pc) X(ld4s_pc) X(ld8_pc) \
+    X(st1) X(st2) X(st4) X(st8) \
+    X(atomic_lx) X(atomic_sx) X(atomic_rmw) \
+    X(sys_movr) X(sys_movi) X(sys_adr4k) X(sys_mbar) X(sys_ibar) X(sys_csr) \
+    X(sys_nop) X(sys_undef) X(sys_break) X(sys_syscall) X(sys_eret) X(sys_wfi) \
+    X(br_b) X(br_br) X(br_bl) X(br_blr) X(br_cbeq) X(br_cbne) X(br_cbltu) \
+    X(br_cblts) X(br_cbgeu) X(br_cbges)
+
+#define SLAC_EXEC_ENUM(name) SLAC_EXEC_ ## name,
+enum {
+    SLAC_RLEN_HANDLERS(SLAC_EXEC_ENUM)
+    SLAC_EXEC_RLEN_NUM
+};
+#undef SLAC_EXEC_ENUM
+
+#define SLAC_EXEC_RLEN4     0
+#define SLAC_EXEC_RLEN8     SLAC_EXEC_RLEN_NUM
+#define SLAC_EXEC_FP32      (2 * SLAC_EXEC_RLEN_NUM)
+#define SLAC_EXEC_FP64      (SLAC_EXEC_FP32 + 1)
+#define SLAC_EXEC_NUM       (SLAC_EXEC_FP64 + 1)
@@ -9,8 +9,11 @@
 #include <core/ex.h>
 #include <core/sym.h>
 #include <sled/error.h>
+#include <sled/io.h>
 #include <sled/slac.h>
 
+#include "slac_exec.h"
+
 #if SLAC_RLEN == 1
     u1 typedef urlen_t;
     i1 typedef srlen_t;
@@ -34,6 +37,7 @@
     i8 typedef sr2len_t;
     result4_t typedef resultrlen_t;
     #define RLEN_PREFIX(name) slac4_ ## name
+    #define RLEN_EXEC(name) (SLAC_EXEC_RLEN4 + SLAC_EXEC_ ## name)
     #define PRIRLENx PRIx32
 #else // SLAC_RLEN == 8
     u8 typedef urlen_t;
@@ -42,6 +46,7 @@
     __int128_t  typedef sr2len_t;
     result8_t  typedef resultrlen_t;
     #define RLEN_PREFIX(name) slac8_ ## name
+    #define RLEN_EXEC(name) (SLAC_EXEC_RLEN8 + SLAC_EXEC_ ## name)
     #define PRIRLENx PRIx64
 #endif
 
@@ -53,7 +58,7 @@
 opcode execution:
 predicate
 load arguments
-call dispatch function based on type (jump table)
+call handler bound at decode time
 write back
 */
 
@@ -71,249 +76,386 @@ static inline u8 sign_extend8(srlen_t x) { return (u8)(i8)x; }
 __attribute__((no_sanitize("signed-integer-overflow")))
 static inline sr2len_t mul_ssl(srlen_t a, srlen_t b) { return (sr2len_t)a * b; }
 
-static int RLEN_PREFIX(exec_alu_dri)(sl_core_t *c, sl_slac_inst_t *si) {
-    urlen_t result;
-    const urlen_t val = c->r[si->r0];
-    const urlen_t uimm = si->uimm;
-    switch(si->func) {
-    case SLAC_FUNC_ADD:    result = val + uimm;    break;
-    case SLAC_FUNC_SUB:    result = val - uimm;    break;
-    case SLAC_FUNC_RSUB:   result = uimm - val;    break;
-    case SLAC_FUNC_AND:    result = val & uimm;    break;
-    case SLAC_FUNC_OR:     result = val | uimm;    break;
-    case SLAC_FUNC_XOR:    result = val ^ uimm;    break;
-    case SLAC_FUNC_NOT:    result = ~uimm;         break;
-    case SLAC_FUNC_SHL:    result = val << uimm;   break;
-    case SLAC_FUNC_SHRS:   result = ((srlen_t)val) >> uimm;    break;
-    case SLAC_FUNC_SHR:    result = val >> uimm;   break;
-    case SLAC_FUNC_CSELS:  result = ((srlen_t)val < (srlen_t)uimm) ? 1 : 0; break;
-    case SLAC_FUNC_CSEL:   result = (val < uimm) ? 1 : 0;      break;
-    default:
-        return SL_ERR_SLAC_INVALID;
-    }
+// Instructions are bound to a handler when they are decoded. Each handler
+// executes exactly one type/func/operand form, so dispatch is a single
+// indirect call through slac_exec_table[si->exec].
+
+#define SLAC_EXEC_DECL(name) int RLEN_PREFIX(name)(sl_core_t *c, sl_slac_inst_t *si);
+SLAC_RLEN_HANDLERS(SLAC_EXEC_DECL)
+#undef SLAC_EXEC_DECL
+
+#define SLAC_SHAMT(x) ((x) & (SLAC_RLEN_BITS - 1))
+
+// alu, register and immediate
+#define SLAC_ALU_DRI(name, expr) \
+int RLEN_PREFIX(alu_ ## name ## _dri)(sl_core_t *c, sl_slac_inst_t *si) { \
+    const urlen_t val = c->r[si->r0]; \
+    const urlen_t uimm = si->imm; \
+    (void)val; \
+    const urlen_t result = (expr); \
+    c->r[si->d0] = SX8_EXTEND(result); \
+    return 0; \
+}
 
-    c->r[si->d0] = SX8_EXTEND(result);
-    return 0;
+// alu, two registers
+#define SLAC_ALU_DRR(name, expr) \
+int RLEN_PREFIX(alu_ ## name ## _drr)(sl_core_t *c, sl_slac_inst_t *si) { \
+    const urlen_t r0 = c->r[si->r0]; \
+    const urlen_t r1 = c->r[si->r1]; \
+    const urlen_t result = (expr); \
+    c->r[si->d0] = SX8_EXTEND(result); \
+    return 0; \
 }
 
-static int RLEN_PREFIX(exec_alu_drr)(sl_core_t *c, sl_slac_inst_t *si) {
-    urlen_t result;
-    const urlen_t r0 = c->r[si->r0];
-    const urlen_t r1 = c->r[si->r1];
-    const u1 shift = r1 & (SLAC_RLEN_BITS - 1);
-    switch(si->func) {
-    case SLAC_FUNC_ADD:    result = r0 + r1;       break;
-    case SLAC_FUNC_SUB:    result = r0 - r1;       break;
-    case SLAC_FUNC_RSUB:   result = r1 - r0;       break;
-    case SLAC_FUNC_AND:    result = r0 & r1;       break;
-    case SLAC_FUNC_OR:     result = r0 | r1;       break;
-    case SLAC_FUNC_XOR:    result = r0 ^ r1;       break;
-    case SLAC_FUNC_SHL:    result = r0 << shift;   break;
-    case SLAC_FUNC_SHRS:   result = ((srlen_t)r0) >> shift;                break;
-    case SLAC_FUNC_SHR:    result = r0 >> shift;                           break;
-    case SLAC_FUNC_CSELS:  result = ((srlen_t)r0 < (srlen_t)r1) ? 1 : 0;   break;
-    case SLAC_FUNC_CSEL:   result = (r0 < r1) ? 1 : 0;                     break;
-    case SLAC_FUNC_MUL:    result = r0 * r1;                               break;
-    case SLAC_FUNC_MULHSS: result = mul_ssl(r0, r1) >> SLAC_RLEN_BITS;     break;
-    case SLAC_FUNC_MULHSU: result = ((sr2len_t)r0 * r1) >> SLAC_RLEN_BITS; break;
-    case SLAC_FUNC_MULHUU: result = (urlen_t)(((ur2len_t)r0 * r1) >> SLAC_RLEN_BITS);  break;
-    case SLAC_FUNC_DIVS:
-        if (r1 == 0) result = ~((urlen_t)0);
-        else         result = (srlen_t)r0 / (srlen_t)r1;
-        break;
-    case SLAC_FUNC_DIV:
-        if (r1 == 0) result = ~((urlen_t)0);
-        else         result = r0 / r1;
-        break;
-    case SLAC_FUNC_MODS:
-        if (r1 == 0) result = r0;
-        else         result = (srlen_t)r0 % (srlen_t)r1;
-        break;
-    case SLAC_FUNC_MOD:
-        if (r1 == 0) result = r0;
-        else         result = r0 % r1;
-        break;
-
-    default:
-        return SL_ERR_SLAC_INVALID;
+SLAC_ALU_DRI(add,   val + uimm)
+SLAC_ALU_DRI(sub,   val - uimm)
+SLAC_ALU_DRI(rsub,  uimm - val)
+SLAC_ALU_DRI(and,   val & uimm)
+SLAC_ALU_DRI(or,    val | uimm)
+SLAC_ALU_DRI(xor,   val ^ uimm)
+SLAC_ALU_DRI(not,   ~uimm)
+SLAC_ALU_DRI(shl,   val << uimm)
+SLAC_ALU_DRI(shrs,  ((srlen_t)val) >> uimm)
+SLAC_ALU_DRI(shr,   val >> uimm)
+SLAC_ALU_DRI(csels, ((srlen_t)val < (srlen_t)uimm) ? 1 : 0)
+SLAC_ALU_DRI(csel,  (val < uimm) ? 1 : 0)
+SLAC_ALU_DRI(zext,  (urlen_t)(val << uimm) >> uimm)
+
+SLAC_ALU_DRR(add,    r0 + r1)
+SLAC_ALU_DRR(sub,    r0 - r1)
+SLAC_ALU_DRR(rsub,   r1 - r0)
+SLAC_ALU_DRR(and,    r0 & r1)
+SLAC_ALU_DRR(or,     r0 | r1)
+SLAC_ALU_DRR(xor,    r0 ^ r1)
+SLAC_ALU_DRR(shl,    r0 << SLAC_SHAMT(r1))
+SLAC_ALU_DRR(shrs,   ((srlen_t)r0) >> SLAC_SHAMT(r1))
+SLAC_ALU_DRR(shr,    r0 >> SLAC_SHAMT(r1))
+SLAC_ALU_DRR(csels,  ((srlen_t)r0 < (srlen_t)r1) ? 1 : 0)
+SLAC_ALU_DRR(csel,   (r0 < r1) ? 1 : 0)
+SLAC_ALU_DRR(mul,    r0 * r1)
+SLAC_ALU_DRR(mulhss, mul_ssl(r0, r1) >> SLAC_RLEN_BITS)
+SLAC_ALU_DRR(mulhsu, ((sr2len_t)(srlen_t)r0 * r1) >> SLAC_RLEN_BITS)
+SLAC_ALU_DRR(mulhuu, (urlen_t)(((ur2len_t)r0 * r1) >> SLAC_RLEN_BITS))
+SLAC_ALU_DRR(divs,   (r1 == 0) ? ~((urlen_t)0) : (urlen_t)((srlen_t)r0 / (srlen_t)r1))
+SLAC_ALU_DRR(div,    (r1 == 0) ? ~((urlen_t)0) : r0 / r1)
+SLAC_ALU_DRR(mods,   (r1 == 0) ? r0 : (urlen_t)((srlen_t)r0 % (srlen_t)r1))
+SLAC_ALU_DRR(mod,    (r1 == 0) ? r0 : r0 % r1)
+
+static u1 RLEN_PREFIX(bind_alu)(sl_slac_inst_t *si) {
+    if (si->arg == SLAC_IN_ARG_DRI) {
+        switch (si->func) {
+        case SLAC_FUNC_ADD:    return RLEN_EXEC(alu_add_dri);
+        case SLAC_FUNC_SUB:    return RLEN_EXEC(alu_sub_dri);
+        case SLAC_FUNC_RSUB:   return RLEN_EXEC(alu_rsub_dri);
+        case SLAC_FUNC_AND:    return RLEN_EXEC(alu_and_dri);
+        case SLAC_FUNC_OR:     return RLEN_EXEC(alu_or_dri);
+        case SLAC_FUNC_XOR:    return RLEN_EXEC(alu_xor_dri);
+        case SLAC_FUNC_NOT:    return RLEN_EXEC(alu_not_dri);
+        case SLAC_FUNC_SHL:    return RLEN_EXEC(alu_shl_dri);
+        case SLAC_FUNC_SHRS:   return RLEN_EXEC(alu_shrs_dri);
+        case SLAC_FUNC_SHR:    return RLEN_EXEC(alu_shr_dri);
+        case SLAC_FUNC_CSELS:  return RLEN_EXEC(alu_csels_dri);
+        case SLAC_FUNC_CSEL:   return RLEN_EXEC(alu_csel_dri);
+        case SLAC_FUNC_ZEXT:   return RLEN_EXEC(alu_zext_dri);
+        default:               return RLEN_EXEC(exec_invalid);
+        }
     }
-    c->r[si->d0] = SX8_EXTEND(result);
-    return 0;
+    if (si->arg == SLAC_IN_ARG_DRR) {
+        switch (si->func) {
+        case SLAC_FUNC_ADD:    return RLEN_EXEC(alu_add_drr);
+        case SLAC_FUNC_SUB:    return RLEN_EXEC(alu_sub_drr);
+        case SLAC_FUNC_RSUB:   return RLEN_EXEC(alu_rsub_drr);
+        case SLAC_FUNC_AND:    return RLEN_EXEC(alu_and_drr);
+        case SLAC_FUNC_OR:     return RLEN_EXEC(alu_or_drr);
+        case SLAC_FUNC_XOR:    return RLEN_EXEC(alu_xor_drr);
+        case SLAC_FUNC_SHL:    return RLEN_EXEC(alu_shl_drr);
+        case SLAC_FUNC_SHRS:   return RLEN_EXEC(alu_shrs_drr);
+        case SLAC_FUNC_SHR:    return RLEN_EXEC(alu_shr_drr);
+        case SLAC_FUNC_CSELS:  return RLEN_EXEC(alu_csels_drr);
+        case SLAC_FUNC_CSEL:   return RLEN_EXEC(alu_csel_drr);
+        case SLAC_FUNC_MUL:    return RLEN_EXEC(alu_mul_drr);
+        case SLAC_FUNC_MULHSS: return RLEN_EXEC(alu_mulhss_drr);
+        case SLAC_FUNC_MULHSU: return RLEN_EXEC(alu_mulhsu_drr);
+        case SLAC_FUNC_MULHUU: return RLEN_EXEC(alu_mulhuu_drr);
+        case SLAC_FUNC_DIVS:   return RLEN_EXEC(alu_divs_drr);
+        case SLAC_FUNC_DIV:    return RLEN_EXEC(alu_div_drr);
+        case SLAC_FUNC_MODS:   return RLEN_EXEC(alu_mods_drr);
+        case SLAC_FUNC_MOD:    return RLEN_EXEC(alu_mod_drr);
+        default:               return RLEN_EXEC(exec_invalid);
+        }
+    }
+    return RLEN_EXEC(exec_invalid);
 }
 
-static int RLEN_PREFIX(exec_alu)(sl_core_t *c, sl_slac_inst_t *si) {
-    switch (si->arg) {
-    case SLAC_IN_ARG_DRI:   return RLEN_PREFIX(exec_alu_dri)(c, si);
-    case SLAC_IN_ARG_DRR:   return RLEN_PREFIX(exec_alu_drr)(c, si);
-    default:                return SL_ERR_SLAC_INVALID;
+// load, expr is the loaded data in v
+#define SLAC_LOAD(name, size, expr) \
+int RLEN_PREFIX(name)(sl_core_t *c, sl_slac_inst_t *si) { \
+    const urlen_t target = c->r[si->r0] + si->imm; \
+    const result ## size ## _t r = sl_core_mem_load ## size(c, target); \
+    if (r.err) return sl_core_synchronous_exception(c, EX_ABORT_LOAD, target, r.err); \
+    const u ## size v = r.value; \
+    if (si->d0 != SLAC_REG_DISCARD) \
+        c->r[si->d0] = (expr); \
+    return 0; \
+}
+
+SLAC_LOAD(ld1,  1, v)
+SLAC_LOAD(ld1s, 1, (urlen_t)(i1)v)
+SLAC_LOAD(ld2,  2, v)
+SLAC_LOAD(ld2s, 2, (urlen_t)(i2)v)
+SLAC_LOAD(ld4,  4, v)
+SLAC_LOAD(ld4s, 4, (urlen_t)(i4)v)
+SLAC_LOAD(ld8,  8, v)
+
+// pc relative load, fused from an address generating instruction and a load.
+// A fault is left to the unfused pair so the exception sees the address
+// register written.
+#define SLAC_LOAD_PC(name, size, expr) \
+int RLEN_PREFIX(name)(sl_core_t *c, sl_slac_inst_t *si) { \
+    const urlen_t target = c->pc + si->imm; \
+    const result ## size ## _t r = sl_core_mem_load ## size(c, target); \
+    if (r.err) return SL_ERR_SLAC_SPLIT; \
+    const u ## size v = r.value; \
+    c->r[si->d0] = (expr); \
+    return 0; \
+}
+
+SLAC_LOAD_PC(ld1_pc,  1, v)
+SLAC_LOAD_PC(ld1s_pc, 1, (urlen_t)(i1)v)
+SLAC_LOAD_PC(ld2_pc,  2, v)
+SLAC_LOAD_PC(ld2s_pc, 2, (urlen_t)(i2)v)
+SLAC_LOAD_PC(ld4_pc,  4, v)
+SLAC_LOAD_PC(ld4s_pc, 4, (urlen_t)(i4)v)
+SLAC_LOAD_PC(ld8_pc,  8, v)
+
+static u1 RLEN_PREFIX(bind_load)(sl_slac_inst_t *si) {
+    const bool pc = (si->r0 == SLAC_REG_PC);
+    switch (si->func) {
+    case SLAC_FUNC_LD1:    return pc ? RLEN_EXEC(ld1_pc) : RLEN_EXEC(ld1);
+    case SLAC_FUNC_LD1S:   return pc ? RLEN_EXEC(ld1s_pc) : RLEN_EXEC(ld1s);
+    case SLAC_FUNC_LD2:    return pc ? RLEN_EXEC(ld2_pc) : RLEN_EXEC(ld2);
+    case SLAC_FUNC_LD2S:   return pc ? RLEN_EXEC(ld2s_pc) : RLEN_EXEC(ld2s);
+    case SLAC_FUNC_LD4:    return pc ? RLEN_EXEC(ld4_pc) : RLEN_EXEC(ld4);
+    case SLAC_FUNC_LD4S:   return pc ? RLEN_EXEC(ld4s_pc) : RLEN_EXEC(ld4s);
+    case SLAC_FUNC_LD8:    return pc ? RLEN_EXEC(ld8_pc) : RLEN_EXEC(ld8);
+    default:               return RLEN_EXEC(exec_invalid);
     }
 }
 
-static int RLEN_PREFIX(exec_load)(sl_core_t *c, sl_slac_inst_t *si) {
-    int err;
-    u8 x;
-    u4 w;
-    u2 h;
-    u1 b;
+#define SLAC_STORE(name, size) \
+int RLEN_PREFIX(name)(sl_core_t *c, sl_slac_inst_t *si) { \
+    const urlen_t dest = c->r[si->r0] + si->imm; \
+    int err = sl_core_mem_store ## size(c, dest, (u ## size)c->r[si->d0]); \
+    if (err) return sl_core_synchronous_exception(c, EX_ABORT_STORE, dest, err); \
+    return 0; \
+}
 
-    urlen_t target = c->r[si->r0] + si->simm;
+SLAC_STORE(st1, 1)
+SLAC_STORE(st2, 2)
+SLAC_STORE(st4, 4)
+SLAC_STORE(st8, 8)
 
+static u1 RLEN_PREFIX(bind_store)(sl_slac_inst_t *si) {
     switch (si->func) {
-    case SLAC_FUNC_LD1:
-        err = sl_core_mem_read_single(c, target, 1, &b);
-        x = b;
-        break;
-
-    case SLAC_FUNC_LD1S:
-        err = sl_core_mem_read_single(c, target, 1, &b);
-        x = (urlen_t)(i1)b;
-        break;
-
-    case SLAC_FUNC_LD2:
-        err = sl_core_mem_read_single(c, target, 2, &h);
-        x = h;
-        break;
-
-    case SLAC_FUNC_LD2S:
-        err = sl_core_mem_read_single(c, target, 2, &h);
-        x = (urlen_t)(i2)h;
-        break;
-
-    case SLAC_FUNC_LD4:
-        err = sl_core_mem_read_single(c, target, 4, &w);
-        x = w;
-        break;
-
-    case SLAC_FUNC_LD4S:
-        err = sl_core_mem_read_single(c, target, 4, &w);
-        x = (urlen_t)(i4)w;
-        break;
-
-    case SLAC_FUNC_LD8:
-        err = sl_core_mem_read_single(c, target, 8, &x);
-        break;
-
-    default:
-        return SL_ERR_SLAC_INVALID;
+    case SLAC_FUNC_ST1:    return RLEN_EXEC(st1);
+    case SLAC_FUNC_ST2:    return RLEN_EXEC(st2);
+    case SLAC_FUNC_ST4:    return RLEN_EXEC(st4);
+    case SLAC_FUNC_ST8:    return RLEN_EXEC(st8);
+    default:               return RLEN_EXEC(exec_invalid);
     }
+}
+
+static inline memory_order slac_barrier_order(u8 bar) {
+    switch (bar & (BARRIER_LOAD | BARRIER_STORE)) {
+    case BARRIER_LOAD:                  return memory_order_acquire;
+    case BARRIER_STORE:                 return memory_order_release;
+    case BARRIER_LOAD | BARRIER_STORE:  return memory_order_acq_rel;
+    default:                            return memory_order_relaxed;
+    }
+}
+
+// atomic results narrower than the register are sign extended
+static inline urlen_t RLEN_PREFIX(atomic_result)(u8 v, u1 len) {
+    if (len == SLAC_IN_LEN_4) return (srlen_t)(i4)v;
+    return v;
+}
+
+int RLEN_PREFIX(atomic_lx)(sl_core_t *c, sl_slac_inst_t *si) {
+    const urlen_t addr = c->r[si->r0];
+    const u1 size = 1u << si->r2;
+    if (addr & (size - 1)) return sl_core_synchronous_exception(c, EX_ABORT_LOAD, addr, SL_ERR_IO_ALIGN);
+
+    if (si->imm & BARRIER_STORE) atomic_thread_fence(memory_order_release);
+
+    c->monitor_addr = addr;
+    c->monitor_status = MONITOR_UNARMED;
+    result8_t r;
+    if (size == 4) {
+        const result4_t r4 = sl_core_mem_load4(c, addr);
+        r = (result8_t){ .value = r4.value, .err = r4.err };
+    } else {
+        r = sl_core_mem_load8(c, addr);
+    }
+    if (r.err) return sl_core_synchronous_exception(c, EX_ABORT_LOAD, addr, r.err);
+    const u8 val = r.value;
+
+    if (si->imm & BARRIER_LOAD) atomic_thread_fence(memory_order_acquire);
 
-    if (err) return sl_core_synchronous_exception(c, EX_ABORT_LOAD, target, err);
+    c->monitor_value = val;
+    c->monitor_status = si->r2;
     if (si->d0 != SLAC_REG_DISCARD)
-        c->r[si->d0] = x;
+        c->r[si->d0] = RLEN_PREFIX(atomic_result)(val, si->r2);
     return 0;
 }
 
-static int RLEN_PREFIX(exec_store)(sl_core_t *c, sl_slac_inst_t *si) {
-    urlen_t val = c->r[si->d0];
-    const urlen_t dest = c->r[si->r0] + si->simm;
-    u4 w;
-    u2 h;
-    u1 b;
-    int err = 0;
-
-    switch (si->func) {
-    case SLAC_FUNC_ST1:
-        b = (u1)val;
-        err = sl_core_mem_write_single(c, dest, 1, &b);
-        break;
-
-    case SLAC_FUNC_ST2:
-        h = (u2)val;
-        err = sl_core_mem_write_single(c, dest, 2, &h);
-        break;
-
-    case SLAC_FUNC_ST4:
-        w = (u4)val;
-        err = sl_core_mem_write_single(c, dest, 4, &w);
-        break;
-
-    case SLAC_FUNC_ST8:
-        err = sl_core_mem_write_single(c, dest, 8, &val);
-        break;
+// store exclusive writes 0 to d0 on success, 1 on failure
+int RLEN_PREFIX(atomic_sx)(sl_core_t *c, sl_slac_inst_t *si) {
+    const urlen_t addr = c->r[si->r0];
+    const u1 size = 1u << si->r2;
+    if (addr & (size - 1)) return sl_core_synchronous_exception(c, EX_ABORT_STORE, addr, SL_ERR_IO_ALIGN);
+
+    u8 result = 1;
+    if ((c->monitor_status == si->r2) && (c->monitor_addr == addr)) {
+        const memory_order ord = slac_barrier_order(si->imm);
+        const memory_order ord_fail = (si->imm & BARRIER_LOAD) ? memory_order_acquire : memory_order_relaxed;
+        int err = sl_core_mem_atomic(c, addr, size, IO_OP_ATOMIC_CAS, c->r[si->r1], c->monitor_value, &result, ord, ord_fail);
+        if (err) {
+            c->monitor_status = MONITOR_UNARMED;
+            return sl_core_synchronous_exception(c, EX_ABORT_STORE, addr, err);
+        }
     }
-    if (err)
-        return sl_core_synchronous_exception(c, EX_ABORT_STORE, dest, err);
+    c->monitor_status = MONITOR_UNARMED;
+    if (si->d0 != SLAC_REG_DISCARD)
+        c->r[si->d0] = result;
     return 0;
 }
 
-static int RLEN_PREFIX(exec_atomic)(sl_core_t *c, sl_slac_inst_t *si) {
-    int err = 0;
+// read-modify-write, d0 gets the previous memory value
+int RLEN_PREFIX(atomic_rmw)(sl_core_t *c, sl_slac_inst_t *si) {
     const urlen_t addr = c->r[si->r0];
-    urlen_t val;
+    const u1 size = 1u << si->r2;
+    if (addr & (size - 1)) return sl_core_synchronous_exception(c, EX_ABORT_STORE, addr, SL_ERR_IO_ALIGN);
 
+    u1 aop;
     switch (si->func) {
-    case SLAC_FUNC_LX: {
-        if (addr & (SLAC_RLEN - 1)) return sl_core_synchronous_exception(c, EX_ABORT_LOAD, addr, SL_ERR_IO_ALIGN);
+    case SLAC_FUNC_SWP:     aop = IO_OP_ATOMIC_SWAP;    break;
+    case SLAC_FUNC_ATADD:   aop = IO_OP_ATOMIC_ADD;     break;
+    case SLAC_FUNC_ATAND:   aop = IO_OP_ATOMIC_AND;     break;
+    case SLAC_FUNC_ATOR:    aop = IO_OP_ATOMIC_OR;      break;
+    case SLAC_FUNC_ATXOR:   aop = IO_OP_ATOMIC_XOR;     break;
+    case SLAC_FUNC_ATMINU:  aop = IO_OP_ATOMIC_UMIN;    break;
+    case SLAC_FUNC_ATMINS:  aop = IO_OP_ATOMIC_SMIN;    break;
+    case SLAC_FUNC_ATMAXU:  aop = IO_OP_ATOMIC_UMAX;    break;
+    case SLAC_FUNC_ATMAXS:  aop = IO_OP_ATOMIC_SMAX;    break;
+    default:                return SL_ERR_SLAC_INVALID;
+    }
 
-        if (si->uimm & BARRIER_STORE) atomic_thread_fence(memory_order_release);
+    u8 result;
+    c->monitor_status = MONITOR_UNARMED;
+    int err = sl_core_mem_atomic(c, addr, size, aop, c->r[si->r1], 0, &result, slac_barrier_order(si->imm), memory_order_relaxed);
+    if (err) return sl_core_synchronous_exception(c, EX_ABORT_STORE, addr, err);
+    if (si->d0 != SLAC_REG_DISCARD)
+        c->r[si->d0] = RLEN_PREFIX(atomic_result)(result, si->r2);
+    return 0;
+}
+
+static u1 RLEN_PREFIX(bind_atomic)(sl_slac_inst_t *si) {
+    switch (si->func) {
+    case SLAC_FUNC_LX:      return RLEN_EXEC(atomic_lx);
+    case SLAC_FUNC_SX:      return RLEN_EXEC(atomic_sx);
+    case SLAC_FUNC_SWP:
+    case SLAC_FUNC_ATADD:
+    case SLAC_FUNC_ATAND:
+    case SLAC_FUNC_ATOR:
+    case SLAC_FUNC_ATXOR:
+    case SLAC_FUNC_ATMINU:
+    case SLAC_FUNC_ATMINS:
+    case SLAC_FUNC_ATMAXU:
+    case SLAC_FUNC_ATMAXS:  return RLEN_EXEC(atomic_rmw);
+    default:                return RLEN_EXEC(exec_invalid);
+    }
+}
 
-        c->monitor_addr = addr;
-        c->monitor_status = MONITOR_UNARMED;
-        if ((err = sl_core_mem_read_single(c, addr, SLAC_RLEN, &val))) break;
+int RLEN_PREFIX(sys_movr)(sl_core_t *c, sl_slac_inst_t *si) {
+    c->r[si->d0] = c->r[si->r0];
+    return 0;
+}
 
-        if (si->uimm & BARRIER_LOAD) atomic_thread_fence(memory_order_acquire);
+int RLEN_PREFIX(sys_movi)(sl_core_t *c, sl_slac_inst_t *si) {
+    c->r[si->d0] = SX8_EXTEND((urlen_t)si->imm);
+    return 0;
+}
 
-        c->monitor_value = val;
-        c->monitor_status = si->len;
-        if (si->d0 != SLAC_REG_DISCARD)
-            c->r[si->d0] = val;
-        return 0;
-    }
+int RLEN_PREFIX(sys_adr4k)(sl_core_t *c, sl_slac_inst_t *si) {
+    c->r[si->d0] = (urlen_t)(c->pc + si->imm);
+    return 0;
+}
 
-    default:    return SL_ERR_SLAC_UNDECODED;
-    }
+int RLEN_PREFIX(sys_mbar)(sl_core_t *c, sl_slac_inst_t *si) {
+    sl_core_memory_barrier(c, si->imm);
+    return 0;
+}
 
-    if (err) return sl_core_synchronous_exception(c, EX_ABORT_LOAD, addr, err);
+int RLEN_PREFIX(sys_ibar)(sl_core_t *c, sl_slac_inst_t *si) {
+    sl_core_instruction_barrier(c);
     return 0;
 }
 
-static int RLEN_PREFIX(exec_sys)(sl_core_t *c, sl_slac_inst_t *si) {
-    switch (si->func) {
-    case SLAC_FUNC_MOVR:
-        c->r[si->d0] = c->r[si->r0];
-        break;
+int RLEN_PREFIX(sys_csr)(sl_core_t *c, sl_slac_inst_t *si) {
+    return c->csr(c, si);
+}
 
-    case SLAC_FUNC_MOVI:
-        c->r[si->d0] = si->uimm;
-        break;
+int RLEN_PREFIX(sys_nop)(sl_core_t *c, sl_slac_inst_t *si) {
+    return 0;
+}
 
-    case SLAC_FUNC_ADR4K:
-        c->r[si->d0] = (urlen_t)(c->pc + si->simm);
-        break;
+int RLEN_PREFIX(sys_undef)(sl_core_t *c, sl_slac_inst_t *si) {
+    return sl_core_synchronous_exception(c, EX_UNDEFINDED, sl_core_machine_op(c), 0);
+}
 
-    case SLAC_FUNC_MBAR:
-        sl_core_memory_barrier(c, si->uimm);
-        break;
+int RLEN_PREFIX(sys_break)(sl_core_t *c, sl_slac_inst_t *si) {
+    return sl_core_synchronous_exception(c, EX_BREAKPOINT, c->pc, 0);
+}
 
-    case SLAC_FUNC_IBAR:
-        sl_core_instruction_barrier(c);
-        break;
+int RLEN_PREFIX(sys_syscall)(sl_core_t *c, sl_slac_inst_t *si) {
+    return sl_core_synchronous_exception(c, EX_SYSCALL, sl_core_machine_op(c), 0);
+}
+
+int RLEN_PREFIX(sys_eret)(sl_core_t *c, sl_slac_inst_t *si) {
+    if (c->el < si->imm) return RLEN_PREFIX(sys_undef)(c, si);
+    return c->exception_return(c, si);
+}
+
+int RLEN_PREFIX(sys_wfi)(sl_core_t *c, sl_slac_inst_t *si) {
+    if (c->el < si->imm) return RLEN_PREFIX(sys_undef)(c, si);
+    return sl_engine_wait_for_interrupt(&c->engine);
+}
+
+static u1 RLEN_PREFIX(bind_sys)(sl_slac_inst_t *si) {
+    switch (si->func) {
+    case SLAC_FUNC_MOVR:   return RLEN_EXEC(sys_movr);
+    case SLAC_FUNC_MOVI:   return RLEN_EXEC(sys_movi);
+    case SLAC_FUNC_ADR4K:  return RLEN_EXEC(sys_adr4k);
+    case SLAC_FUNC_MBAR:   return RLEN_EXEC(sys_mbar);
+    case SLAC_FUNC_IBAR:   return RLEN_EXEC(sys_ibar);
+    case SLAC_FUNC_BREAK:  return RLEN_EXEC(sys_break);
+    case SLAC_FUNC_SYSCALL: return RLEN_EXEC(sys_syscall);
+    case SLAC_FUNC_ERET:   return RLEN_EXEC(sys_eret);
+    case SLAC_FUNC_WFI:    return RLEN_EXEC(sys_wfi);
 
     case SLAC_FUNC_CSRRD:
     case SLAC_FUNC_CSRWR:
     case SLAC_FUNC_CSRSWP:
     case SLAC_FUNC_CSROR:
     case SLAC_FUNC_CSRCLR:
-        return c->csr(c, si);
+        return RLEN_EXEC(sys_csr);
 
-    case SLAC_FUNC_NOP:    return 0;
-    case SLAC_FUNC_UNDEF:  return SL_ERR_UNDEF;
-    default:               return SL_ERR_SLAC_INVALID;
+    case SLAC_FUNC_NOP:    return RLEN_EXEC(sys_nop);
+    case SLAC_FUNC_UNDEF:  return RLEN_EXEC(sys_undef);
+    default:               return RLEN_EXEC(exec_invalid);
     }
-    return 0;
 }
 
-static int RLEN_PREFIX(exec_br)(sl_core_t *c, sl_slac_inst_t *si) {
-    urlen_t result;
-    bool cond = false;
-
-    switch (si->func) {
-    case SLAC_FUNC_BL:
-        // todo: fix pc value based on instruction size
-        // r2 contains step offset
-        c->r[si->d0] = (urlen_t)(c->pc + si->r2);        // slac:bli/bl*
-    case SLAC_FUNC_B:
-
 /*
 arm:
     b - unconditional, pc rel
@@ -330,31 +472,85 @@ arm:
     blr uncond, reg + imm, link
     cbxx - compare and branch (rr), pc rel
 */
-        if (si->arg & SLAC_IN_ARG_R1)
-            result = c->r[si->r0]; // slac:br/blr
-        else
-            result = c->pc;              // slac:bi/bli
-        result += si->simm;
-        c->pc = result;
-        c->branch_taken = 1;
-        return 0;
-
-    case SLAC_FUNC_CBEQ:   cond = ((urlen_t)c->r[si->r0] == (urlen_t)c->r[si->r1]);    break;
-    case SLAC_FUNC_CBNE:   cond = ((urlen_t)c->r[si->r0] != (urlen_t)c->r[si->r1]);    break;
-    case SLAC_FUNC_CBLTU:  cond = ((urlen_t)c->r[si->r0] <  (urlen_t)c->r[si->r1]);    break;
-    case SLAC_FUNC_CBLTS:  cond = ((srlen_t)c->r[si->r0] <  (srlen_t)c->r[si->r1]);    break;
-    case SLAC_FUNC_CBGEU:  cond = ((urlen_t)c->r[si->r0] >= (urlen_t)c->r[si->r1]);    break;
-    case SLAC_FUNC_CBGES:  cond = ((srlen_t)c->r[si->r0] >= (srlen_t)c->r[si->r1]);    break;
-
-    default:
-        return SL_ERR_UNIMPLEMENTED;
+
+int RLEN_PREFIX(br_b)(sl_core_t *c, sl_slac_inst_t *si) {
+    c->pc = (urlen_t)(c->pc + si->imm);    // slac:bi
+    c->branch_taken = 1;
+    return 0;
+}
+
+int RLEN_PREFIX(br_br)(sl_core_t *c, sl_slac_inst_t *si) {
+    c->pc = (urlen_t)(c->r[si->r0] + si->imm); // slac:br
+    c->branch_taken = 1;
+    return 0;
+}
+
+// r2 contains step offset
+int RLEN_PREFIX(br_bl)(sl_core_t *c, sl_slac_inst_t *si) {
+    c->r[si->d0] = (urlen_t)(c->pc + si->r2);   // slac:bli
+    c->pc = (urlen_t)(c->pc + si->imm);
+    c->branch_taken = 1;
+    return 0;
+}
+
+int RLEN_PREFIX(br_blr)(sl_core_t *c, sl_slac_inst_t *si) {
+    // read the target first, the link register may also be the base
+    const urlen_t target = c->r[si->r0] + si->imm;
+    c->r[si->d0] = (urlen_t)(c->pc + si->r2);   // slac:blr
+    c->pc = target;
+    c->branch_taken = 1;
+    return 0;
+}
+
+#define SLAC_CB(name, type, op) \
+int RLEN_PREFIX(br_ ## name)(sl_core_t *c, sl_slac_inst_t *si) { \
+    if ((type)c->r[si->r0] op (type)c->r[si->r1]) { \
+        c->pc = (urlen_t)(c->pc + si->imm); \
+        c->branch_taken = 1; \
+    } \
+    return 0; \
+}
+
+SLAC_CB(cbeq,  urlen_t, ==)
+SLAC_CB(cbne,  urlen_t, !=)
+SLAC_CB(cbltu, urlen_t, <)
+SLAC_CB(cblts, srlen_t, <)
+SLAC_CB(cbgeu, urlen_t, >=)
+SLAC_CB(cbges, srlen_t, >=)
+
+static u1 RLEN_PREFIX(bind_br)(sl_slac_inst_t *si) {
+    const bool reg = si->arg & SLAC_IN_ARG_R1;
+    switch (si->func) {
+    case SLAC_FUNC_B:      return reg ? RLEN_EXEC(br_br) : RLEN_EXEC(br_b);
+    case SLAC_FUNC_BL:     return reg ? RLEN_EXEC(br_blr) : RLEN_EXEC(br_bl);
+    case SLAC_FUNC_CBEQ:   return RLEN_EXEC(br_cbeq);
+    case SLAC_FUNC_CBNE:   return RLEN_EXEC(br_cbne);
+    case SLAC_FUNC_CBLTU:  return RLEN_EXEC(br_cbltu);
+    case SLAC_FUNC_CBLTS:  return RLEN_EXEC(br_cblts);
+    case SLAC_FUNC_CBGEU:  return RLEN_EXEC(br_cbgeu);
+    case SLAC_FUNC_CBGES:  return RLEN_EXEC(br_cbges);
+    default:               return RLEN_EXEC(exec_invalid);
     }
+}
 
-    if (cond) {
-        c->pc = (urlen_t)(c->pc + si->simm);
-        c->branch_taken = 1;
+int RLEN_PREFIX(exec_invalid)(sl_core_t *c, sl_slac_inst_t *si) {
+    return SL_ERR_SLAC_INVALID;
+}
+
+static u1 RLEN_PREFIX(handler)(sl_slac_inst_t *si) {
+    switch (si->type) {
+    case SLAC_TYPE_ALU:    return RLEN_PREFIX(bind_alu)(si);
+    case SLAC_TYPE_LD:     return RLEN_PREFIX(bind_load)(si);
+    case SLAC_TYPE_ST:     return RLEN_PREFIX(bind_store)(si);
+    case SLAC_TYPE_SYS:    return RLEN_PREFIX(bind_sys)(si);
+    case SLAC_TYPE_BR:     return RLEN_PREFIX(bind_br)(si);
+    case SLAC_TYPE_FP32:   return SLAC_EXEC_FP32;
+    case SLAC_TYPE_FP64:   return SLAC_EXEC_FP64;
+    case SLAC_TYPE_ATOMIC: return RLEN_PREFIX(bind_atomic)(si);
+    case SLAC_TYPE_VEC:
+    case SLAC_TYPE_SIMD:
+    default:               return RLEN_EXEC(exec_invalid);
     }
-    return 0;
 }
 
 // todo: move this
@@ -362,59 +558,14 @@ int rv_slac_print_pre(sl_core_t *c, sl_slac_inst_t *si, char *buf, int buflen);
 int rv_slac_print_post(sl_core_t *c, sl_slac_inst_t *si, char *buf, int buflen);
 
 int RLEN_PREFIX(dispatch)(sl_core_t *c, sl_slac_inst_t *si) {
-    if (si->sh == 1) c->prev_len = 2;
-
 #if SLAC_TRACE
     #define BUFLEN 256
     char buf[BUFLEN];
     int len = rv_slac_print_pre(c, si, buf, BUFLEN);
 #endif
 
-    int err = 0;
-
-#if 0
-    if (__builtin_expect(si->pred, SLAC_PRED_ALWAYS))
-        goto type_dispatch;
-
-    switch (si->pred) {
-    case SLAC_PRED_NEVER:   goto out;
-
-    case SLAC_PRED_EQ:
-    case SLAC_PREG_NE:
-    case SLAC_PRED_HS:
-    case SLAC_PRED_LO:
-    case SLAC_PRED_POS:
-    case SLAC_PRED_NEG:
-    case SLAC_PRED_NOF:
-    case SLAC_PRED_OF:
-    case SLAC_PRED_HI:
-    case SLAC_PRED_LS:
-    case SLAC_PRED_GE:
-    case SLAC_PRED_LT:
-    case SLAC_PRED_GT:
-    case SLAC_PRED_LE:
-        return SL_ERR_UNIMPLEMENTED;
-    }
+    int err = slac_exec_table[RLEN_PREFIX(handler)(si)](c, si);
 
-type_dispatch:
-#endif
-    switch (si->type) {
-    case SLAC_TYPE_ALU:  err = RLEN_PREFIX(exec_alu)(c, si);     break;
-    case SLAC_TYPE_LD:   err = RLEN_PREFIX(exec_load)(c, si);    break;
-    case SLAC_TYPE_ST:   err = RLEN_PREFIX(exec_store)(c, si);   break;
-    case SLAC_TYPE_SYS:  err = RLEN_PREFIX(exec_sys)(c, si);     break;
-    case SLAC_TYPE_BR:   err = RLEN_PREFIX(exec_br)(c, si);      break;
-    case SLAC_TYPE_FP32: err = slac_exec_fp32(c, si);            break;
-    case SLAC_TYPE_FP64: err = slac_exec_fp64(c, si);            break;
-
-    case SLAC_TYPE_ATOMIC: err = RLEN_PREFIX(exec_atomic)(c, si); break;
-    case SLAC_TYPE_VEC:
-    case SLAC_TYPE_SIMD:
-    default:
-        return SL_ERR_SLAC_INVALID;
-    }
-
-// out:
 #if SLAC_TRACE
     len += rv_slac_print_post(c, si, buf + len, BUFLEN - len);
 
@@ -431,3 +582,11 @@ type_dispatch:
 #endif
     return err;
 }
+
+void RLEN_PREFIX(bind)(sl_slac_inst_t *si) {
+#if SLAC_TRACE
+    si->exec = RLEN_EXEC(dispatch);
+#else
+    si->exec = RLEN_PREFIX(handler)(si);
+#endif
+}
@@ -17,10 +17,36 @@
 static void queue_add(sl_worker_t *w, sl_event_t *ev) {
     sl_lock_lock(&w->lock);
     sl_list_add_last(&w->ev_list, &ev->node);
+    atomic_store_explicit(&w->attention, 1, memory_order_release);
     sl_cond_signal_all(&w->has_event);
     sl_lock_unlock(&w->lock);
 }
 
+// Put back events left after a handler failed, ahead of any queued since.
+static void queue_return(sl_worker_t *w, sl_list_node_t *n) {
+    sl_lock_lock(&w->lock);
+    sl_list_node_t *later = sl_list_remove_all(&w->ev_list);
+    while (n != NULL) {
+        sl_list_node_t *next = n->next;
+        sl_list_add_last(&w->ev_list, n);
+        n = next;
+    }
+    while (later != NULL) {
+        sl_list_node_t *next = later->next;
+        sl_list_add_last(&w->ev_list, later);
+        later = next;
+    }
+    atomic_store_explicit(&w->attention, 1, memory_order_release);
+    sl_lock_unlock(&w->lock);
+}
+
+// release an event that won't be handled
+static void event_drop(sl_event_t *ev) {
+    ev->err = SL_ERR_STATE;
+    if (ev->flags & SL_EV_FLAG_SIGNAL) sl_sem_post((sl_sem_t *)ev->signal);
+    else if (ev->flags & SL_EV_FLAG_FREE) free(ev);
+}
+
 static int handle_events(sl_worker_t *w, bool wait) {
     sl_lock_lock(&w->lock);
     if (wait) {
@@ -50,18 +76,21 @@ static int handle_events(sl_worker_t *w, bool wait) {
         if (ev->flags & SL_EV_FLAG_SIGNAL) sl_sem_post((sl_sem_t *)ev->signal);
         else if (ev->flags & SL_EV_FLAG_FREE) free(ev);
     }
+    if (ev_list != NULL) queue_return(w, ev_list);
     return err;
 }
 
 void sl_worker_set_engine_runnable(sl_worker_t *w, bool runnable) {
     if (runnable) w->state |= SL_WORKER_STATE_ENGINE_RUNNABLE;
     else w->state &= ~SL_WORKER_STATE_ENGINE_RUNNABLE;
+    atomic_store_explicit(&w->attention, 1, memory_order_relaxed);
 }
 
 int sl_worker_add_engine(sl_worker_t *w, sl_engine_t *e, u4 *id_out) {
     int err = sl_worker_add_event_endpoint(w, &e->event_ep, id_out);
     if (err) return err;
     e->worker = w;
+    e->epid = *id_out;
     w->engine = e;
     return 0;
 }
@@ -100,11 +129,13 @@ int sl_worker_event_enqueue_async(sl_worker_t *w, sl_event_t *ev) {
 int sl_worker_handle_events(sl_worker_t *w) {
     int err = 0;
 
+    // Only the attention flag is read on the fast path. It is cleared before the
+    // queue is drained, so an event added after the drain sets it again.
+    if (atomic_load_explicit(&w->attention, memory_order_relaxed) == 0) return 0;
+    atomic_exchange_explicit(&w->attention, 0, memory_order_acquire);
+
     if (w->state & SL_WORKER_STATE_ENGINE_RUNNABLE) {
-        void *n = atomic_load_explicit((_Atomic(sl_list_node_t *)*)&w->ev_list.first, memory_order_relaxed);
-        if (n != NULL) {
-            if ((err = handle_events(w, false))) return err;
-        }
+        if ((err = handle_events(w, false))) return err;
     }
 
     while ((w->state & SL_WORKER_STATE_ENGINE_RUNNABLE) == 0) {
@@ -162,6 +193,7 @@ int sl_worker_init(sl_worker_t *w, const char *name) {
     w->thread_running = false;
     sl_lock_init(&w->lock);
     sl_cond_init(&w->has_event);
+    atomic_init(&w->attention, 1);
     return 0;
 }
 
@@ -180,6 +212,13 @@ int sl_worker_create(const char *name, sl_worker_t **w_out) {
 
 void sl_worker_shutdown(sl_worker_t *w) {
     assert(!w->thread_running);
+    // devices may still have raised interrupts after the engine stopped
+    sl_list_node_t *n = sl_list_remove_all(&w->ev_list);
+    while (n != NULL) {
+        sl_event_t *ev = (sl_event_t *)n;
+        n = n->next;
+        event_drop(ev);
+    }
     sl_lock_destroy(&w->lock);
     sl_cond_destroy(&w->has_event);
 }
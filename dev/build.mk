@@ -5,4 +5,5 @@ sled_rtc_CSOURCES      := $(SRCDIR)/sled/rtc.c
 sled_uart_CSOURCES     := $(SRCDIR)/sled/uart.c
 sled_mpu_CSOURCES      := $(SRCDIR)/sled/mpu.c
 sled_timer_CSOURCES    := $(SRCDIR)/sled/timer.c
+sled_dma_CSOURCES      := $(SRCDIR)/sled/dma.c
 
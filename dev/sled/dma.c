@@ -0,0 +1,523 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <device/sled/dma.h>
+#include <sled/core.h>
+#include <sled/device.h>
+#include <sled/engine.h>
+#include <sled/error.h>
+#include <sled/io.h>
+#include <sled/irq.h>
+#include <sled/machine.h>
+#include <sled/mapper.h>
+#include <sled/worker.h>
+
+// sled DMA device
+
+#define DMA_TYPE 'dmac'
+#define DMA_VERSION 0
+
+// bytes copied per channel before moving on to the next one, so channels
+// share the worker and events are seen between copies
+#define DMA_CHUNK_SIZE      (64 * 1024)
+#define DMA_BOUNCE_SIZE     4096
+#define DMA_STEPS_PER_POLL  16
+
+typedef struct {
+    u4 config;
+    u4 gen;         // bumped on every start, progress from an older run is dropped
+    int error;
+    u8 desc;
+
+    // progress through the current descriptor
+    u8 cur;
+    bool loaded;    // src, dst, len and next hold the current descriptor
+    u8 src;
+    u8 dst;
+    u8 len;
+    u8 next;
+} sled_dma_chan_t;
+
+typedef struct {
+    sl_dev_t *dev;
+    sl_mapper_t *mapper;    // bus the channels master
+    sl_engine_t *engine;
+    sl_worker_t *worker;
+    bool running;
+    // held by the worker over each step and by the machine while paused, so
+    // no copy is in flight while memory is saved or restored
+    pthread_mutex_t service_lock;
+
+    // registers
+    u4 config;
+    sled_dma_chan_t chan[DMA_MAX_CHANNELS];
+
+    // worker only
+    u4 next_chan;
+    u1 bounce[DMA_BOUNCE_SIZE] __attribute__((aligned(8)));
+} sled_dma_t;
+
+static sled_dma_chan_t * addr_to_chan(sled_dma_t *d, u8 addr, u4 *reg, u4 *index) {
+    addr -= 0x20;
+    *index = addr / 0x20;
+    *reg = (addr & (0x20 - 1)) >> 2;
+    return &d->chan[*index];
+}
+
+static int dma_read(void *ctx, u8 addr, u4 size, u4 count, void *buf) {
+    if (size != 4) return SL_ERR_IO_SIZE;
+    if (count != 1) return SL_ERR_IO_COUNT;
+    if (addr & 3) return SL_ERR_IO_ALIGN;
+
+    sled_dma_t *d = ctx;
+    u4 *val = buf;
+    int err = 0;
+    sl_irq_mux_t *m;
+
+    sl_device_lock(d->dev);
+    switch (addr) {
+    case DMA_REG_DEV_TYPE:      *val = DMA_TYPE;            goto out;
+    case DMA_REG_DEV_VERSION:   *val = DMA_VERSION;         goto out;
+    case DMA_REG_CONFIG:        *val = d->config;           goto out;
+    case DMA_REG_NUM_CHANNELS:  *val = DMA_MAX_CHANNELS;    goto out;
+
+    case DMA_IRQ_MASK:
+        m = sl_device_get_irq_mux(d->dev);
+        *val = ~sl_irq_mux_get_enabled(m);
+        goto out;
+
+    case DMA_IRQ_STATUS:
+        m = sl_device_get_irq_mux(d->dev);
+        *val = sl_irq_mux_get_active(m);
+        goto out;
+
+    default:    break;
+    }
+    if ((addr < 0x20) || (addr >= DMA_APERTURE_LENGTH)) {
+        err = SL_ERR_IO_INVALID;
+        goto out;
+    }
+
+    u4 reg, index;
+    sled_dma_chan_t *ch = addr_to_chan(d, addr, &reg, &index);
+    switch (reg) {
+    case 0:     *val = ch->config;                  break;
+    case 1:     *val = (u4)ch->desc;                break;
+    case 2:     *val = (u4)(ch->desc >> 32);        break;
+    case 3:     *val = (u4)ch->cur;                 break;
+    case 4:     *val = (u4)(ch->cur >> 32);         break;
+    case 5:     *val = (u4)ch->error;               break;
+    default:    err = SL_ERR_IO_INVALID;            break;
+    }
+
+out:
+    sl_device_unlock(d->dev);
+    return err;
+}
+
+static void dma_chan_start_locked(sled_dma_chan_t *ch) {
+    ch->config &= ~(DMA_CHAN_CONFIG_DONE | DMA_CHAN_CONFIG_ERROR);
+    ch->config |= DMA_CHAN_CONFIG_RUN;
+    ch->gen++;
+    ch->error = 0;
+    ch->cur = ch->desc;
+    ch->loaded = false;
+}
+
+// returns true if the worker needs to be woken up
+static bool dma_set_chan_config_locked(sled_dma_chan_t *ch, u4 val) {
+    // clear done and error on write
+    ch->config &= ~(val & (DMA_CHAN_CONFIG_DONE | DMA_CHAN_CONFIG_ERROR));
+
+    if (ch->config & DMA_CHAN_CONFIG_RUN) {
+        if ((val & DMA_CHAN_CONFIG_RUN) == 0) {
+            // stop channel, a copy in progress is dropped by the worker
+            ch->config &= ~DMA_CHAN_CONFIG_RUN;
+            ch->gen++;
+            ch->cur = 0;
+        }
+        return false;
+    }
+    if ((val & DMA_CHAN_CONFIG_RUN) == 0) return false;
+    dma_chan_start_locked(ch);
+    return true;
+}
+
+static int dma_write(void *ctx, u8 addr, u4 size, u4 count, void *buf) {
+    if (size != 4) return SL_ERR_IO_SIZE;
+    if (count != 1) return SL_ERR_IO_COUNT;
+    if (addr & 3) return SL_ERR_IO_ALIGN;
+
+    sled_dma_t *d = ctx;
+    u4 val = *(u4 *)buf;
+    int err = 0;
+    bool kick = false;
+    sl_irq_mux_t *m;
+
+    sl_device_lock(d->dev);
+    switch (addr) {
+    case DMA_REG_CONFIG:        d->config = val;    goto out;
+
+    case DMA_IRQ_MASK:
+        m = sl_device_get_irq_mux(d->dev);
+        sl_irq_mux_set_enabled(m, ~val);
+        goto out;
+
+    case DMA_IRQ_STATUS: {
+        m = sl_device_get_irq_mux(d->dev);
+        u4 vec = sl_irq_mux_get_active(m);
+        vec &= ~val;
+        sl_irq_mux_set_active(m, vec);
+        goto out;
+    }
+
+    case DMA_REG_DEV_TYPE:
+    case DMA_REG_DEV_VERSION:
+    case DMA_REG_NUM_CHANNELS:
+        err = SL_ERR_IO_NOWR;
+        goto out;
+
+    default:    break;
+    }
+    if ((addr < 0x20) || (addr >= DMA_APERTURE_LENGTH)) {
+        err = SL_ERR_IO_INVALID;
+        goto out;
+    }
+
+    u4 reg, index;
+    sled_dma_chan_t *ch = addr_to_chan(d, addr, &reg, &index);
+    switch (reg) {
+    case 0: // DMA_REG_CHAN_CONFIG
+        kick = dma_set_chan_config_locked(ch, val);                 break;
+
+    case 1: // DMA_REG_CHAN_DESC_LO
+        ch->desc = (ch->desc & 0xffffffff00000000) | val;           break;
+
+    case 2: // DMA_REG_CHAN_DESC_HI
+        ch->desc = (ch->desc & 0xffffffff) | ((u8)val << 32);       break;
+
+    case 3: // DMA_REG_CHAN_CURRENT_LO
+    case 4: // DMA_REG_CHAN_CURRENT_HI
+    case 5: // DMA_REG_CHAN_ERROR
+        err = SL_ERR_IO_NOWR;                                       break;
+
+    default:
+        err = SL_ERR_IO_INVALID;                                    break;
+    }
+
+out:
+    sl_device_unlock(d->dev);
+    if (kick) err = sl_engine_async_command(d->engine, SL_CORE_CMD_RUN, false);
+    return err;
+}
+
+// Descriptors are read with one bulk io rather than a load per word.
+static int dma_load_desc(sled_dma_t *d, u8 addr, u8 desc[4]) {
+    if (addr & 7) return SL_ERR_IO_ALIGN;
+    sl_io_op_t op;
+    op.addr = addr;
+    op.size = 8;
+    op.op = IO_OP_IN;
+    op.align = 1;
+    op.count = 4;
+    op.buf = desc;
+    op.agent = d;
+    return sl_mapper_io(d->mapper, &op);
+}
+
+static int dma_bulk_io(sled_dma_t *d, u1 io, u8 addr, u2 size, u8 len) {
+    sl_io_op_t op;
+    op.addr = addr;
+    op.size = size;
+    op.op = io;
+    op.align = 1;
+    op.count = len / size;
+    op.buf = d->bounce;
+    op.agent = d;
+    return sl_mapper_io(d->mapper, &op);
+}
+
+// Copy up to len bytes from src to dst. Memory on both sides is copied
+// directly through the host pointers the bus resolves to, and the write is
+// logged on the bus so cores reset any code decoded from it. Anything else,
+// such as a device register, goes through a bounce buffer with the widest
+// io size the addresses and length allow. A resolve that backs no bytes at
+// the address takes the bounce path too, so the copy either makes progress
+// or fails the descriptor.
+static int dma_copy(sled_dma_t *d, u8 dst, u8 src, u8 len, u8 *done_out) {
+    u8 src_len = 0, dst_len = 0;
+    u2 src_perm, dst_perm;
+
+    resultptr_t s = sl_mapper_resolve(d->mapper, src, &src_len, &src_perm);
+    resultptr_t t = sl_mapper_resolve(d->mapper, dst, &dst_len, &dst_perm);
+    if ((s.err == 0) && (t.err == 0) && (src_perm & SL_MAP_PERM_READ) && (dst_perm & SL_MAP_PERM_WRITE)
+        && (src_len != 0) && (dst_len != 0)) {
+        if (len > src_len) len = src_len;
+        if (len > dst_len) len = dst_len;
+        memmove(t.value, s.value, len);
+        sl_mapper_log_write(d->mapper, t.value, len);
+        *done_out = len;
+        return 0;
+    }
+
+    if (len > DMA_BOUNCE_SIZE) len = DMA_BOUNCE_SIZE;
+    u2 size = 8;
+    while ((size > 1) && ((src | dst | len) & (size - 1))) size >>= 1;
+    if (len < size) size = 1;
+
+    int err;
+    if ((err = dma_bulk_io(d, IO_OP_IN, src, size, len))) return err;
+    if ((err = dma_bulk_io(d, IO_OP_OUT, dst, size, len))) return err;
+    if (t.err == 0) sl_mapper_log_write(d->mapper, t.value, (len < dst_len) ? len : dst_len);
+    *done_out = len;
+    return 0;
+}
+
+// Run one step of one channel: load its next descriptor or copy a chunk of
+// the current one. The device lock isn't held over the bus access, so the
+// guest can read registers or stop the channel while a copy is in progress.
+// Returns false if no channel is running.
+static bool dma_service_chan(sled_dma_t *d) {
+    sl_device_lock(d->dev);
+    sled_dma_chan_t *ch = NULL;
+    u4 index = 0;
+    for (u4 i = 0; i < DMA_MAX_CHANNELS; i++) {
+        index = (d->next_chan + i) % DMA_MAX_CHANNELS;
+        if (d->chan[index].config & DMA_CHAN_CONFIG_RUN) {
+            ch = &d->chan[index];
+            break;
+        }
+    }
+    if (ch == NULL) {
+        sl_device_unlock(d->dev);
+        return false;
+    }
+    d->next_chan = index + 1;
+    sled_dma_chan_t xfer = *ch;
+    sl_device_unlock(d->dev);
+
+    int err = 0;
+    u8 desc[4];
+    u8 done = 0;
+    if (!xfer.loaded) {
+        if ((err = dma_load_desc(d, xfer.cur, desc)) == 0) {
+            xfer.src = desc[DMA_DESC_SRC / 8];
+            xfer.dst = desc[DMA_DESC_DST / 8];
+            xfer.len = desc[DMA_DESC_LEN / 8];
+            xfer.next = desc[DMA_DESC_NEXT / 8];
+            xfer.loaded = true;
+        }
+    } else if (xfer.len > 0) {
+        const u8 len = (xfer.len > DMA_CHUNK_SIZE) ? DMA_CHUNK_SIZE : xfer.len;
+        if ((err = dma_copy(d, xfer.dst, xfer.src, len, &done)) == 0) {
+            xfer.src += done;
+            xfer.dst += done;
+            xfer.len -= done;
+        }
+    }
+
+    sl_device_lock(d->dev);
+    // drop the progress if the channel was stopped or restarted meanwhile
+    if ((ch->gen != xfer.gen) || !(ch->config & DMA_CHAN_CONFIG_RUN)) goto out;
+
+    bool irq = false;
+    if (err) {
+        ch->config &= ~DMA_CHAN_CONFIG_RUN;
+        ch->config |= DMA_CHAN_CONFIG_ERROR;
+        ch->error = err;
+        irq = true;
+    } else if (xfer.loaded && (xfer.len == 0)) {
+        if (xfer.next == 0) {
+            ch->config &= ~DMA_CHAN_CONFIG_RUN;
+            ch->config |= DMA_CHAN_CONFIG_DONE;
+            ch->cur = 0;
+            irq = true;
+        } else {
+            ch->cur = xfer.next;
+            ch->loaded = false;
+        }
+    } else {
+        ch->loaded = xfer.loaded;
+        ch->src = xfer.src;
+        ch->dst = xfer.dst;
+        ch->len = xfer.len;
+        ch->next = xfer.next;
+    }
+    if (irq) sl_irq_mux_set_active_bit(sl_device_get_irq_mux(d->dev), index, true);
+
+out:
+    sl_device_unlock(d->dev);
+    return true;
+}
+
+static bool dma_service(sled_dma_t *d) {
+    pthread_mutex_lock(&d->service_lock);
+    const bool busy = dma_service_chan(d);
+    pthread_mutex_unlock(&d->service_lock);
+    return busy;
+}
+
+static int dma_engine_step(sl_engine_t *e, u8 num) {
+    sled_dma_t *d = sl_engine_get_context(e);
+    for (u8 i = 0; i < num; i++) {
+        if (!dma_service(d)) {
+            // sleep until a channel is started
+            sl_worker_set_engine_runnable(d->worker, false);
+            break;
+        }
+    }
+    return 0;
+}
+
+static int dma_engine_run(sl_engine_t *e) {
+    sled_dma_t *d = sl_engine_get_context(e);
+    int err;
+    while ((err = sl_worker_handle_events(d->worker)) == 0)
+        dma_engine_step(e, DMA_STEPS_PER_POLL);
+    return (err == SL_ERR_EXITED) ? 0 : err;
+}
+
+static const sl_engine_ops_t dma_engine_ops = {
+    .step = dma_engine_step,
+    .run = dma_engine_run,
+};
+
+typedef struct {
+    u4 config;
+    u4 irq_enabled;
+    u4 irq_active;
+    struct {
+        u4 config;
+        int error;
+        u8 desc;
+        u8 cur;
+        u4 loaded;
+        u8 src;
+        u8 dst;
+        u8 len;
+        u8 next;
+    } chan[DMA_MAX_CHANNELS];
+} dma_state_t;
+
+static int sled_dma_save(sl_dev_t *dev, void **state_out, usize *len_out) {
+    sled_dma_t *d = sl_device_get_context(dev);
+    dma_state_t *s = calloc(1, sizeof(*s));
+    if (s == NULL) return SL_ERR_MEM;
+    sl_irq_mux_t *m = sl_device_get_irq_mux(d->dev);
+
+    sl_device_lock(d->dev);
+    s->config = d->config;
+    s->irq_enabled = sl_irq_mux_get_enabled(m);
+    s->irq_active = sl_irq_mux_get_active(m);
+    for (int i = 0; i < DMA_MAX_CHANNELS; i++) {
+        sled_dma_chan_t *ch = &d->chan[i];
+        s->chan[i].config = ch->config;
+        s->chan[i].error = ch->error;
+        s->chan[i].desc = ch->desc;
+        s->chan[i].cur = ch->cur;
+        s->chan[i].loaded = ch->loaded;
+        s->chan[i].src = ch->src;
+        s->chan[i].dst = ch->dst;
+        s->chan[i].len = ch->len;
+        s->chan[i].next = ch->next;
+    }
+    sl_device_unlock(d->dev);
+    *state_out = s;
+    *len_out = sizeof(*s);
+    return 0;
+}
+
+// Running channels carry on from the copy they were at when the snapshot
+// was taken.
+static int sled_dma_restore(sl_dev_t *dev, const void *state, usize len) {
+    sled_dma_t *d = sl_device_get_context(dev);
+    const dma_state_t *s = state;
+    if (len != sizeof(*s)) return SL_ERR_ARG;
+    sl_irq_mux_t *m = sl_device_get_irq_mux(d->dev);
+    bool kick = false;
+
+    sl_device_lock(d->dev);
+    d->config = s->config;
+    sl_irq_mux_set_enabled(m, s->irq_enabled);
+    sl_irq_mux_set_active(m, s->irq_active);
+    for (int i = 0; i < DMA_MAX_CHANNELS; i++) {
+        sled_dma_chan_t *ch = &d->chan[i];
+        ch->gen++;
+        ch->config = s->chan[i].config;
+        ch->error = s->chan[i].error;
+        ch->desc = s->chan[i].desc;
+        ch->cur = s->chan[i].cur;
+        ch->loaded = s->chan[i].loaded;
+        ch->src = s->chan[i].src;
+        ch->dst = s->chan[i].dst;
+        ch->len = s->chan[i].len;
+        ch->next = s->chan[i].next;
+        if (ch->config & DMA_CHAN_CONFIG_RUN) kick = true;
+    }
+    sl_device_unlock(d->dev);
+    if (kick) return sl_engine_async_command(d->engine, SL_CORE_CMD_RUN, false);
+    return 0;
+}
+
+static void sled_dma_pause(sl_dev_t *dev) {
+    sled_dma_t *d = sl_device_get_context(dev);
+    pthread_mutex_lock(&d->service_lock);
+}
+
+static void sled_dma_resume(sl_dev_t *dev) {
+    sled_dma_t *d = sl_device_get_context(dev);
+    pthread_mutex_unlock(&d->service_lock);
+}
+
+static void sled_dma_destroy(sl_dev_t *dev) {
+    sled_dma_t *d = sl_device_get_context(dev);
+    if (d == NULL) return;
+    if (d->running) {
+        sl_engine_async_command(d->engine, SL_CORE_CMD_EXIT, false);
+        sl_worker_thread_join(d->worker);
+    }
+    sl_worker_destroy(d->worker);
+    sl_engine_destory(d->engine);
+    pthread_mutex_destroy(&d->service_lock);
+    free(d);
+}
+
+static int sled_dma_create(sl_dev_t *dev, sl_dev_config_t *cfg) {
+    sled_dma_t *d = calloc(1, sizeof(sled_dma_t));
+    if (d == NULL) return SL_ERR_MEM;
+
+    d->dev = dev;
+    pthread_mutex_init(&d->service_lock, NULL);
+    cfg->aperture = DMA_APERTURE_LENGTH;
+    sl_device_set_context(dev, d);
+    d->mapper = sl_machine_get_mapper(cfg->machine);
+
+    // a failed create is cleaned up by sled_dma_destroy
+    int err;
+    u4 id;
+    if ((err = sl_engine_create(cfg->name, &dma_engine_ops, &d->engine))) return err;
+    sl_engine_set_context(d->engine, d);
+    if ((err = sl_worker_create("dma_worker", &d->worker))) return err;
+    if ((err = sl_worker_add_engine(d->worker, d->engine, &id))) return err;
+    if ((err = sl_worker_thread_run(d->worker))) return err;
+    d->running = true;
+    return 0;
+}
+
+static const sl_dev_ops_t dma_ops = {
+    .type = SL_DEV_SLED_DMA,
+    .read = dma_read,
+    .write = dma_write,
+    .create = sled_dma_create,
+    .destroy = sled_dma_destroy,
+    .save = sled_dma_save,
+    .restore = sled_dma_restore,
+    .pause = sled_dma_pause,
+    .resume = sled_dma_resume,
+};
+
+DECLARE_DEVICE(sled_dma, SL_DEV_DMA, &dma_ops);
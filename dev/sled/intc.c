@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <device/sled/intc.h>
 #include <sled/device.h>
@@ -11,15 +12,29 @@
 #include <sled/irq.h>
 
 #define INTC_TYPE 'intc'
-#define INTC_VERSION 0
+#define INTC_VERSION 1
 
 #define INTC_NUM_SUPPORTED  32
 
 typedef struct {
     sl_dev_t *dev;
     sl_irq_ep_t *irq_ep;
+    u4 target[INTC_MAX_HARTS];
+    // Each hart's output is driven through an endpoint of its own, raising
+    // line 0 of it while any interrupt routed to the hart is active.
+    sl_irq_ep_t *hart_ep[INTC_MAX_HARTS];
 } sled_intc_t;
 
+static void intc_update_harts_locked(sled_intc_t *ic) {
+    const u4 active = sl_irq_endpoint_get_active(ic->irq_ep);
+    for (u4 i = 0; i < INTC_MAX_HARTS; i++) {
+        if (ic->hart_ep[i] == NULL) continue;
+        const bool high = (active & ic->target[i]) != 0;
+        sl_irq_endpoint_assert(ic->hart_ep[i], 0, high);
+        if (!high) sl_irq_endpoint_clear(ic->hart_ep[i], 1);
+    }
+}
+
 sl_irq_ep_t * sled_intc_get_irq_ep(sl_dev_t *d) {
     sled_intc_t *ic = sl_device_get_context(d);
     return ic->irq_ep;
@@ -31,6 +46,23 @@ int sled_intc_set_input(sl_dev_t *intc, sl_dev_t *src, u4 num) {
     return sl_irq_mux_set_client(sl_device_get_irq_mux(src), ic->irq_ep, num);
 }
 
+int sled_intc_set_target(sl_dev_t *intc, u4 hart, sl_irq_ep_t *ep, u4 num) {
+    if (hart >= INTC_MAX_HARTS) return SL_ERR_RANGE;
+    sled_intc_t *ic = sl_device_get_context(intc);
+    int err = 0;
+
+    sl_device_lock(ic->dev);
+    if (ic->hart_ep[hart] == NULL) {
+        if ((err = sl_irq_ep_create(&ic->hart_ep[hart]))) goto out;
+        sl_irq_endpoint_set_enabled(ic->hart_ep[hart], SL_IRQ_VEC_ALL);
+    }
+    if ((err = sl_irq_endpoint_set_client(ic->hart_ep[hart], ep, num))) goto out;
+    intc_update_harts_locked(ic);
+out:
+    sl_device_unlock(ic->dev);
+    return err;
+}
+
 static int intc_read(void *ctx, u8 addr, u4 size, u4 count, void *buf) {
     if (size != 4) return SL_ERR_IO_SIZE;
     if (count != 1) return SL_ERR_IO_COUNT;
@@ -45,7 +77,12 @@ static int intc_read(void *ctx, u8 addr, u4 size, u4 count, void *buf) {
     case INTC_REG_DEV_VERSION:  *val = INTC_VERSION;        break;
     case INTC_REG_ASSERTED:     *val = sl_irq_endpoint_get_asserted(ic->irq_ep);    break;
     case INTC_REG_MASK:         *val = ~sl_irq_endpoint_get_enabled(ic->irq_ep);     break;
-    default:                    err = SL_ERR_IO_INVALID;    break;
+    default:
+        if ((addr >= INTC_REG_TARGET(0)) && (addr < INTC_APERTURE_LENGTH) && !(addr & 3))
+            *val = ic->target[(addr - INTC_REG_TARGET(0)) / 4];
+        else
+            err = SL_ERR_IO_INVALID;
+        break;
     }
     sl_device_unlock(ic->dev);
     return err;
@@ -71,8 +108,14 @@ static int intc_write(void *ctx, u8 addr, u4 size, u4 count, void *buf) {
         err = sl_irq_endpoint_set_enabled(ic->irq_ep, ~val);
         break;
 
-    default:    err = SL_ERR_IO_INVALID;    break;
+    default:
+        if ((addr >= INTC_REG_TARGET(0)) && (addr < INTC_APERTURE_LENGTH) && !(addr & 3))
+            ic->target[(addr - INTC_REG_TARGET(0)) / 4] = val;
+        else
+            err = SL_ERR_IO_INVALID;
+        break;
     }
+    if (err == 0) intc_update_harts_locked(ic);
     sl_device_unlock(ic->dev);
     return err;
 }
@@ -83,6 +126,44 @@ static int sled_intc_assert(sl_irq_ep_t *ep, u4 num, bool high) {
 
     sl_device_lock(ic->dev);
     int err = sl_irq_endpoint_assert(ep, num, high);
+    if (err == 0) intc_update_harts_locked(ic);
+    sl_device_unlock(ic->dev);
+    return err;
+}
+
+typedef struct {
+    u4 enabled;
+    u4 asserted;
+    u4 target[INTC_MAX_HARTS];
+} intc_state_t;
+
+static int sled_intc_save(sl_dev_t *d, void **state_out, usize *len_out) {
+    sled_intc_t *ic = sl_device_get_context(d);
+    intc_state_t *s = malloc(sizeof(*s));
+    if (s == NULL) return SL_ERR_MEM;
+    sl_device_lock(ic->dev);
+    s->enabled = sl_irq_endpoint_get_enabled(ic->irq_ep);
+    s->asserted = sl_irq_endpoint_get_asserted(ic->irq_ep);
+    memcpy(s->target, ic->target, sizeof(s->target));
+    sl_device_unlock(ic->dev);
+    *state_out = s;
+    *len_out = sizeof(*s);
+    return 0;
+}
+
+static int sled_intc_restore(sl_dev_t *d, const void *state, usize len) {
+    sled_intc_t *ic = sl_device_get_context(d);
+    const intc_state_t *s = state;
+    if (len != sizeof(*s)) return SL_ERR_ARG;
+    sl_device_lock(ic->dev);
+    memcpy(ic->target, s->target, sizeof(ic->target));
+    int err = sl_irq_endpoint_set_enabled(ic->irq_ep, s->enabled);
+    const u4 cur = sl_irq_endpoint_get_asserted(ic->irq_ep);
+    if (!err && (cur & ~s->asserted)) err = sl_irq_endpoint_clear(ic->irq_ep, cur & ~s->asserted);
+    for (u4 i = 0; !err && (i < INTC_NUM_SUPPORTED); i++) {
+        if ((s->asserted & ~cur) & (1u << i)) err = sl_irq_endpoint_assert(ic->irq_ep, i, true);
+    }
+    intc_update_harts_locked(ic);
     sl_device_unlock(ic->dev);
     return err;
 }
@@ -90,6 +171,7 @@ static int sled_intc_assert(sl_irq_ep_t *ep, u4 num, bool high) {
 static void sled_intc_destroy(sl_dev_t *d) {
     sled_intc_t *ic = sl_device_get_context(d);
     sl_irq_ep_destroy(ic->irq_ep);
+    for (u4 i = 0; i < INTC_MAX_HARTS; i++) sl_irq_ep_destroy(ic->hart_ep[i]);
     free(ic);
 }
 
@@ -107,6 +189,7 @@ static int sled_intc_create(sl_dev_t *d, sl_dev_config_t *cfg) {
     }
     sl_irq_endpoint_set_context(ic->irq_ep, ic);
     sl_irq_endpoint_set_handler(ic->irq_ep, sled_intc_assert);
+    ic->target[0] = 0xffffffff;
     return 0;
 }
 
@@ -116,6 +199,8 @@ static const sl_dev_ops_t intc_ops = {
     .write = intc_write,
     .create = sled_intc_create,
     .destroy = sled_intc_destroy,
+    .save = sled_intc_save,
+    .restore = sled_intc_restore,
 };
 
 DECLARE_DEVICE(sled_intc, SL_DEV_INTC, &intc_ops);
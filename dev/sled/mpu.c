@@ -2,6 +2,7 @@
 // Copyright (c) 2023-2024 Shac Ron and The Sled Project
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -15,7 +16,7 @@
 // sled MPU device
 
 #define MPU_TYPE 'mpux'
-#define MPU_VERSION 0
+#define MPU_VERSION 1
 
 typedef struct {
     sl_dev_t *dev;
@@ -26,6 +27,11 @@ typedef struct {
     u4 map_len[MPU_MAX_MAPPINGS];
     u8 va_base[MPU_MAX_MAPPINGS];
     u8 pa_base[MPU_MAX_MAPPINGS];
+    u4 deny[MPU_MAX_MAPPINGS];
+
+    // mappings last applied, kept for snapshots
+    u4 applied_count;
+    sl_mapping_t applied[MPU_MAX_MAPPINGS];
 } sled_mpu_t;
 
 static int mpu_read(void *ctx, u8 addr, u4 size, u4 count, void *buf) {
@@ -63,6 +69,11 @@ static int mpu_read(void *ctx, u8 addr, u4 size, u4 count, void *buf) {
         *val = m->map_len[index];
         goto out;
     }
+    if ((addr >= MPU_REG_MAP_DENY(0)) && (addr < MPU_REG_MAP_DENY(MPU_MAX_MAPPINGS))) {
+        const u4 index = (addr - MPU_REG_MAP_DENY(0)) >> 2;
+        *val = m->deny[index];
+        goto out;
+    }
     err = SL_ERR_IO_INVALID;
 out:
     sl_device_unlock(m->dev);
@@ -70,8 +81,18 @@ out:
 }
 
 static void clear_entries(sled_mpu_t *m) {
-    const usize size = (sizeof(u8) * 2 * MPU_MAX_MAPPINGS) + (sizeof(u4) * MPU_MAX_MAPPINGS);
-    memset(m->map_len, 0, size);
+    memset(m->map_len, 0, sizeof(m->map_len));
+    memset(m->va_base, 0, sizeof(m->va_base));
+    memset(m->pa_base, 0, sizeof(m->pa_base));
+    memset(m->deny, 0, sizeof(m->deny));
+}
+
+static u2 map_permissions(u4 deny) {
+    u2 perm = SL_MAP_PERM_ALL;
+    if (deny & MPU_DENY_READ) perm &= ~SL_MAP_PERM_READ;
+    if (deny & MPU_DENY_WRITE) perm &= ~SL_MAP_PERM_WRITE;
+    if (deny & MPU_DENY_EXEC) perm &= ~SL_MAP_PERM_EXEC;
+    return perm;
 }
 
 static int update_config(sled_mpu_t *m, u4 val) {
@@ -79,7 +100,7 @@ static int update_config(sled_mpu_t *m, u4 val) {
     u4 config = m->config;
     u4 ops = 0;
     u4 ent_count = 0;
-    sl_mapping_t *ent_list = NULL;
+    sl_mapping_t ent_list[MPU_MAX_MAPPINGS];
 
     if (val & MPU_CONFIG_ENABLE)
         config |= MPU_CONFIG_ENABLE;
@@ -87,15 +108,15 @@ static int update_config(sled_mpu_t *m, u4 val) {
         config &= ~MPU_CONFIG_ENABLE;
 
     if (val & MPU_CONFIG_APPLY) {
-        ent_list = calloc(MPU_MAX_MAPPINGS, sizeof(sl_mapping_t));
-        if (ent_list == NULL) return SL_ERR_MEM;
         sl_mapper_t *next = sl_mapper_get_next(m->mapper);
         for (int i = 0; i < MPU_MAX_MAPPINGS; i++) {
             if (m->map_len[i] == 0) continue;
             sl_mapping_t *ent = &ent_list[ent_count];
+            memset(ent, 0, sizeof(*ent));
             ent->input_base = m->va_base[i];
             ent->length = m->map_len[i];
             ent->output_base = m->pa_base[i];
+            ent->permissions = map_permissions(m->deny[i]);
             ent->type = SL_MAP_TYPE_MAPPER;
             ent->ep = sl_mapper_get_ep(next);
             ent_count++;
@@ -106,16 +127,15 @@ static int update_config(sled_mpu_t *m, u4 val) {
     if (config & MPU_CONFIG_ENABLE) ops |= SL_MAP_OP_MODE_TRANSLATE;
     else ops |= SL_MAP_OP_MODE_PASSTHROUGH;
 
-    // todo: add completion callback to update_async to delay updating config
-    if ((err = sl_device_update_mapper_async(m->dev, ops, ent_count, ent_list))) goto out_err;
+    if ((err = sl_mapper_update(m->mapper, ops, ent_count, ent_list))) return err;
+    if (ops & SL_MAP_OP_REPLACE) {
+        memcpy(m->applied, ent_list, ent_count * sizeof(sl_mapping_t));
+        m->applied_count = ent_count;
+    }
 
     if (val & MPU_CONFIG_CLEAR) clear_entries(m);
     m->config = config;
     return 0;
-
-out_err:
-    free(ent_list);
-    return err;
 }
 
 static int mpu_write(void *ctx, u8 addr, u4 size, u4 count, void *buf) {
@@ -160,12 +180,45 @@ static int mpu_write(void *ctx, u8 addr, u4 size, u4 count, void *buf) {
         m->map_len[index] = val;
         goto out;
     }
+    if ((addr >= MPU_REG_MAP_DENY(0)) && (addr < MPU_REG_MAP_DENY(MPU_MAX_MAPPINGS))) {
+        const u4 index = (addr - MPU_REG_MAP_DENY(0)) >> 2;
+        m->deny[index] = val & (MPU_DENY_READ | MPU_DENY_WRITE | MPU_DENY_EXEC);
+        goto out;
+    }
     err = SL_ERR_IO_INVALID;
 out:
     sl_device_unlock(m->dev);
     return err;
 }
 
+// the saved state is everything from the registers on
+#define MPU_STATE_LEN   (sizeof(sled_mpu_t) - offsetof(sled_mpu_t, config))
+
+static int sled_mpu_save(sl_dev_t *d, void **state_out, usize *len_out) {
+    sled_mpu_t *m = sl_device_get_context(d);
+    void *s = malloc(MPU_STATE_LEN);
+    if (s == NULL) return SL_ERR_MEM;
+    sl_device_lock(m->dev);
+    memcpy(s, &m->config, MPU_STATE_LEN);
+    sl_device_unlock(m->dev);
+    *state_out = s;
+    *len_out = MPU_STATE_LEN;
+    return 0;
+}
+
+static int sled_mpu_restore(sl_dev_t *d, const void *state, usize len) {
+    sled_mpu_t *m = sl_device_get_context(d);
+    if (len != MPU_STATE_LEN) return SL_ERR_ARG;
+    sl_device_lock(m->dev);
+    memcpy(&m->config, state, MPU_STATE_LEN);
+    u4 ops = SL_MAP_OP_REPLACE;
+    if (m->config & MPU_CONFIG_ENABLE) ops |= SL_MAP_OP_MODE_TRANSLATE;
+    else ops |= SL_MAP_OP_MODE_PASSTHROUGH;
+    int err = sl_mapper_update(m->mapper, ops, m->applied_count, m->applied);
+    sl_device_unlock(m->dev);
+    return err;
+}
+
 static void sled_mpu_destroy(sl_dev_t *d) {
     sled_mpu_t *m = sl_device_get_context(d);
     sl_mapper_destroy(m->mapper);
@@ -181,12 +234,13 @@ static int sled_mpu_create(sl_dev_t *d, sl_dev_config_t *cfg) {
 
     m->dev = d;
     cfg->aperture = MPU_APERTURE_LENGTH;
+    if ((err = sl_mapper_set_mode(m->mapper, SL_MAP_OP_MODE_PASSTHROUGH))) goto out_err;
     sl_device_set_context(m->dev, m);
-    sl_mapper_set_mode(m->mapper, SL_MAP_OP_MODE_PASSTHROUGH);
     sl_device_set_mapper(m->dev, m->mapper);
     return 0;
 
 out_err:
+    sl_mapper_destroy(m->mapper);
     free(m);
     return err;
 }
@@ -197,6 +251,8 @@ static const sl_dev_ops_t mpu_ops = {
     .write = mpu_write,
     .create = sled_mpu_create,
     .destroy = sled_mpu_destroy,
+    .save = sled_mpu_save,
+    .restore = sled_mpu_restore,
 };
 
 DECLARE_DEVICE(sled_mpu, SL_DEV_MPU, &mpu_ops);
@@ -226,6 +226,76 @@ out:
     return err;
 }
 
+typedef struct {
+    u4 config;
+    u4 status;
+    u4 scalar;
+    u4 num_units;
+    u4 irq_enabled;
+    u4 irq_active;
+    struct {
+        u4 config;
+        u8 reset_val;
+        u8 count;
+    } unit[TIMER_MAX_UNITS];
+} timer_state_t;
+
+static int sled_timer_save(sl_dev_t *d, void **state_out, usize *len_out) {
+    sled_timer_t *t = sl_device_get_context(d);
+    timer_state_t *s = malloc(sizeof(*s));
+    if (s == NULL) return SL_ERR_MEM;
+    sl_irq_mux_t *m = sl_device_get_irq_mux(t->dev);
+
+    sl_device_lock(t->dev);
+    s->config = t->config;
+    s->status = t->status;
+    s->scalar = t->scalar;
+    s->num_units = t->num_units;
+    s->irq_enabled = sl_irq_mux_get_enabled(m);
+    s->irq_active = sl_irq_mux_get_active(m);
+    for (int i = 0; i < TIMER_MAX_UNITS; i++) {
+        s->unit[i].config = t->unit[i].config;
+        s->unit[i].reset_val = t->unit[i].reset_val;
+        s->unit[i].count = t->unit[i].count;
+    }
+    sl_device_unlock(t->dev);
+    *state_out = s;
+    *len_out = sizeof(*s);
+    return 0;
+}
+
+// Units that were running start a full period over, the time left in the
+// period isn't kept.
+static int sled_timer_restore(sl_dev_t *d, const void *state, usize len) {
+    sled_timer_t *t = sl_device_get_context(d);
+    const timer_state_t *s = state;
+    if (len != sizeof(*s)) return SL_ERR_ARG;
+    sl_irq_mux_t *m = sl_device_get_irq_mux(t->dev);
+    int err = 0;
+
+    sl_device_lock(t->dev);
+    t->config = s->config;
+    t->status = s->status;
+    t->scalar = s->scalar;
+    t->num_units = s->num_units;
+    sl_irq_mux_set_enabled(m, s->irq_enabled);
+    sl_irq_mux_set_active(m, s->irq_active);
+    for (int i = 0; i < TIMER_MAX_UNITS; i++) {
+        sled_timer_unit_t *u = &t->unit[i];
+        if (u->config & TIMER_UNIT_CONFIG_RUN)
+            sl_chrono_timer_cancel(t->chrono, u->tid);
+        u->config = s->unit[i].config;
+        u->reset_val = s->unit[i].reset_val;
+        u->count = s->unit[i].count;
+        if (u->config & TIMER_UNIT_CONFIG_RUN) {
+            if (err == 0) err = sl_chrono_timer_set(t->chrono, u->reset_val, timer_callback, u, &u->tid);
+            if (err) u->config &= ~TIMER_UNIT_CONFIG_RUN;
+        }
+    }
+    sl_device_unlock(t->dev);
+    return err;
+}
+
 static void sled_timer_destroy(sl_dev_t *d) {
     sled_timer_t *t = sl_device_get_context(d);
     free(t);
@@ -251,6 +321,8 @@ static const sl_dev_ops_t timer_ops = {
     .write = timer_write,
     .create = sled_timer_create,
     .destroy = sled_timer_destroy,
+    .save = sled_timer_save,
+    .restore = sled_timer_restore,
 };
 
 DECLARE_DEVICE(sled_timer, SL_DEV_TIMER, &timer_ops);
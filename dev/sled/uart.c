@@ -1,8 +1,10 @@
 // SPDX-License-Identifier: MIT License
 // Copyright (c) 2022-2024 Shac Ron and The Sled Project
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <device/sled/sled.h>
@@ -120,6 +122,31 @@ static void sled_uart_destroy(sl_dev_t *d) {
     free(u);
 }
 
+// the saved state is everything from the registers on
+#define UART_STATE_LEN  (sizeof(sled_uart_t) - offsetof(sled_uart_t, config))
+
+static int sled_uart_save(sl_dev_t *d, void **state_out, usize *len_out) {
+    sled_uart_t *u = sl_device_get_context(d);
+    void *s = malloc(UART_STATE_LEN);
+    if (s == NULL) return SL_ERR_MEM;
+    sl_device_lock(u->dev);
+    memcpy(s, &u->config, UART_STATE_LEN);
+    sl_device_unlock(u->dev);
+    *state_out = s;
+    *len_out = UART_STATE_LEN;
+    return 0;
+}
+
+// output buffered since the snapshot is dropped with the rest of that run
+static int sled_uart_restore(sl_dev_t *d, const void *state, usize len) {
+    sled_uart_t *u = sl_device_get_context(d);
+    if (len != UART_STATE_LEN) return SL_ERR_ARG;
+    sl_device_lock(u->dev);
+    memcpy(&u->config, state, UART_STATE_LEN);
+    sl_device_unlock(u->dev);
+    return 0;
+}
+
 static int sled_uart_create(sl_dev_t *d, sl_dev_config_t *cfg) {
     sled_uart_t *u = calloc(1, sizeof(sled_uart_t));
     if (u == NULL) return SL_ERR_MEM;
@@ -137,6 +164,8 @@ static const sl_dev_ops_t uart_ops = {
     .write = uart_write,
     .create = sled_uart_create,
     .destroy = sled_uart_destroy,
+    .save = sled_uart_save,
+    .restore = sled_uart_restore,
 };
 
 DECLARE_DEVICE(sled_uart, SL_DEV_UART, &uart_ops);
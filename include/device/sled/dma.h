@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT License
+// Copyright (c) 2025 Shac Ron and The Sled Project
+
+#pragma once
+
+// Sled DMA controller
+
+// This device copies memory on the bus without involving a core. Each channel
+// runs a chain of descriptors in memory and raises its interrupt when the
+// chain is finished or a descriptor fails. Channels run on a worker thread
+// of their own, concurrently with the cores.
+
+// Writes into memory are logged on the bus. A core resets any instructions
+// it decoded from the written range the next time it polls for events or
+// accesses a device, so guests copying code see it without further syncing.
+
+#define DMA_MAX_CHANNELS                8
+
+#define DMA_REG_DEV_TYPE                0x0  // RO
+#define DMA_REG_DEV_VERSION             0x4  // RO
+#define DMA_REG_CONFIG                  0x8  // RW
+#define DMA_REG_NUM_CHANNELS            0xc  // RO
+// IRQ mask bitfield for each channel
+// Writing 1 masks interrupt. 0 enables interrupt to proceed.
+// Default value: all masked
+#define DMA_IRQ_MASK                    0x10 // RW
+// IRQ status bitfield for each channel. Writing 1 clears a set bit, 0 retains it.
+#define DMA_IRQ_STATUS                  0x14 // RW
+
+// Configuration register for channel i
+#define DMA_REG_CHAN_CONFIG(i)          (0x20 + (0x20 * i))  // RW
+
+// Bus address of the first descriptor of the chain
+#define DMA_REG_CHAN_DESC_LO(i)         (0x24 + (0x20 * i))  // RW
+#define DMA_REG_CHAN_DESC_HI(i)         (0x28 + (0x20 * i))  // RW
+
+// Bus address of the descriptor being run, 0 when the channel is idle
+#define DMA_REG_CHAN_CURRENT_LO(i)      (0x2c + (0x20 * i))  // RO
+#define DMA_REG_CHAN_CURRENT_HI(i)      (0x30 + (0x20 * i))  // RO
+
+// Error code (SL_ERR_*) of the descriptor that failed, 0 if none
+#define DMA_REG_CHAN_ERROR(i)           (0x34 + (0x20 * i))  // RO
+
+#define DMA_APERTURE_LENGTH             (0x20 + (0x20 * DMA_MAX_CHANNELS))
+
+
+// DMA_REG_CHAN_CONFIG
+
+// Run channel.
+// Setting this bit starts the chain at the descriptor register and clears
+// the done and error bits. If the channel was already running, no effect is
+// observed. Clearing this bit stops the channel after the copy in progress.
+// Cleared by the channel when the chain ends.
+#define DMA_CHAN_CONFIG_RUN             (1u << 0)
+
+// Chain completed.
+// Set when the last descriptor of the chain is finished.
+// Write 1 to clear, 0 to retain current value.
+#define DMA_CHAN_CONFIG_DONE            (1u << 1)
+
+// Chain failed.
+// Set when a descriptor can't be read or copied, the channel stops at that
+// descriptor. Write 1 to clear, 0 to retain current value.
+#define DMA_CHAN_CONFIG_ERROR           (1u << 2)
+
+
+// Descriptors are 8 byte aligned and made of little endian 64 bit words.
+// A next address of 0 ends the chain. Source and destination ranges of a
+// descriptor should not overlap.
+
+#define DMA_DESC_SRC                    0x0
+#define DMA_DESC_DST                    0x8
+#define DMA_DESC_LEN                    0x10
+#define DMA_DESC_NEXT                   0x18
+#define DMA_DESC_SIZE                   0x20
@@ -15,4 +15,11 @@
 // Default value: 0xffffffff
 #define INTC_REG_MASK           0xc  // RW
 
-#define INTC_APERTURE_LENGTH    0x10
+#define INTC_MAX_HARTS          8
+
+// interrupts routed to hart i. The hart's external interrupt is raised
+// while any of these are asserted and unmasked.
+// Default value: 0xffffffff for hart 0, 0 for the others
+#define INTC_REG_TARGET(i)      (0x10 + (4 * i))  // RW
+
+#define INTC_APERTURE_LENGTH    (0x10 + (4 * INTC_MAX_HARTS))
@@ -15,8 +15,9 @@
 #define MPU_REG_MAP_PA_BASE_LO(i)   (0x300 + (8 * i))   // RW
 #define MPU_REG_MAP_PA_BASE_HI(i)   (0x304 + (8 * i))   // RW
 #define MPU_REG_MAP_LEN(i)          (0x500 + (4 * i))   // RW
+#define MPU_REG_MAP_DENY(i)         (0x600 + (4 * i))   // RW
 
-#define MPU_APERTURE_LENGTH         0x600
+#define MPU_APERTURE_LENGTH         0x700
 
 
 // MPU_REG_CONFIG
@@ -51,3 +52,11 @@
 
 // MPU_REG_MAP_LEN
 // Length in bytes of the mapped region.
+
+// MPU_REG_MAP_DENY
+// Accesses refused in the mapped region. 0 allows every access.
+// The core applying a change sees it right away, other cores at their next
+// event poll.
+#define MPU_DENY_READ               (1u << 0)
+#define MPU_DENY_WRITE              (1u << 1)
+#define MPU_DENY_EXEC               (1u << 2)
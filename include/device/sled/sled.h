@@ -24,6 +24,8 @@ int sled_uart_set_channel(sl_dev_t *d, int io, int fd_in, int fd_out);
 sl_irq_ep_t * sled_intc_get_irq_ep(sl_dev_t *d);
 // map interrupts generated by 'src' to intc bit 'num'
 int sled_intc_set_input(sl_dev_t *intc, sl_dev_t *src, u4 num);
+// signal the interrupts routed to 'hart' on irq 'num' of 'ep'
+int sled_intc_set_target(sl_dev_t *intc, u4 hart, sl_irq_ep_t *ep, u4 num);
 
 #ifdef __cplusplus
 }
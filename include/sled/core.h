@@ -32,6 +32,13 @@ extern "C" {
 #define SL_CORE_OPT_ENDIAN_LITTLE          (1u << 30)
 #define SL_CORE_OPT_ENDIAN_BIG             (1u << 31)
 
+// Cache geometry. Fields left zero use the default.
+struct sl_cache_geometry {
+    u4 sets;            // number of sets, a power of two
+    u1 ways;            // pages per set: 1, 2, 4 or 8
+    u1 page_shift;      // log2 of the page size
+};
+
 struct sl_core_params {
     u1 arch;
     u1 subarch;
@@ -40,6 +47,10 @@ struct sl_core_params {
     u4 arch_options;
     const char *name;
     sl_bus_t *bus;
+    u4 poll_budget;     // max instructions between event checks, 0 for default
+    sl_cache_geometry_t icache; // only used when the core is created
+    sl_cache_geometry_t dcache; // only used when the core is created
+    u8 decode_budget;   // bytes of decoded instructions kept, 0 for default, only used when the core is created
 };
 
 // Special register defines to pass to set/get_reg()
@@ -98,7 +109,15 @@ int sl_core_mem_read(sl_core_t *c, u8 addr, u4 size, u4 count, void *buf);
 int sl_core_mem_write(sl_core_t *c, u8 addr, u4 size, u4 count, void *buf);
 int sl_core_mem_atomic(sl_core_t *c, u8 addr, u4 size, u1 aop, u8 arg0, u8 arg1, u8 *result, u1 ord, u1 ord_fail);
 u8 sl_core_get_cycles(sl_core_t *c);
+// Put the mapper of device d in front of the mappers of core c, and deliver
+// the device's events on the core's worker. Returns the event endpoint id of
+// the device, or an error if its mapper is already in use.
 int sl_core_set_mapper(sl_core_t *c, sl_dev_t *d);
+// Put the mapper of device d, already set on another core with
+// sl_core_set_mapper, in front of the mappers of core c too. The mappers of
+// both cores must have been the same. The device's events stay with the
+// first core.
+int sl_core_share_mapper(sl_core_t *c, sl_dev_t *d);
 void sl_core_dump_state(sl_core_t *c);
 void sl_core_set_mode(sl_core_t *c, u1 mode);
 
@@ -20,6 +20,7 @@ extern "C" {
 #define SL_DEV_SLED_INTC         130
 #define SL_DEV_SLED_MPU          131
 #define SL_DEV_SLED_TIMER        132
+#define SL_DEV_SLED_DMA          133
 
 // user-defined devices
 #define SL_DEV_RESERVED     1024
@@ -50,6 +51,14 @@ struct sl_dev_ops {
     int (*create)(sl_dev_t *d, sl_dev_config_t *cfg);
     // destroy driver-specific context
     void (*destroy)(sl_dev_t *d);
+    // save driver state for a machine snapshot into a buffer freed by the caller,
+    // NULL if the device keeps no state
+    int (*save)(sl_dev_t *d, void **state_out, usize *len_out);
+    // restore driver state from a buffer made by save
+    int (*restore)(sl_dev_t *d, const void *state, usize len);
+    // stop accessing guest memory until resume, around a machine snapshot or restore
+    void (*pause)(sl_dev_t *d);
+    void (*resume)(sl_dev_t *d);
 };
 
 // allocate and call ops->create()
@@ -24,6 +24,7 @@ ssize_t sl_elf_symbol_length(sl_elf_obj_t *obj, const char *name);
 ssize_t sl_elf_read_symbol(sl_elf_obj_t *obj, const char *name, void *buf, usize buflen);
 void *sl_elf_get_program_header(sl_elf_obj_t *obj, u4 index);
 void *sl_elf_pointer_for_offset(sl_elf_obj_t *obj, u8 offset);
+int sl_elf_get_fd(sl_elf_obj_t *obj);
 void sl_elf_close(sl_elf_obj_t *obj);
 
 #ifdef __cplusplus
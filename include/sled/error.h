@@ -49,6 +49,7 @@ extern "C" {
 // SLAC errors
 #define SL_ERR_SLAC_UNDECODED   -50 // decoder not yet done
 #define SL_ERR_SLAC_INVALID     -51 // invalid instruction format
+#define SL_ERR_SLAC_SPLIT       -52 // fused instruction must be run unfused
 
 const char *st_err(int err);
 
@@ -34,6 +34,7 @@ typedef struct sl_io_port sl_io_port_t;
 // On successful return:
 //  arg[0] will contain the host machine pointer to the data
 //  arg[1] will contain the length of the data
+//  arg[2] has the SL_MAP_PERM_* bits cleared that a mapper on the way denies
 
 struct sl_io_op {
     u8 addr;   // bus address of target data
@@ -49,7 +50,7 @@ struct sl_io_op {
     };
     union {
         void *buf;          // io buffer, used for IN, OUT
-        u8 arg[2];         // arg[0] used for all atomics, arg[1] for IO_OP_ATOMIC_CAS
+        u8 arg[3];         // arg[0] used for all atomics, arg[1] for IO_OP_ATOMIC_CAS
     };
     void *agent;            // io source, used for permission checking and attribution
 };
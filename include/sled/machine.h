@@ -12,7 +12,9 @@ extern "C" {
 
 int sl_machine_create(sl_machine_t **m_out);
 
-int sl_machine_add_core(sl_machine_t *m, sl_core_params_t *opts);
+// Cores are added in hart id order, so opts->id has to be the number of cores
+// already added. The parameters are copied.
+int sl_machine_add_core(sl_machine_t *m, const sl_core_params_t *opts);
 int sl_machine_add_device(sl_machine_t *m, u4 type, u8 base, const char *name);
 int sl_machine_add_device_prefab(sl_machine_t *m, u8 base, sl_dev_t *d);
 int sl_machine_add_mem(sl_machine_t *m, u8 base, u8 size);
@@ -22,14 +24,48 @@ int sl_machine_create_device(sl_machine_t *m, u4 type, const char *name, sl_dev_
 
 int sl_machine_load_core(sl_machine_t *m, u4 id, sl_elf_obj_t *obj, bool configure);
 int sl_machine_load_core_raw(sl_machine_t *m, u4 id, u8 addr, void *buf, u8 size);
+// Set the architecture options and entry point of a core from obj without
+// loading it, for cores running an image another core loaded.
+int sl_machine_configure_core(sl_machine_t *m, u4 id, sl_elf_obj_t *obj);
 
 sl_dev_t * sl_machine_get_device_for_name(sl_machine_t *m, const char *name);
 sl_core_t * sl_machine_get_core(sl_machine_t *m, u4 id);
 int sl_machine_set_interrupt(sl_machine_t *m, u4 irq, bool high);
 sl_chrono_t * sl_machine_get_chrono(sl_machine_t *m);
+// Mapper of the system bus, for devices that access memory themselves
+sl_mapper_t * sl_machine_get_mapper(sl_machine_t *m);
 
 void sl_machine_destroy(sl_machine_t *m);
 
+// Cores are numbered in the order they are added, which is also their hart
+// id. Each core can run on a worker thread of its own, sharing memory and
+// devices with the others.
+
+// Start a thread for every core and set the cores running.
+int sl_machine_start(sl_machine_t *m);
+// Wait until a core stops, returning its run status and its id in id_out.
+// Later calls return the same core.
+int sl_machine_wait(sl_machine_t *m, u4 *id_out);
+// Tell the cores that are still running to exit.
+void sl_machine_stop(sl_machine_t *m);
+// Wait for all core threads to exit.
+int sl_machine_join(sl_machine_t *m);
+
+// Snapshots hold the RAM, core and device state of a machine whose cores are
+// stopped. RAM is shared copy-on-write with the snapshot, so taking one costs
+// one copy of the memory in use and restoring one costs a remap. A snapshot
+// can be restored into the machine it came from or into a machine built the
+// same way, which clones it.
+//
+// Both return SL_ERR_BUSY while a core thread is running, and restore returns
+// SL_ERR_ARG for a snapshot of a machine laid out differently, leaving the
+// machine untouched. Restore can still fail after that on a host error, such
+// as running out of memory or file descriptors. The machine then holds a mix
+// of old and restored state, and has to be restored again or destroyed.
+int sl_machine_snapshot(sl_machine_t *m, sl_snapshot_t **snap_out);
+int sl_machine_restore(sl_machine_t *m, sl_snapshot_t *snap);
+void sl_snapshot_destroy(sl_snapshot_t *snap);
+
 #ifdef __cplusplus
 }
 #endif
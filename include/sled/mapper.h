@@ -41,12 +41,20 @@ extern "C" {
 
 #define SL_MAP_OP_REPLACE           (1u << 2)
 
+// Mapping permissions. Accesses through a mapping are checked against its
+// permissions, so a mapping must set every one it allows. A mapping with no
+// permissions refuses all access.
+#define SL_MAP_PERM_READ            (1u << 0)
+#define SL_MAP_PERM_WRITE           (1u << 1)
+#define SL_MAP_PERM_EXEC            (1u << 2)
+#define SL_MAP_PERM_ALL             (SL_MAP_PERM_READ | SL_MAP_PERM_WRITE | SL_MAP_PERM_EXEC)
+
 struct sl_mapping {
     u8 input_base;
     u8 length;
     u8 output_base;
     u4 domain;
-    u2 permissions;
+    u2 permissions; // SL_MAP_PERM_* allowed, 0 denies all access
     u1 type;
     sl_map_ep_t *ep;
 };
@@ -60,13 +68,26 @@ struct sl_map_ep {
 int sl_mapper_create(sl_mapper_t **map_out);
 void sl_mapper_destroy(sl_mapper_t *m);
 
-void sl_mapper_set_mode(sl_mapper_t *m, int mode);
+int sl_mapper_set_mode(sl_mapper_t *m, int mode);
 int sl_mappper_add_mapping(sl_mapper_t *m, sl_mapping_t *ent);
+
+// Set the mode in ops and replace the mappings with ent_list if ops has
+// SL_MAP_OP_REPLACE, otherwise add to them. May be called from any thread.
+// Lookups already in progress finish with the mappings they started with.
+int sl_mapper_update(sl_mapper_t *m, u4 ops, u4 count, sl_mapping_t *ent_list);
 int sl_mapper_io(void *ctx, sl_io_op_t *op);
 sl_mapper_t * sl_mapper_get_next(sl_mapper_t *m);
 sl_map_ep_t * sl_mapper_get_ep(sl_mapper_t *m);
 
-resultptr_t sl_mapper_resolve(sl_mapper_t *m, u8 addr, u8 *len_out);
+// Find the host memory at addr. perm_out gets the permissions of every mapping
+// on the way to it.
+resultptr_t sl_mapper_resolve(sl_mapper_t *m, u8 addr, u8 *len_out, u2 *perm_out);
+
+// Log a write made to host memory from sl_mapper_resolve by something other
+// than a core, such as a DMA transfer, so cores reset any code they decoded
+// from it. Cores see the writes logged on their bus mapper when they next poll
+// for events or access a device. May be called from any thread.
+void sl_mapper_log_write(sl_mapper_t *m, void *buf, u8 len);
 
 #ifdef __cplusplus
 }
@@ -10,6 +10,7 @@ extern "C" {
 #endif
 
 #define SLAC_REG_DISCARD    0xff
+#define SLAC_REG_PC         0xfe    // base register is the instruction address
 
 #define SLAC_OP(type, func) (((type) << 10) | (func))
 #define SLAC_TYPE(op) (op >> 10)
@@ -96,6 +97,7 @@ extern "C" {
 #define SLAC_FUNC_DIV          0x011   // divide (unsigned * unsigned)
 #define SLAC_FUNC_MODS         0x012   // mod (signed * signed)
 #define SLAC_FUNC_MOD          0x013   // mod (unsigned * unsigned)
+#define SLAC_FUNC_ZEXT         0x014   // zero extend, clearing the top imm bits
 
 
 // load store
@@ -166,6 +168,14 @@ extern "C" {
 #define SLAC_FUNC_FLD           0x01e   // load float
 #define SLAC_FUNC_FST           0x01f   // store float
 
+// fp rounding modes
+#define SLAC_RM_NEAREST         0   // to nearest, ties to even
+#define SLAC_RM_ZERO            1   // towards zero
+#define SLAC_RM_DOWN            2   // towards -infinity
+#define SLAC_RM_UP              3   // towards +infinity
+#define SLAC_RM_MAX_MAG         4   // to nearest, ties to max magnitude
+#define SLAC_RM_DYN             7   // from the core's rounding mode
+
 // vec
 
 // simd
@@ -198,6 +208,10 @@ extern "C" {
 #define SLAC_FUNC_CSROR        0x009   // csr or
 #define SLAC_FUNC_CSRCLR       0x00a   // csr clear
 
+#define SLAC_FUNC_SYSCALL      0x00b   // system call exception
+#define SLAC_FUNC_ERET         0x00c   // exception return, imm = exception level returning from
+#define SLAC_FUNC_WFI          0x00d   // wait for interrupt, imm = lowest allowed exception level
+
 #define SLAC_FUNC_NOP          0x3fd   // nop
 #define SLAC_FUNC_UNDEF        0x3fe   // undefined instruction
 #define SLAC_FUNC_INVALID      0x3ff   // invalid instruction
@@ -349,6 +363,10 @@ extern "C" {
 #define SLAC_OP_CSROR   SLAC_OP(SLAC_TYPE_SYS, SLAC_FUNC_CSROR)      // csr or
 #define SLAC_OP_CSRCLR  SLAC_OP(SLAC_TYPE_SYS, SLAC_FUNC_CSRCLR)     // csr clear
 
+#define SLAC_OP_SYSCALL SLAC_OP(SLAC_TYPE_SYS, SLAC_FUNC_SYSCALL)    // system call
+#define SLAC_OP_ERET    SLAC_OP(SLAC_TYPE_SYS, SLAC_FUNC_ERET)       // exception return
+#define SLAC_OP_WFI     SLAC_OP(SLAC_TYPE_SYS, SLAC_FUNC_WFI)        // wait for interrupt
+
 #define SLAC_OP_NOP     SLAC_OP(SLAC_TYPE_SYS, SLAC_FUNC_NOP)        // nop
 #define SLAC_OP_UNDEF   SLAC_OP(SLAC_TYPE_SYS, SLAC_FUNC_UNDEF)      // undefined instruction
 #define SLAC_OP_INVALID SLAC_OP(SLAC_TYPE_SYS, SLAC_FUNC_INVALID)    // invalid instruction
@@ -356,36 +374,47 @@ extern "C" {
 int slac4_dispatch(sl_core_t *c, sl_slac_inst_t *si);
 int slac8_dispatch(sl_core_t *c, sl_slac_inst_t *si);
 
+// set si->exec to the handler for a decoded instruction
+void slac4_bind(sl_slac_inst_t *si);
+void slac8_bind(sl_slac_inst_t *si);
+
 #if SLAC_TRACE
 
 #define SLAC_BUF_LEN    80
 
 #define STRACE_DECL_OPSTR const char *opstr_
 #define STRACE_OPSTR(s) do { opstr_ = s; } while (0)
-#define STRACE_FORMAT(si, f) si->desc.print_format = f
-#define STRACE(si, ...) \
+#define STRACE_FORMAT(d, f) (d)->print_format = f
+#define STRACE(d, ...) \
     do { \
-        si->desc.len += snprintf(si->desc.s + si->desc.len, SLAC_BUF_LEN - si->desc.len, __VA_ARGS__); \
+        (d)->len += snprintf((d)->s + (d)->len, SLAC_BUF_LEN - (d)->len, __VA_ARGS__); \
     } while (0)
 
 #else
 
 #define STRACE_DECL_OPSTR
 #define STRACE_OPSTR(s)
-#define STRACE_FORMAT(si, f)
-#define STRACE(si, ...)
+#define STRACE_FORMAT(d, f)
+#define STRACE(d, ...)
 
 #endif
 
-struct sl_slac_desc {
-    u4 machine_op;      // native instruction encoding
-
 #if SLAC_TRACE
+// Trace description of a decoded instruction. These are large, so they are
+// kept apart from the decoded instructions.
+struct sl_slac_desc {
     u4 print_format;
     int len;
-    char s[80];
-#endif
+    char s[SLAC_BUF_LEN];
 };
+#endif
+
+// Decoded instructions are kept for every halfword of cached code, so a slot
+// holds only what running it and finding its block needs, in 16 bytes. The
+// handler is an index into slac_exec_table. Immediates are kept in 4 bytes and
+// sign extended when read: decoded instructions never need more, and fused
+// pairs that would are left unfused. The machine op is read from guest memory
+// when it is needed.
 
 struct sl_slac_inst {
     union {
@@ -398,7 +427,9 @@ struct sl_slac_inst {
             u4 len    : 3;  // length of operands
             u4 sx8    : 1;  // sign extend to u8
             u4 sh     : 1;  // short instruction encoding (16 bit)
-            u4 _unused: 6;  //
+            u4 fused  : 2;  // halfwords of the following instruction folded into this one
+            u4 rm     : 3;  // fp rounding mode
+            u4 _unused: 1;  //
         };
     };
 
@@ -406,15 +437,35 @@ struct sl_slac_inst {
     u1 r0;
     u1 r1;
     u1 r2;          // for jump and link instructions, contains pc offset
+                    // for atomics, contains the SLAC_IN_LEN_* memory operand size
 
-    union {
-        u8 uimm;
-        i8 simm;
-    };
+    i4 imm;
 
-    sl_slac_desc_t desc;
+    u1 exec;        // handler, bound after decode
+    u1 fill;        // icache page fill this slot was reset for
+    u1 blen;        // instructions from here to the end of the decoded block, 0 if unbuilt
+    u1 heat;        // times the block starting here was interpreted, jit only
 };
 
+typedef int (*sl_slac_exec_t)(sl_core_t *c, sl_slac_inst_t *si);
+
+// handlers of decoded instructions, indexed by exec
+extern const sl_slac_exec_t slac_exec_table[];
+
+static inline int slac_exec(sl_core_t *c, sl_slac_inst_t *si) {
+    return slac_exec_table[si->exec](c, si);
+}
+
+// bytes of guest code covered by a decoded instruction
+static inline u1 slac_inst_len(const sl_slac_inst_t *si) {
+    return (si->sh ? 2 : 4) + (si->fused * 2);
+}
+
+// guest instructions retired by a decoded instruction
+static inline u1 slac_inst_count(const sl_slac_inst_t *si) {
+    return si->fused ? 2 : 1;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -30,6 +30,7 @@ typedef intptr_t iptr;
 typedef uintptr_t uptr;
 
 typedef struct sl_bus sl_bus_t;
+typedef struct sl_cache_geometry sl_cache_geometry_t;
 typedef struct sl_core sl_core_t;
 typedef struct sl_core_params sl_core_params_t;
 typedef struct sl_dev sl_dev_t;
@@ -51,6 +52,7 @@ typedef struct sl_map_ep sl_map_ep_t;
 typedef struct sl_mapper sl_mapper_t;
 typedef struct sl_mapping sl_mapping_t;
 typedef struct sl_reg_view sl_reg_view_t;
+typedef struct sl_snapshot sl_snapshot_t;
 typedef struct sl_slac_desc sl_slac_desc_t;
 typedef struct sl_slac_inst sl_slac_inst_t;
 typedef union sl_slac_opcode sl_slac_opcode_t;
@@ -8,4 +8,5 @@ $(PLAT)_DEVICES := \
 	sled_intc \
 	sled_mpu \
 	sled_timer \
+	sled_dma \
 
@@ -13,6 +13,7 @@
 // map of interrupt vectors to devices in intc
 #define PLAT_INTC_TIMER_IRQ_BIT     0
 #define PLAT_INTC_UART_IRQ_BIT      1
+#define PLAT_INTC_DMA_IRQ_BIT       2
 
 #define WITH_UART 1
 #define PLAT_UART_BASE      0x5000000
@@ -20,3 +21,4 @@
 #define PLAT_RTC_BASE       0x5020000
 #define PLAT_MPU_BASE       0x5030000
 #define PLAT_TIMER_BASE     0x5040000
+#define PLAT_DMA_BASE       0x5050000